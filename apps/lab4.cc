@@ -107,7 +107,8 @@ class NetworkInterfaceAdapter : public TCPOverIPv4Adapter {
         return {};
     }
     void write(TCPSegment &seg) {
-        _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
+        seg.for_each_wire_segment(
+            [&](TCPSegment &piece) { _interface.send_datagram(wrap_tcp_in_ip(piece), _next_hop); });
         send_pending();
     }
     void tick(const size_t ms_since_last_tick) {
@@ -2,9 +2,11 @@
 
 #include <chrono>
 #include <cstdlib>
+#include <deque>
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <utility>
 
 using namespace std;
 using namespace std::chrono;
@@ -13,7 +15,8 @@ constexpr size_t len = 100 * 1024 * 1024;
 
 void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
     while (not x.segments_out().empty()) {
-        segments.emplace_back(move(x.segments_out().front()));
+        // super-segments are split into wire segments here, as an adapter would
+        x.segments_out().front().for_each_wire_segment([&](TCPSegment &seg) { segments.emplace_back(move(seg)); });
         x.segments_out().pop();
     }
     if (reorder) {
@@ -28,8 +31,12 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
     segments.clear();
 }
 
-void main_loop(const bool reorder) {
+void main_loop(const bool reorder,
+               const ByteStream::Storage recv_storage = ByteStream::Storage::Ring,
+               const bool gso = false) {
     TCPConfig config;
+    config.recv_storage = recv_storage;
+    config.gso = gso;
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -96,17 +103,98 @@ void main_loop(const bool reorder) {
 
     cout << fixed << setprecision(2);
     cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+         << " Gbit/s" << (recv_storage == ByteStream::Storage::Chunks ? " (zero-copy receive)" : "")
+         << (gso ? " (segmentation offload)" : "") << "\n";
 
     while (x.active() or y.active()) {
         loop();
     }
 }
 
+//! A 10 Gbit/s path with a 20 ms round trip, simulated one millisecond at a time
+constexpr uint64_t path_rate = 1250000;  // bytes per millisecond
+constexpr uint64_t path_delay = 10;      // milliseconds each way
+constexpr size_t path_len = 64 * 1024 * 1024;
+
+//! Transfer `path_len` bytes over the simulated path, with send and receive buffers of `capacity` bytes
+void path_loop(const size_t capacity, const bool window_scaling) {
+    TCPConfig config;
+    config.send_capacity = capacity;
+    config.recv_capacity = capacity;
+    config.window_scaling = window_scaling;
+    TCPConnection x{config}, y{config};
+
+    // segments in flight, with the time they arrive; x's segments are serialized onto the link one at a time
+    deque<pair<uint64_t, TCPSegment>> x_to_y, y_to_x;
+    uint64_t link_busy_until_ns = 0;
+    uint64_t now = 0;
+    size_t written = 0, received = 0;
+
+    // the application reads each segment's data as soon as it arrives, so the window stays open
+    const auto receive = [&](const TCPSegment &seg) {
+        y.segment_received(seg);
+        const auto available_output = y.inbound_stream().buffer_size();
+        y.inbound_stream().pop_output(available_output);
+        received += available_output;
+    };
+
+    const auto loop = [&] {
+        while (written < path_len and x.remaining_outbound_capacity()) {
+            written += x.write(string(min(x.remaining_outbound_capacity(), path_len - written), 'x'));
+        }
+        for (; not x.segments_out().empty(); x.segments_out().pop()) {
+            const uint64_t wire_size = x.segments_out().front().payload().size() + 40;
+            link_busy_until_ns = max(link_busy_until_ns, now * 1000000) + wire_size * 1000000 / path_rate;
+            x_to_y.emplace_back((link_busy_until_ns + 999999) / 1000000 + path_delay, move(x.segments_out().front()));
+        }
+        for (; not y.segments_out().empty(); y.segments_out().pop()) {
+            y_to_x.emplace_back(now + path_delay, move(y.segments_out().front()));
+        }
+
+        now++;
+        x.tick(1);
+        y.tick(1);
+        for (; not x_to_y.empty() and x_to_y.front().first <= now; x_to_y.pop_front()) {
+            receive(x_to_y.front().second);
+        }
+        for (; not y_to_x.empty() and y_to_x.front().first <= now; y_to_x.pop_front()) {
+            x.segment_received(y_to_x.front().second);
+        }
+    };
+
+    x.connect();
+    y.end_input_stream();
+    while (received < path_len) {
+        loop();
+    }
+    const uint64_t elapsed = now;
+
+    x.end_input_stream();
+    while (x.active() or y.active()) {
+        loop();
+    }
+
+    const auto megabits_per_second = path_len * 8.0 / double(elapsed * 1000);
+    cout << fixed << setprecision(1);
+    cout << "Path-limited throughput (10 Gbit/s, 20 ms RTT), " << setw(8) << capacity << "-byte buffers, "
+         << (window_scaling ? "window scaling   : " : "no window scaling: ") << megabits_per_second << " Mbit/s";
+    if (not window_scaling) {
+        // without scaling, at most 64 KiB can be in flight per round trip
+        const double window_limit = min(double(capacity), double(UINT16_MAX)) * 8 / double(2 * path_delay * 1000);
+        cout << " (the window allows " << window_limit << ")";
+    }
+    cout << "\n";
+}
+
 int main() {
     try {
         main_loop(false);
         main_loop(true);
+        main_loop(false, ByteStream::Storage::Chunks);
+        main_loop(false, ByteStream::Storage::Ring, true);
+        path_loop(TCPConfig::DEFAULT_CAPACITY, false);
+        path_loop(32 * 1024 * 1024, false);
+        path_loop(32 * 1024 * 1024, true);
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
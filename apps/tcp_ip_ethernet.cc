@@ -30,6 +30,9 @@ static void show_usage(const char *argv0, const char *msg) {
          << "\n\n"
 
          << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
+         << "   -m <mss>        Send and accept payloads of up to <mss> bytes   " << TCPConfig::MAX_PAYLOAD_SIZE << "\n"
+         << "                   (capped at what fits in one datagram on the link)\n"
+         << "   -P              Probe the path for a larger MSS, up to <mss>    (no probing)\n\n"
 
          << "   -d <tapdev>     Connect to tap <tapdev>                         " << TAP_DFLT << "\n\n"
 
@@ -80,6 +83,15 @@ static tuple<TCPConfig, FdAdapterConfig, Address, string> get_config(int argc, c
             c_fsm.recv_capacity = strtol(argv[curr + 1], nullptr, 0);
             curr += 2;
 
+        } else if (strncmp("-m", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -m requires one argument.");
+            c_fsm.mss = strtol(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-P", argv[curr], 3) == 0) {
+            c_fsm.mtu_probing = true;
+            curr += 1;
+
         } else if (strncmp("-t", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -t requires one argument.");
             c_fsm.rt_timeout = strtol(argv[curr + 1], nullptr, 0);
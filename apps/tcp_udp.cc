@@ -27,6 +27,14 @@ static void show_usage(const char *argv0, const char *msg) {
          << "\n\n"
 
          << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
+         << "   -m <mss>        Send and accept payloads of up to <mss> bytes   " << TCPConfig::MAX_PAYLOAD_SIZE << "\n"
+         << "                   (capped at what fits in one datagram on the link)\n"
+         << "   -P              Probe the path for a larger MSS, up to <mss>    (no probing)\n\n"
+
+         << "   -U              Read and write datagrams through io_uring       (poll and read/write)\n"
+         << "                   (falls back to epoll where io_uring is unavailable)\n"
+         << "   -G              Send super-segments with UDP GSO, receive       (a datagram per segment)\n"
+         << "                   with UDP GRO (not with -U)\n\n"
 
          << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
          << "   -Ld <loss>      Set downlink loss to <rate> (float in 0..1)     (no loss)\n\n"
@@ -63,6 +71,24 @@ static tuple<TCPConfig, FdAdapterConfig, bool> get_config(int argc, char **argv)
             c_fsm.recv_capacity = strtol(argv[curr + 1], nullptr, 0);
             curr += 2;
 
+        } else if (strncmp("-m", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -m requires one argument.");
+            c_fsm.mss = strtol(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-P", argv[curr], 3) == 0) {
+            c_fsm.mtu_probing = true;
+            curr += 1;
+
+        } else if (strncmp("-U", argv[curr], 3) == 0) {
+            c_filt.io_uring = true;
+            curr += 1;
+
+        } else if (strncmp("-G", argv[curr], 3) == 0) {
+            c_fsm.gso = true;
+            c_filt.udp_offload = true;
+            curr += 1;
+
         } else if (strncmp("-t", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -t requires one argument.");
             c_fsm.rt_timeout = strtol(argv[curr + 1], nullptr, 0);
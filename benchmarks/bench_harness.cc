@@ -0,0 +1,62 @@
+#include "bench_harness.hh"
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+using namespace std;
+
+namespace {
+atomic<uint64_t> allocations{0};
+
+void *counted_alloc(const size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    void *ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+}  // namespace
+
+// Count every heap allocation made through operator new (std::string, containers, make_shared...)
+void *operator new(size_t size) { return counted_alloc(size); }
+void *operator new[](size_t size) { return counted_alloc(size); }
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+uint64_t allocation_count() { return allocations.load(memory_order_relaxed); }
+
+BenchmarkSuite::BenchmarkSuite(const string &component, const int argc, const char *const argv[])
+    : _component(component), _min_time(chrono::milliseconds(argc > 1 ? atoi(argv[1]) : 200)) {}
+
+void BenchmarkSuite::record(const string &name,
+                            const uint64_t iterations,
+                            const chrono::nanoseconds elapsed,
+                            const uint64_t allocations_made,
+                            const size_t bytes_per_op) {
+    BenchResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.ns_per_op = double(elapsed.count()) / double(iterations);
+    result.bytes_per_second = bytes_per_op * 1e9 / result.ns_per_op;
+    result.allocs_per_op = double(allocations_made) / double(iterations);
+    _results.push_back(result);
+}
+
+void BenchmarkSuite::print_json(ostream &os) const {
+    const auto flags(os.flags());
+    os << fixed << setprecision(3);
+    os << "{\n  \"component\": \"" << _component << "\",\n  \"results\": [";
+    for (size_t i = 0; i < _results.size(); i++) {
+        const auto &r = _results[i];
+        os << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+           << ", \"ns_per_op\": " << r.ns_per_op << ", \"bytes_per_second\": " << r.bytes_per_second
+           << ", \"allocs_per_op\": " << r.allocs_per_op << "}";
+    }
+    os << "\n  ]\n}" << endl;
+    os.flags(flags);
+}
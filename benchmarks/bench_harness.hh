@@ -0,0 +1,82 @@
+#ifndef SPONGE_BENCHMARKS_BENCH_HARNESS_HH
+#define SPONGE_BENCHMARKS_BENCH_HARNESS_HH
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//! \brief Number of heap allocations (calls to operator new) made by this process so far
+uint64_t allocation_count();
+
+//! \brief Keep the compiler from optimizing away a value computed by a benchmark
+template <typename T>
+inline void do_not_optimize(const T &value) {
+    __asm__ __volatile__("" : : "g"(&value) : "memory");
+}
+
+//! \brief One measured microbenchmark
+struct BenchResult {
+    std::string name{};         //!< benchmark name, e.g. "write_read/ring/1500"
+    uint64_t iterations{};      //!< number of times the operation ran
+    double ns_per_op{};         //!< mean wall-clock time per operation
+    double bytes_per_second{};  //!< throughput, if the operation processes bytes (else 0)
+    double allocs_per_op{};     //!< mean heap allocations per operation
+};
+
+//! \brief Runs the microbenchmarks of one libsponge component and reports them as JSON
+//!
+//! Each operation is first run once to warm up, then repeatedly in batches of doubling
+//! size until a batch takes at least the minimum time (200 ms by default, or the number of
+//! milliseconds given as the first command-line argument).
+class BenchmarkSuite {
+  private:
+    std::string _component;
+    std::chrono::nanoseconds _min_time;
+    std::vector<BenchResult> _results{};
+
+  public:
+    //! \param[in] component name of the component under test (used in the JSON output)
+    //! \param[in] argc, argv the program's arguments (an optional minimum time per benchmark, in ms)
+    BenchmarkSuite(const std::string &component, const int argc, const char *const argv[]);
+
+    //! \brief Measure `op`, an operation that processes `bytes_per_op` bytes each time it runs
+    template <typename Operation>
+    void run(const std::string &name, Operation &&op, const size_t bytes_per_op = 0) {
+        using clock = std::chrono::steady_clock;
+        op();
+        for (uint64_t batch = 1;; batch *= 2) {
+            const uint64_t allocs_before = allocation_count();
+            const auto start = clock::now();
+            for (uint64_t i = 0; i < batch; i++) {
+                op();
+            }
+            const auto elapsed = clock::now() - start;
+            const uint64_t allocs = allocation_count() - allocs_before;
+            if (elapsed >= _min_time or batch >= (uint64_t(1) << 40)) {
+                record(name, batch, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed), allocs, bytes_per_op);
+                return;
+            }
+        }
+    }
+
+    //! \brief Store a result that was measured elsewhere
+    void record(const std::string &name,
+                const uint64_t iterations,
+                const std::chrono::nanoseconds elapsed,
+                const uint64_t allocations,
+                const size_t bytes_per_op = 0);
+
+    //! \brief Minimum time a benchmark should run for
+    std::chrono::nanoseconds min_time() const { return _min_time; }
+
+    //! \brief The results measured so far
+    const std::vector<BenchResult> &results() const { return _results; }
+
+    //! \brief Write the results as a JSON object
+    void print_json(std::ostream &os) const;
+};
+
+#endif  // SPONGE_BENCHMARKS_BENCH_HARNESS_HH
@@ -0,0 +1,47 @@
+#include "bench_harness.hh"
+#include "byte_stream.hh"
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    BenchmarkSuite suite{"byte_stream", argc, argv};
+
+    for (const size_t chunk_size : {1, 16, 256, 1500, 16384}) {
+        const string chunk(chunk_size, 'x');
+        const Buffer buffer{string(chunk)};
+        const string size = to_string(chunk_size);
+
+        ByteStream ring{64000};
+        suite.run(
+            "write_read/ring/" + size,
+            [&] {
+                ring.write(chunk);
+                do_not_optimize(ring.read(chunk_size));
+            },
+            chunk_size);
+
+        suite.run(
+            "write_pop/ring/" + size,
+            [&] {
+                ring.write(chunk);
+                do_not_optimize(ring.peek_spans(chunk_size));
+                ring.pop_output(chunk_size);
+            },
+            chunk_size);
+
+        ByteStream chunks{64000, ByteStream::Storage::Chunks};
+        suite.run(
+            "write_read_buffers/chunks/" + size,
+            [&] {
+                chunks.write(buffer);
+                do_not_optimize(chunks.read_buffers(chunk_size));
+            },
+            chunk_size);
+    }
+
+    suite.print_json(cout);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,55 @@
+#include "bench_harness.hh"
+#include "checksum_kernels.hh"
+#include "util.hh"
+
+#include <iostream>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    BenchmarkSuite suite{"internet_checksum", argc, argv};
+
+    for (const size_t size : {20, 1000, 1500, 65536}) {
+        string data(size, 0);
+        for (size_t i = 0; i < size; i++) {
+            data[i] = char(i * 131);
+        }
+        suite.run(
+            "add/" + to_string(size),
+            [&] {
+                InternetChecksum check;
+                check.add(data);
+                do_not_optimize(check.value());
+            },
+            size);
+
+        // odd-sized pieces exercise the parity handling between calls
+        suite.run(
+            "add_odd_pieces/" + to_string(size),
+            [&] {
+                InternetChecksum check;
+                const string_view view{data};
+                for (size_t offset = 0; offset < view.size(); offset += 333) {
+                    check.add(view.substr(offset, 333));
+                }
+                do_not_optimize(check.value());
+            },
+            size);
+
+        for (const auto &[kernel_name, kernel] : {make_pair("scalar", ChecksumKernel::Scalar),
+                                                  make_pair("sse2", ChecksumKernel::SSE2),
+                                                  make_pair("avx2", ChecksumKernel::AVX2)}) {
+            if (checksum_kernel_supported(kernel)) {
+                suite.run(
+                    string("kernel/") + kernel_name + "/" + to_string(size),
+                    [&] { do_not_optimize(checksum_partial(data.data(), data.size(), kernel)); },
+                    size);
+            }
+        }
+    }
+
+    suite.print_json(cout);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+#include "address.hh"
+#include "bench_harness.hh"
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "socket.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+//! \brief Raise the soft limit on open files as far as the hard limit allows
+//! \returns the number of files that may be open
+rlim_t raise_fd_limit() {
+    rlimit limit{};
+    SystemCall("getrlimit", ::getrlimit(RLIMIT_NOFILE, &limit));
+    limit.rlim_cur = limit.rlim_max;
+    SystemCall("setrlimit", ::setrlimit(RLIMIT_NOFILE, &limit));
+    return limit.rlim_cur;
+}
+
+//! Measure one wakeup among `fd_count` idle eventfds: each operation makes the next fd readable,
+//! then waits for the event and reads it
+void bench_backend(BenchmarkSuite &suite,
+                   const string &name,
+                   const EventLoop::Backend backend,
+                   vector<FileDescriptor> &fds) {
+    EventLoop loop{backend};
+    string buffer;
+    buffer.reserve(sizeof(eventfd_t));
+    for (auto &fd : fds) {
+        loop.add_explicit_rule(fd, Direction::In, [&fd, &buffer] { fd.read(buffer, sizeof(eventfd_t)); });
+    }
+
+    size_t next = 0;
+    suite.run(name + "/" + to_string(fds.size()), [&] {
+        SystemCall("eventfd_write", ::eventfd_write(fds[next].fd_num(), 1));
+        if (loop.wait_next_event(-1) != EventLoop::Result::Success) {
+            throw runtime_error("eventfd should have been ready");
+        }
+        next = (next + 1) % fds.size();
+    });
+}
+
+//! Measure an echo server over loopback UDP: each operation sends a burst of datagrams, lets the
+//! server's rule echo each one, and receives the replies
+void bench_udp_echo(BenchmarkSuite &suite, const string &name, const EventLoop::Backend backend) {
+    constexpr size_t BURST = 32;
+    UDPSocket server;
+    server.bind(Address{"127.0.0.1", 0});
+    UDPSocket client;
+    client.bind(Address{"127.0.0.1", 0});
+    const Address server_address = server.local_address();
+
+    EventLoop loop{backend};
+    loop.attach_to_ring(server);
+    size_t echoed = 0;
+    UDPSocket::received_datagram datagram{{nullptr, 0}, ""};
+    loop.add_rule(server, Direction::In, [&] {
+        server.recv(datagram);
+        server.sendto(datagram.source_address, datagram.payload);
+        echoed++;
+    });
+
+    const string payload(1000, 'x');
+    UDPSocket::received_datagram reply{{nullptr, 0}, ""};
+    suite.run(
+        "udp_echo/" + name,
+        [&] {
+            for (size_t i = 0; i < BURST; i++) {
+                client.sendto(server_address, payload);
+            }
+            for (echoed = 0; echoed < BURST;) {
+                loop.wait_next_event(-1);
+            }
+            loop.wait_next_event(0);  // io_uring submits the last replies with the next wait
+            for (size_t i = 0; i < BURST; i++) {
+                client.recv(reply);
+            }
+        },
+        BURST * payload.size());
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    BenchmarkSuite suite{"eventloop", argc, argv};
+    const rlim_t fd_limit = raise_fd_limit();
+
+    for (const size_t fd_count : {10, 1000, 10000, 50000}) {
+        // leave room for stdio, the epoll instance, and the benchmark's own files
+        if (fd_count + 64 > fd_limit) {
+            cerr << "eventloop: skipping " << fd_count << " fds (RLIMIT_NOFILE is " << fd_limit << ")\n";
+            continue;
+        }
+        vector<FileDescriptor> fds;
+        fds.reserve(fd_count);
+        for (size_t i = 0; i < fd_count; i++) {
+            fds.emplace_back(SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)));
+        }
+        bench_backend(suite, "poll", EventLoop::Backend::Poll, fds);
+        bench_backend(suite, "epoll", EventLoop::Backend::Epoll, fds);
+        bench_backend(suite, "epoll_edge", EventLoop::Backend::EpollEdge, fds);
+    }
+
+    bench_udp_echo(suite, "poll", EventLoop::Backend::Poll);
+    bench_udp_echo(suite, "epoll", EventLoop::Backend::Epoll);
+    if (IoUring::available()) {
+        bench_udp_echo(suite, "io_uring", EventLoop::Backend::IoUring);
+    } else {
+        cerr << "eventloop: skipping io_uring (unavailable)\n";
+    }
+
+    suite.print_json(cout);
+    return EXIT_SUCCESS;
+}
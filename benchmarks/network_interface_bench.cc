@@ -0,0 +1,109 @@
+#include "arp_message.hh"
+#include "bench_harness.hh"
+#include "network_interface.hh"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+const EthernetAddress LOCAL_ETHERNET{0x02, 0, 0, 0, 0, 0x01};
+const Address LOCAL_IP{"10.0.0.1"};
+
+//! An ARP reply from `ip` (at `ethernet`) to the local interface
+EthernetFrame arp_reply(const uint32_t ip, const EthernetAddress &ethernet) {
+    ARPMessage reply;
+    reply.opcode = ARPMessage::OPCODE_REPLY;
+    reply.sender_ethernet_address = ethernet;
+    reply.sender_ip_address = ip;
+    reply.target_ethernet_address = LOCAL_ETHERNET;
+    reply.target_ip_address = LOCAL_IP.ipv4_numeric();
+
+    EthernetFrame frame;
+    frame.header().dst = LOCAL_ETHERNET;
+    frame.header().src = ethernet;
+    frame.header().type = EthernetHeader::TYPE_ARP;
+    frame.payload() = reply.serialize();
+    return frame;
+}
+
+InternetDatagram make_datagram(const uint32_t dst, const size_t payload_size) {
+    InternetDatagram dgram;
+    dgram.header().src = LOCAL_IP.ipv4_numeric();
+    dgram.header().dst = dst;
+    dgram.header().len = IPv4Header::LENGTH + payload_size;
+    dgram.payload() = BufferList{string(payload_size, 'd')};
+    return dgram;
+}
+
+void drain(NetworkInterface &interface) {
+    while (not interface.frames_out().empty()) {
+        interface.frames_out().pop();
+    }
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    BenchmarkSuite suite{"network_interface", argc, argv};
+
+    // the interface logs to cerr when it is constructed
+    ostringstream log;
+    auto *const saved_cerr = cerr.rdbuf(log.rdbuf());
+    NetworkInterface interface{LOCAL_ETHERNET, LOCAL_IP};
+    cerr.rdbuf(saved_cerr);
+
+    const EthernetAddress peer_ethernet{0x02, 0, 0, 0, 0, 0x02};
+    const uint32_t peer_ip = Address{"10.0.0.2"}.ipv4_numeric();
+    interface.recv_frame(arp_reply(peer_ip, peer_ethernet));
+
+    for (const size_t payload_size : {0, 1000}) {
+        const InternetDatagram dgram = make_datagram(peer_ip, payload_size);
+        const size_t wire_size = IPv4Header::LENGTH + payload_size;
+        suite.run(
+            "send_known/" + to_string(payload_size),
+            [&] {
+                interface.send_datagram(dgram, Address::from_ipv4_numeric(peer_ip));
+                drain(interface);
+            },
+            wire_size);
+
+        EthernetFrame frame;
+        frame.header().dst = LOCAL_ETHERNET;
+        frame.header().src = peer_ethernet;
+        frame.header().type = EthernetHeader::TYPE_IPv4;
+        frame.payload() = dgram.serialize().concatenate();
+        suite.run(
+            "recv_ipv4/" + to_string(payload_size),
+            [&] { do_not_optimize(interface.recv_frame(frame)); },
+            wire_size);
+    }
+
+    // a full resolution: queue a datagram for an unknown next hop, send the ARP request,
+    // then receive the reply and release the queued datagram
+    constexpr size_t HOSTS = 1024;
+    vector<EthernetFrame> replies;
+    vector<InternetDatagram> datagrams;
+    for (size_t i = 0; i < HOSTS; i++) {
+        const uint32_t ip = Address{"10.1.0.0"}.ipv4_numeric() + i;
+        replies.push_back(arp_reply(ip, {0x02, 0, 0, 1, uint8_t(i >> 8), uint8_t(i)}));
+        datagrams.push_back(make_datagram(ip, 1000));
+    }
+    size_t host = 0;
+    suite.run("arp_resolution", [&] {
+        const InternetDatagram &dgram = datagrams[host];
+        interface.send_datagram(dgram, Address::from_ipv4_numeric(dgram.header().dst));
+        interface.recv_frame(replies[host]);
+        drain(interface);
+        if (++host == HOSTS) {
+            // forget every mapping so that the next round has to resolve them again
+            host = 0;
+            interface.tick(60000);
+        }
+    });
+
+    suite.print_json(cout);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+#include "arp_message.hh"
+#include "bench_harness.hh"
+#include "route_table.hh"
+#include "router.hh"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+constexpr size_t LOOKUPS = 4096;
+
+const EthernetAddress ROUTER_ETHERNET{0x02, 0, 0, 0, 0, 0x01};
+const EthernetAddress NEXT_HOP_ETHERNET{0x02, 0, 0, 0, 0, 0x02};
+const Address ROUTER_IP{"10.0.0.1"};
+const Address NEXT_HOP_IP{"10.0.0.2"};
+
+//! An ARP reply that teaches the router's interface where the next hop is
+EthernetFrame next_hop_arp_reply() {
+    ARPMessage reply;
+    reply.opcode = ARPMessage::OPCODE_REPLY;
+    reply.sender_ethernet_address = NEXT_HOP_ETHERNET;
+    reply.sender_ip_address = NEXT_HOP_IP.ipv4_numeric();
+    reply.target_ethernet_address = ROUTER_ETHERNET;
+    reply.target_ip_address = ROUTER_IP.ipv4_numeric();
+
+    EthernetFrame frame;
+    frame.header().dst = ROUTER_ETHERNET;
+    frame.header().src = NEXT_HOP_ETHERNET;
+    frame.header().type = EthernetHeader::TYPE_ARP;
+    frame.payload() = reply.serialize();
+    return frame;
+}
+
+//! Measure routing one datagram through a table with `table_size` random prefixes
+void bench_table(BenchmarkSuite &suite, const size_t table_size) {
+    mt19937 rng{uint32_t(table_size)};
+    uniform_int_distribution<uint32_t> address;
+    uniform_int_distribution<int> length{8, 24};
+
+    // the router logs every interface and route it is given to cerr; discard that
+    auto *const saved_cerr = cerr.rdbuf(nullptr);
+    Router router;
+    const size_t interface_num = router.add_interface(AsyncNetworkInterface{ROUTER_ETHERNET, ROUTER_IP});
+    router.add_route(0, 0, NEXT_HOP_IP, interface_num);
+    for (size_t i = 0; i < table_size; i++) {
+        const int prefix_length = length(rng);
+        const uint32_t prefix = (address(rng) >> (32 - prefix_length)) << (32 - prefix_length);
+        router.add_route(prefix, prefix_length, NEXT_HOP_IP, interface_num);
+    }
+    cerr.rdbuf(saved_cerr);
+    cerr.clear();
+
+    AsyncNetworkInterface &interface = router.interface(interface_num);
+    interface.recv_frame(next_hop_arp_reply());
+
+    vector<InternetDatagram> datagrams(LOOKUPS);
+    for (auto &dgram : datagrams) {
+        dgram.header().src = NEXT_HOP_IP.ipv4_numeric();
+        dgram.header().dst = address(rng);
+        dgram.header().len = IPv4Header::LENGTH;
+    }
+
+    // the same prefixes in a bare RouteTable, to separate the lookup from the forwarding work
+    RouteTable table;
+    rng.seed(uint32_t(table_size));
+    for (size_t i = 0; i < table_size; i++) {
+        const int prefix_length = length(rng);
+        table.insert(address(rng), prefix_length, i);
+    }
+    vector<uint32_t> destinations;
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        destinations.push_back(address(rng));
+    }
+    size_t next = 0;
+    suite.run("lookup/" + to_string(table_size), [&] {
+        do_not_optimize(table.lookup(destinations[next]));
+        next = (next + 1) % LOOKUPS;
+    });
+
+    suite.run("route/" + to_string(table_size), [&] {
+        interface.datagrams_out().push(datagrams[next]);
+        router.route();
+        interface.frames_out().pop();
+        next = (next + 1) % LOOKUPS;
+    });
+}
+//! Measure forwarding between `INTERFACES` interfaces when the work is spread over `workers` threads
+void bench_workers(BenchmarkSuite &suite, const size_t workers) {
+    constexpr size_t INTERFACES = 8;
+    constexpr size_t DATAGRAMS_PER_INTERFACE = 4096;
+
+    auto *const saved_cerr = cerr.rdbuf(nullptr);
+    Router router{RouterConfig{workers, 32, 1024}};
+    for (size_t i = 0; i < INTERFACES; i++) {
+        const Address ip = Address::from_ipv4_numeric(ROUTER_IP.ipv4_numeric() + (i << 8));
+        router.add_interface(AsyncNetworkInterface{ROUTER_ETHERNET, ip});
+        router.add_route(0x0b000000 | uint32_t(i) << 16, 16, NEXT_HOP_IP, i);
+    }
+    cerr.rdbuf(saved_cerr);
+    cerr.clear();
+    for (size_t i = 0; i < INTERFACES; i++) {
+        // every interface learns the next hop's Ethernet address (the reply is addressed to 10.0.0.1)
+        EthernetFrame reply = next_hop_arp_reply();
+        ARPMessage arp;
+        arp.parse(reply.payload().concatenate());
+        arp.target_ip_address = ROUTER_IP.ipv4_numeric() + (i << 8);
+        reply.payload() = arp.serialize();
+        router.interface(i).recv_frame(reply);
+    }
+
+    InternetDatagram dgram;
+    dgram.header().src = NEXT_HOP_IP.ipv4_numeric();
+    dgram.header().len = IPv4Header::LENGTH;
+
+    uint64_t datagrams = 0;
+    chrono::nanoseconds elapsed{0};
+    const uint64_t allocs_before = allocation_count();
+    while (elapsed < suite.min_time()) {
+        for (size_t i = 0; i < INTERFACES; i++) {
+            for (size_t n = 0; n < DATAGRAMS_PER_INTERFACE; n++) {
+                // spread each interface's traffic over all the others
+                dgram.header().dst = 0x0b000000 | uint32_t((i + n) % INTERFACES) << 16 | uint32_t(n);
+                router.interface(i).datagrams_out().push(dgram);
+            }
+        }
+        const auto start = chrono::steady_clock::now();
+        router.route();
+        elapsed += chrono::steady_clock::now() - start;
+        datagrams += INTERFACES * DATAGRAMS_PER_INTERFACE;
+        for (size_t i = 0; i < INTERFACES; i++) {
+            router.interface(i).frames_out() = {};
+        }
+    }
+    suite.record("forward/workers=" + to_string(workers), datagrams, elapsed, allocation_count() - allocs_before);
+
+    // per-thread throughput goes to stderr so that stdout stays valid JSON
+    const auto &stats = router.worker_stats();
+    for (size_t w = 0; w < stats.size(); w++) {
+        cerr << "router workers=" << workers << " worker " << w << ": " << stats[w].datagrams_in << " in, "
+             << stats[w].datagrams_sent << " sent, " << stats[w].handed_off << " handed off, "
+             << uint64_t(stats[w].datagrams_per_second()) << " datagrams/s\n";
+    }
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    BenchmarkSuite suite{"router", argc, argv};
+
+    for (const size_t table_size : {1000, 100000, 900000}) {
+        bench_table(suite, table_size);
+    }
+    for (const size_t workers : {1, 2, 4}) {
+        bench_workers(suite, workers);
+    }
+
+    suite.print_json(cout);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+#include "bench_harness.hh"
+#include "stream_reassembler.hh"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+constexpr size_t CAPACITY = 64000;
+constexpr size_t SEGMENT_SIZE = 1000;
+constexpr size_t SEGMENTS_PER_WINDOW = CAPACITY / SEGMENT_SIZE;
+
+struct Segment {
+    size_t offset;  // offset within the window
+    size_t length;
+};
+
+//! Deliver one window of segments (in the given order) and drain the output
+void deliver_window(StreamReassembler &reassembler,
+                    const vector<Segment> &pattern,
+                    const vector<Buffer> &payloads,
+                    size_t &base) {
+    for (const auto &seg : pattern) {
+        Buffer payload = payloads[seg.offset / SEGMENT_SIZE];
+        payload.remove_suffix(payload.size() - seg.length);
+        reassembler.push_substring(payload, base + seg.offset, false);
+    }
+    base += CAPACITY;
+    reassembler.stream_out().pop_output(reassembler.stream_out().buffer_size());
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    BenchmarkSuite suite{"stream_reassembler", argc, argv};
+
+    vector<Buffer> payloads;
+    for (size_t i = 0; i < SEGMENTS_PER_WINDOW; i++) {
+        payloads.emplace_back(string(SEGMENT_SIZE, char('a' + i % 26)));
+    }
+
+    vector<Segment> in_order;
+    for (size_t i = 0; i < SEGMENTS_PER_WINDOW; i++) {
+        in_order.push_back({i * SEGMENT_SIZE, SEGMENT_SIZE});
+    }
+    vector<Segment> reversed(in_order.rbegin(), in_order.rend());
+    vector<Segment> random_order = in_order;
+    shuffle(random_order.begin(), random_order.end(), mt19937{1234});
+    // every segment arrives three times, the retransmissions in random order
+    vector<Segment> duplicates = random_order;
+    for (size_t copy = 0; copy < 2; copy++) {
+        for (const auto &seg : random_order) {
+            duplicates.push_back(seg);
+        }
+    }
+    shuffle(duplicates.begin(), duplicates.end(), mt19937{5678});
+
+    const vector<pair<string, const vector<Segment> *>> patterns = {
+        {"in_order", &in_order}, {"reversed", &reversed}, {"random", &random_order}, {"duplicate_heavy", &duplicates}};
+
+    for (const auto &[storage_name, storage] :
+         {make_pair(string("ring"), ByteStream::Storage::Ring), make_pair(string("chunks"), ByteStream::Storage::Chunks)}) {
+        for (const auto &[pattern_name, pattern] : patterns) {
+            StreamReassembler reassembler{CAPACITY, storage};
+            size_t base = 0;
+            suite.run(
+                pattern_name + "/" + storage_name,
+                [&] { deliver_window(reassembler, *pattern, payloads, base); },
+                CAPACITY);
+        }
+    }
+
+    suite.print_json(cout);
+    return EXIT_SUCCESS;
+}
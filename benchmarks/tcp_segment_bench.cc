@@ -0,0 +1,87 @@
+#include "bench_harness.hh"
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "tcp_segment.hh"
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    BenchmarkSuite suite{"tcp_segment", argc, argv};
+
+    for (const size_t payload_size : {0, 1000}) {
+        TCPSegment seg;
+        seg.header().sport = 1234;
+        seg.header().dport = 80;
+        seg.header().seqno = WrappingInt32{42};
+        seg.header().ackno = WrappingInt32{4242};
+        seg.header().ack = true;
+        seg.header().win = 64000 & 0xffff;
+        seg.payload() = Buffer{string(payload_size, 'p')};
+        const size_t wire_size = TCPHeader::LENGTH + payload_size;
+
+        suite.run(
+            "serialize/" + to_string(payload_size),
+            [&] { do_not_optimize(seg.serialize()); },
+            wire_size);
+
+        // the sender's path: the payload's checksum was taken while it was copied out of the stream
+        TCPSegment cached = seg;
+        InternetChecksum payload_checksum;
+        payload_checksum.add(seg.payload());
+        cached.set_payload(seg.payload(), payload_checksum);
+        suite.run(
+            "serialize_cached/" + to_string(payload_size),
+            [&] { do_not_optimize(cached.serialize()); },
+            wire_size);
+
+        const Buffer wire{seg.serialize().concatenate()};
+        suite.run(
+            "parse/" + to_string(payload_size),
+            [&] {
+                TCPSegment parsed;
+                do_not_optimize(parsed.parse(wire));
+            },
+            wire_size);
+    }
+
+    IPv4Datagram dgram;
+    dgram.header().src = 0x0a000001;
+    dgram.header().dst = 0x0a000002;
+    dgram.header().len = IPv4Header::LENGTH + 1020;
+    dgram.payload() = BufferList{string(1020, 'd')};
+    const Buffer ip_wire{dgram.serialize().concatenate()};
+    suite.run(
+        "ipv4_header_parse",
+        [&] {
+            IPv4Header header;
+            NetParser p{ip_wire};
+            do_not_optimize(header.parse(p));
+        },
+        IPv4Header::LENGTH);
+
+    // one router hop: decrement the TTL of a parsed datagram and serialize it again
+    IPv4Datagram parsed;
+    parsed.parse(ip_wire);
+    suite.run(
+        "ipv4_forward/incremental",
+        [&] {
+            IPv4Datagram hop = parsed;
+            hop.decrement_ttl();
+            do_not_optimize(hop.serialize());
+        },
+        IPv4Header::LENGTH);
+    suite.run(
+        "ipv4_forward/reserialize",
+        [&] {
+            IPv4Datagram hop = parsed;
+            hop.header().ttl--;
+            do_not_optimize(hop.serialize());
+        },
+        IPv4Header::LENGTH);
+
+    suite.print_json(cout);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+#include "address.hh"
+#include "bench_harness.hh"
+#include "buffer.hh"
+#include "socket.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+//! Datagrams per operation: one full batch
+constexpr size_t BURST = UDPSocket::MAX_BATCH;
+
+//! A pair of UDP sockets bound to loopback
+struct Loopback {
+    UDPSocket sender{};
+    UDPSocket receiver{};
+    Address destination{"127.0.0.1", 0};
+
+    Loopback() {
+        sender.bind(Address{"127.0.0.1", 0});
+        receiver.bind(Address{"127.0.0.1", 0});
+        destination = receiver.local_address();
+    }
+};
+
+//! Measure moving a burst of `size`-byte datagrams over loopback with a system call per datagram
+void bench_per_packet(BenchmarkSuite &suite, const size_t size) {
+    Loopback link;
+    BufferPool pool{1 << 20};
+    const string payload(size, 'x');
+    Address source{nullptr, 0};
+    suite.run(
+        "loopback/per_packet/" + to_string(size),
+        [&] {
+            for (size_t i = 0; i < BURST; i++) {
+                link.sender.sendto(link.destination, payload);
+            }
+            for (size_t i = 0; i < BURST; i++) {
+                do_not_optimize(link.receiver.recv(source, pool));
+            }
+        },
+        BURST * size);
+}
+
+//! Measure moving the same burst with [sendmmsg(2)](\ref man2::sendmmsg) and [recvmmsg(2)](\ref man2::recvmmsg)
+void bench_batched(BenchmarkSuite &suite, const size_t size) {
+    Loopback link;
+    BufferPool pool{1 << 20};
+    const vector<BufferList> payloads(BURST, BufferList{string(size, 'x')});
+    vector<UDPSocket::received_buffer> received;
+    suite.run(
+        "loopback/batched/" + to_string(size),
+        [&] {
+            link.sender.send_batch(link.destination, payloads);
+            for (size_t count = 0; count < BURST;) {
+                count += link.receiver.recv_batch(received, pool);
+            }
+        },
+        BURST * size);
+}
+
+//! Measure moving the same burst as one GSO send, received (coalesced by GRO) as few datagrams as possible
+void bench_gso(BenchmarkSuite &suite, const size_t size) {
+    Loopback link;
+    link.receiver.set_gro(true);
+    BufferPool pool{1 << 20};
+    const vector<BufferList> payloads{BufferList{string(BURST * size, 'x')}};
+    const vector<uint16_t> segment_sizes{uint16_t(size)};
+    vector<UDPSocket::received_buffer> received;
+    suite.run(
+        "loopback/gso_gro/" + to_string(size),
+        [&] {
+            link.sender.send_batch(link.destination, payloads, segment_sizes);
+            for (size_t bytes = 0; bytes < BURST * size;) {
+                link.receiver.recv_batch(received, pool);
+                for (const auto &datagram : received) {
+                    bytes += datagram.payload.size();
+                }
+            }
+        },
+        BURST * size);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    BenchmarkSuite suite{"udp", argc, argv};
+
+    for (const size_t size : {64, 1000, 1452}) {
+        bench_per_packet(suite, size);
+        bench_batched(suite, size);
+        bench_gso(suite, size);
+    }
+
+    suite.print_json(cout);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,29 @@
+#include "bench_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    BenchmarkSuite suite{"wrapping_integers", argc, argv};
+
+    const WrappingInt32 isn{0xdeadbeef};
+
+    uint64_t n = 0;
+    suite.run("wrap", [&] {
+        do_not_optimize(wrap(n, isn));
+        n += 1000;
+    });
+
+    uint64_t checkpoint = uint64_t(1) << 33;
+    WrappingInt32 seqno = wrap(checkpoint, isn);
+    suite.run("unwrap", [&] {
+        do_not_optimize(unwrap(seqno, isn, checkpoint));
+        checkpoint += 1000;
+        seqno = seqno + 1000;
+    });
+
+    suite.print_json(cout);
+    return EXIT_SUCCESS;
+}
@@ -30,21 +30,44 @@ add_test(NAME t_strm_reassem_many        COMMAND fsm_stream_reassembler_many)
 add_test(NAME t_strm_reassem_overlapping COMMAND fsm_stream_reassembler_overlapping)
 add_test(NAME t_strm_reassem_win         COMMAND fsm_stream_reassembler_win)
 add_test(NAME t_strm_reassem_cap         COMMAND fsm_stream_reassembler_cap)
+add_test(NAME t_strm_reassem_ring        COMMAND fsm_stream_reassembler_ring)
+add_test(NAME t_strm_reassem_chunks      COMMAND fsm_stream_reassembler_chunks)
 
 add_test(NAME t_byte_stream_construction COMMAND byte_stream_construction)
 add_test(NAME t_byte_stream_one_write    COMMAND byte_stream_one_write)
 add_test(NAME t_byte_stream_two_writes   COMMAND byte_stream_two_writes)
 add_test(NAME t_byte_stream_capacity     COMMAND byte_stream_capacity)
 add_test(NAME t_byte_stream_many_writes  COMMAND byte_stream_many_writes)
+add_test(NAME t_byte_stream_spans        COMMAND byte_stream_spans)
+add_test(NAME t_byte_stream_chunks       COMMAND byte_stream_chunks)
 
 add_test(NAME t_webget               COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_t.sh")
 
 add_test(NAME arp_network_interface    COMMAND net_interface)
 
-add_test(NAME router_test    COMMAND network_simulator)
+add_test(NAME router_test      COMMAND network_simulator)
+add_test(NAME t_route_table    COMMAND route_table)
+add_test(NAME t_router_workers COMMAND router_workers)
 
 add_test(NAME t_tcp_parser           COMMAND tcp_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
 add_test(NAME t_ipv4_parser          COMMAND ipv4_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
+add_test(NAME t_ipv4_decrement_ttl   COMMAND ipv4_decrement_ttl)
+add_test(NAME t_checksum_kernels     COMMAND checksum_kernels)
+add_test(NAME t_tcp_segment_checksum COMMAND tcp_segment_checksum)
+add_test(NAME t_congestion_control   COMMAND congestion_control)
+add_test(NAME t_rtt_estimator        COMMAND rtt_estimator)
+add_test(NAME t_tcp_sack             COMMAND tcp_sack)
+add_test(NAME t_tcp_window_scale     COMMAND tcp_window_scale)
+add_test(NAME t_retransmission_queue COMMAND retransmission_queue)
+add_test(NAME t_tcp_pacing           COMMAND tcp_pacing)
+add_test(NAME t_tcp_mss              COMMAND tcp_mss)
+add_test(NAME t_tcp_gso              COMMAND tcp_gso)
+add_test(NAME t_tcp_delayed_ack      COMMAND tcp_delayed_ack)
+add_test(NAME t_tcp_allocations      COMMAND tcp_allocations)
+add_test(NAME t_eventloop_backends   COMMAND eventloop_backends)
+add_test(NAME t_eventloop_io_uring   COMMAND eventloop_io_uring)
+add_test(NAME t_fd_pooled_read       COMMAND fd_pooled_read)
+add_test(NAME t_udp_batch            COMMAND udp_batch)
 add_test(NAME t_active_close         COMMAND fsm_active_close)
 add_test(NAME t_passive_close        COMMAND fsm_passive_close)
 add_test(NAME ec_ack_rst             COMMAND fsm_ack_rst)
@@ -1,5 +1,10 @@
 #include "byte_stream.hh"
 
+#include "util.hh"
+
+#include <algorithm>
+#include <cstring>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -12,17 +17,20 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity) :
-    _capacity(capacity), _buffer(nullptr), _write_index(0), _read_index(0), _input_ended(false) {
-    _buffer = new byte[_capacity];
+ByteStream::ByteStream(const size_t capacity, const Storage storage) :
+    _capacity(capacity), _storage(storage), _buffer(nullptr), _write_index(0), _read_index(0), _input_ended(false) {
+    if (_storage == Storage::Ring) {
+        _buffer = new byte[_capacity];
+    }
 }
 
 ByteStream::ByteStream(const ByteStream &another) :
-    _capacity(another._capacity), _buffer(nullptr), _write_index(another._write_index),
-    _read_index(another._read_index), _input_ended(another._input_ended) {
-    _buffer = new byte[_capacity];
-    for (size_t i = 0; i < _capacity; i++) {
-        _buffer[i] = another._buffer[i];
+    _capacity(another._capacity), _storage(another._storage), _buffer(nullptr), _chunks(another._chunks),
+    _write_index(another._write_index), _read_index(another._read_index), _input_ended(another._input_ended),
+    _error(another._error) {
+    if (_storage == Storage::Ring) {
+        _buffer = new byte[_capacity];
+        copy(another._buffer, another._buffer + _capacity, _buffer);
     }
 }
 
@@ -35,39 +43,116 @@ ByteStream &ByteStream::operator=(const ByteStream &another) {
         return *this;
     }
     delete[] _buffer;
+    _buffer = nullptr;
     _capacity = another._capacity;
-    _buffer = new byte[_capacity];
+    _storage = another._storage;
+    if (_storage == Storage::Ring) {
+        _buffer = new byte[_capacity];
+        copy(another._buffer, another._buffer + _capacity, _buffer);
+    }
+    _chunks = another._chunks;
     _write_index = another._write_index;
     _read_index = another._read_index;
     _input_ended = another._input_ended;
-    for (size_t i = 0; i < _write_index; i++) {
-        _buffer[i] = another._buffer[i];
-    }
+    _error = another._error;
     return *this;
 }
 
-size_t ByteStream::write(const string &data) {
-    size_t len = min(data.size(),remaining_capacity());
-    for (size_t i = 0; i < len; i++) {
-        _buffer[_write_index%_capacity] = data[i];
-        _write_index++;
+size_t ByteStream::write(const string_view data) {
+    const size_t len = min(data.size(), remaining_capacity());
+    if (len == 0) {
+        return 0;
+    }
+    // Chunks 模式下只能为这段数据新建一个 Buffer
+    if (_storage == Storage::Chunks) {
+        _chunks.append(Buffer(string(data.substr(0, len))));
+        _write_index += len;
+        return len;
+    }
+    // 写入位置到缓冲区末尾之间放不下时，分两段拷贝（先填满尾部，再从头部继续）
+    const size_t pos = _write_index % _capacity;
+    const size_t first = min(len, _capacity - pos);
+    memcpy(_buffer + pos, data.data(), first);
+    memcpy(_buffer, data.data() + first, len - first);
+    _write_index += len;
+    return len;
+}
+
+size_t ByteStream::write(Buffer data) {
+    if (_storage == Storage::Ring) {
+        return write(data.str());
     }
+    const size_t len = min(data.size(), remaining_capacity());
+    if (len == 0) {
+        return 0;
+    }
+    // 超出容量的部分直接截掉，保留的部分与原 Buffer 共享同一块内存
+    data.remove_suffix(data.size() - len);
+    _chunks.append(data);
+    _write_index += len;
     return len;
 }
 
+//! \param[in] len bytes will be viewed from the output side of the buffer
+pair<string_view, string_view> ByteStream::peek_spans(const size_t len) const {
+    const size_t len_ = min(len, buffer_size());
+    if (len_ == 0) {
+        return {};
+    }
+    if (_storage == Storage::Chunks) {
+        const auto &chunks = _chunks.buffers();
+        const string_view first = chunks.front().str().substr(0, len_);
+        if (first.size() == len_ or chunks.size() < 2) {
+            return {first, {}};
+        }
+        return {first, chunks[1].str().substr(0, len_ - first.size())};
+    }
+    const size_t pos = _read_index % _capacity;
+    const size_t first = min(len_, _capacity - pos);
+    return {{_buffer + pos, first}, {_buffer, len_ - first}};
+}
+
 //! \param[in] len bytes will be copied from the output side of the buffer
 string ByteStream::peek_output(const size_t len) const {
+    if (_storage == Storage::Chunks) {
+        return peek_buffers(len).concatenate();
+    }
+    const auto [first, second] = peek_spans(len);
     string ret;
-    size_t len_ = min(len,buffer_size());
-    for (size_t i = 0; i < len_; i++) {
-        ret.push_back(_buffer[(_read_index+i)%_capacity]);
+    ret.reserve(first.size() + second.size());
+    ret.append(first);
+    ret.append(second);
+    return ret;
+}
+
+//! \param[in] len bytes will be sliced (Chunks) or copied (Ring) from the output side of the buffer
+BufferList ByteStream::peek_buffers(const size_t len) const {
+    const size_t len_ = min(len, buffer_size());
+    if (_storage == Storage::Ring) {
+        return BufferList(peek_output(len_));
+    }
+    BufferList ret;
+    size_t remaining = len_;
+    for (const auto &chunk : _chunks.buffers()) {
+        if (remaining == 0) {
+            break;
+        }
+        Buffer slice = chunk;
+        if (slice.size() > remaining) {
+            slice.remove_suffix(slice.size() - remaining);
+        }
+        remaining -= slice.size();
+        ret.append(slice);
     }
     return ret;
 }
 
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
-    size_t len_ = min(len,buffer_size());
+    const size_t len_ = min(len, buffer_size());
+    if (_storage == Storage::Chunks) {
+        _chunks.remove_prefix(len_);
+    }
     _read_index += len_;
 }
 
@@ -80,6 +165,91 @@ std::string ByteStream::read(const size_t len) {
     return ret;
 }
 
+//! \param[in] len bytes will be popped and returned
+//! \param[in,out] checksum sums the bytes in the same pass that copies them
+string ByteStream::read(const size_t len, InternetChecksum &checksum) {
+    string ret(min(len, buffer_size()), '\0');
+    read(len, ret.data(), checksum);
+    return ret;
+}
+
+//! \param[in] len bytes will be popped and copied to `dst`
+//! \param[out] dst receives the bytes
+//! \param[in,out] checksum sums the bytes in the same pass that copies them
+size_t ByteStream::read(const size_t len, char *dst, InternetChecksum &checksum) {
+    const size_t len_ = min(len, buffer_size());
+    size_t copied = 0;
+    // 拷贝与求校验和合并为一趟，每个字节只被读取一次
+    if (_storage == Storage::Chunks) {
+        for (const auto &chunk : _chunks.buffers()) {
+            if (copied == len_) {
+                break;
+            }
+            const string_view piece = chunk.str().substr(0, len_ - copied);
+            checksum.add_copy(piece, dst + copied);
+            copied += piece.size();
+        }
+    } else {
+        const auto [first, second] = peek_spans(len_);
+        checksum.add_copy(first, dst);
+        checksum.add_copy(second, dst + first.size());
+    }
+    pop_output(len_);
+    return len_;
+}
+
+//! \param[in] len bytes will be popped and returned
+//! \param[in] piece_size the number of bytes summed by each checksum (the last may sum fewer)
+//! \param[in,out] checksums receives one checksum per piece
+string ByteStream::read(const size_t len, const size_t piece_size, vector<InternetChecksum> &checksums) {
+    string ret(min(len, buffer_size()), '\0');
+    read(len, ret.data(), piece_size, checksums);
+    return ret;
+}
+
+//! \param[in] len bytes will be popped and copied to `dst`
+//! \param[out] dst receives the bytes
+//! \param[in] piece_size the number of bytes summed by each checksum (the last may sum fewer)
+//! \param[in,out] checksums receives one checksum per piece
+size_t ByteStream::read(const size_t len, char *dst, const size_t piece_size, vector<InternetChecksum> &checksums) {
+    const size_t len_ = min(len, buffer_size());
+    size_t copied = 0;
+    // 与 read(len, dst, checksum) 相同，只是每到一段的开头就换一个校验和
+    const auto copy = [&](string_view data) {
+        while (!data.empty()) {
+            if (copied % piece_size == 0) {
+                checksums.emplace_back();
+            }
+            const size_t n = min(data.size(), piece_size - copied % piece_size);
+            checksums.back().add_copy(data.substr(0, n), dst + copied);
+            copied += n;
+            data.remove_prefix(n);
+        }
+    };
+    if (_storage == Storage::Chunks) {
+        for (const auto &chunk : _chunks.buffers()) {
+            if (copied == len_) {
+                break;
+            }
+            copy(chunk.str().substr(0, len_ - copied));
+        }
+    } else {
+        const auto [first, second] = peek_spans(len_);
+        copy(first);
+        copy(second);
+    }
+    pop_output(len_);
+    return len_;
+}
+
+//! \param[in] len bytes will be popped and returned
+//! \returns the popped bytes, sharing storage with the written Buffers in Chunks mode
+BufferList ByteStream::read_buffers(const size_t len) {
+    BufferList ret = peek_buffers(len);
+    pop_output(len);
+    return ret;
+}
+
 void ByteStream::end_input() {
     _input_ended = true;
 }
@@ -1,7 +1,14 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class InternetChecksum;
 
 //! \brief An in-order byte stream.
 
@@ -9,6 +16,13 @@
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
 class ByteStream {
+  public:
+    //! How the stream keeps the bytes it is holding
+    enum class Storage {
+        Ring,    //!< copy bytes into a fixed-size ring buffer
+        Chunks,  //!< keep the written Buffers themselves (zero-copy), trimmed to the capacity
+    };
+
   private:
     // Your code here -- add private members as necessary.
 
@@ -21,11 +35,15 @@ class ByteStream {
 
     size_t _capacity;  //缓存容量
 
-    byte *_buffer;  //比特流缓存
+    Storage _storage;  //存储模式
+
+    byte *_buffer;  //比特流缓存（环形缓冲区，仅 Ring 模式使用）
 
-    size_t _write_index;  //写入索引
+    BufferList _chunks{};  //按写入顺序保存的 Buffer 分片（仅 Chunks 模式使用）
 
-    size_t _read_index;  //读取索引
+    size_t _write_index;  //写入索引（累计写入的字节数）
+
+    size_t _read_index;  //读取索引（累计读取的字节数）
 
     bool _input_ended;  //输入是否结束
 
@@ -33,7 +51,7 @@ class ByteStream {
 
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    ByteStream(const size_t capacity, const Storage storage = Storage::Ring);
 
     ByteStream(const ByteStream &);
 
@@ -47,7 +65,16 @@ class ByteStream {
     //! Write a string of bytes into the stream. Write as many
     //! as will fit, and return how many were written.
     //! \returns the number of bytes accepted into the stream
-    size_t write(const std::string &data);
+    size_t write(const std::string &data) { return write(std::string_view(data)); }
+
+    //! Write a view of bytes into the stream (at most two bulk copies).
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const std::string_view data);
+
+    //! Write a Buffer into the stream. In Chunks mode the Buffer is kept
+    //! as-is (only trimmed to fit), so no bytes are copied.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
 
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
@@ -66,6 +93,16 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns up to two contiguous views into the buffer (the second is empty unless
+    //! the bytes wrap around the end of the ring); the views are invalidated by the next write or pop
+    //! \note In Chunks mode the views are the first two chunks, which may cover fewer than `len` bytes.
+    std::pair<std::string_view, std::string_view> peek_spans(const size_t len) const;
+
+    //! Peek at next "len" bytes of the stream as refcounted Buffers
+    //! \returns slices of the stored chunks in Chunks mode, or a single copied Buffer in Ring mode
+    BufferList peek_buffers(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -73,6 +110,27 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read the next "len" bytes, adding them to `checksum` while they are copied out
+    //! \returns a string
+    std::string read(const size_t len, InternetChecksum &checksum);
+
+    //! Read the next "len" bytes, summing each `piece_size` bytes of them into its own checksum
+    //! (appended to `checksums`) while they are copied out
+    //! \returns a string
+    std::string read(const size_t len, const size_t piece_size, std::vector<InternetChecksum> &checksums);
+
+    //! Read the next "len" bytes into `dst`, which must have room for them, adding them to
+    //! `checksum` while they are copied out (no string is allocated)
+    //! \returns the number of bytes read
+    size_t read(const size_t len, char *dst, InternetChecksum &checksum);
+
+    //! Read the next "len" bytes into `dst`, summing each `piece_size` bytes into its own checksum
+    //! \returns the number of bytes read
+    size_t read(const size_t len, char *dst, const size_t piece_size, std::vector<InternetChecksum> &checksums);
+
+    //! Read (i.e., slice and then pop) the next "len" bytes of the stream without copying in Chunks mode
+    BufferList read_buffers(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
@@ -92,6 +150,9 @@ class ByteStream {
     //! \name General accounting
     //!@{
 
+    //! How the stream stores its bytes
+    Storage storage() const { return _storage; }
+
     //! Total number of bytes written
     size_t bytes_written() const;
 
@@ -0,0 +1,283 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace {
+//! Initial window of RFC 3390: min(4*MSS, max(2*MSS, 4380 bytes))
+size_t initial_window(const size_t mss) { return min(4 * mss, max(2 * mss, size_t(4380))); }
+
+//! A window of `bytes` with segments of `from` bytes, in segments of `to` bytes (an unset threshold stays unset)
+size_t rescale(const size_t bytes, const size_t from, const size_t to) {
+    return bytes == numeric_limits<size_t>::max() ? bytes : max(bytes / from * to + bytes % from, to);
+}
+
+//! RTT samples are whole milliseconds; a segment acknowledged within the same tick still took some time
+uint64_t clamp_rtt(const uint64_t rtt_ms) { return max(rtt_ms, uint64_t(1)); }
+
+//! Exponentially weighted RTT average with gain 1/8 (as in RFC 6298)
+void smooth_rtt(uint64_t &srtt_ms, const uint64_t rtt_ms) {
+    srtt_ms = srtt_ms == 0 ? rtt_ms : (7 * srtt_ms + rtt_ms) / 8;
+}
+
+//! Send one window per RTT, scaled by `gain` so that the window keeps growing while paced
+uint64_t window_pacing_rate(const size_t cwnd, const uint64_t srtt_ms, const double gain) {
+    if (srtt_ms == 0) {
+        return 0;
+    }
+    return uint64_t(gain * double(cwnd) * 1000 / double(srtt_ms));
+}
+}  // namespace
+
+unique_ptr<CongestionController> make_congestion_controller(const CongestionControl algorithm, const size_t mss) {
+    switch (algorithm) {
+        case CongestionControl::None:
+            return nullptr;
+        case CongestionControl::NewReno:
+            return make_unique<NewRenoController>(mss);
+        case CongestionControl::Cubic:
+            return make_unique<CubicController>(mss);
+        case CongestionControl::BBR:
+            return make_unique<BBRController>(mss);
+    }
+    return nullptr;
+}
+
+NewRenoController::NewRenoController(const size_t mss)
+    : _mss(mss), _cwnd(initial_window(mss)), _ssthresh(numeric_limits<size_t>::max()) {}
+
+void NewRenoController::on_ack(const AckSample &ack) {
+    if (ack.rtt_ms.has_value()) {
+        smooth_rtt(_srtt_ms, clamp_rtt(*ack.rtt_ms));
+    }
+    if (_cwnd < _ssthresh) {
+        // 慢启动：按确认的字节数增长（RFC 3465，每个 ACK 最多计 2 个 MSS）
+        _cwnd += min(ack.bytes_acked, 2 * _mss);
+        return;
+    }
+    // 拥塞避免：每确认一个窗口的数据，窗口增长一个 MSS
+    _avoidance_credit += ack.bytes_acked;
+    if (_avoidance_credit >= _cwnd) {
+        _avoidance_credit -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+void NewRenoController::on_loss(const uint64_t /* now_ms */, const LossSignal signal, const size_t bytes_in_flight) {
+    _ssthresh = max(bytes_in_flight / 2, 2 * _mss);
+    _cwnd = signal == LossSignal::Timeout ? _mss : _ssthresh;
+    _avoidance_credit = 0;
+}
+
+void NewRenoController::set_mss(const size_t mss) {
+    _cwnd = rescale(_cwnd, _mss, mss);
+    _ssthresh = rescale(_ssthresh, _mss, mss);
+    _mss = mss;
+}
+
+uint64_t NewRenoController::pacing_rate() const {
+    // 与 Linux 相同：慢启动时按 2 倍、拥塞避免时按 1.2 倍的 cwnd/RTT 发送
+    return window_pacing_rate(_cwnd, _srtt_ms, _cwnd < _ssthresh ? 2.0 : 1.2);
+}
+
+CubicController::CubicController(const size_t mss)
+    : _mss(mss), _cwnd(initial_window(mss)), _ssthresh(numeric_limits<size_t>::max()) {}
+
+void CubicController::on_ack(const AckSample &ack) {
+    if (ack.rtt_ms.has_value()) {
+        const uint64_t rtt = clamp_rtt(*ack.rtt_ms);
+        smooth_rtt(_srtt_ms, rtt);
+        _min_rtt_ms = _min_rtt_ms == 0 ? rtt : min(_min_rtt_ms, rtt);
+    }
+    if (_cwnd < _ssthresh) {
+        _cwnd += min(ack.bytes_acked, 2 * _mss);
+        return;
+    }
+
+    const double mss = double(_mss);
+    const double w = double(_cwnd) / mss;
+    if (not _epoch_start_ms.has_value()) {
+        // 新的拥塞避免阶段：曲线在 K 秒后回到上次丢包前的窗口 W_max
+        _epoch_start_ms = ack.now_ms;
+        if (w < _w_max) {
+            _k = cbrt((_w_max - w) / C);
+            _origin = _w_max;
+        } else {
+            _k = 0;
+            _origin = w;
+        }
+        _w_est = w;
+    }
+
+    // 目标为一个 RTT 之后曲线上的窗口，且每个 RTT 最多增长一半
+    const double t = double(ack.now_ms - *_epoch_start_ms + _min_rtt_ms) / 1000;
+    double target = _origin + C * (t - _k) * (t - _k) * (t - _k);
+    target = min(max(target, w), 1.5 * w);
+
+    // TCP 友好区域：不比同样条件下的 Reno 增长得慢
+    _w_est += 3 * (1 - BETA) / (1 + BETA) * double(ack.bytes_acked) / double(_cwnd);
+    target = max(target, _w_est);
+
+    // 每确认一个窗口的数据，窗口增长 target - w 个 MSS
+    _growth_credit += (target - w) * mss * double(ack.bytes_acked) / double(_cwnd);
+    const double whole = floor(_growth_credit);
+    _cwnd += size_t(whole);
+    _growth_credit -= whole;
+}
+
+void CubicController::on_loss(const uint64_t /* now_ms */,
+                              const LossSignal signal,
+                              const size_t /* bytes_in_flight */) {
+    const double w = double(_cwnd) / double(_mss);
+    // 快速收敛：窗口比上次丢包时还小，说明有新的流加入，让出更多带宽
+    _w_max = w < _w_max ? w * (1 + BETA) / 2 : w;
+    _ssthresh = max(size_t(double(_cwnd) * BETA), 2 * _mss);
+    _cwnd = signal == LossSignal::Timeout ? _mss : _ssthresh;
+    _epoch_start_ms.reset();
+    _growth_credit = 0;
+}
+
+void CubicController::set_mss(const size_t mss) {
+    _cwnd = rescale(_cwnd, _mss, mss);
+    _ssthresh = rescale(_ssthresh, _mss, mss);
+    _mss = mss;
+}
+
+uint64_t CubicController::pacing_rate() const {
+    return window_pacing_rate(_cwnd, _srtt_ms, _cwnd < _ssthresh ? 2.0 : 1.2);
+}
+
+BBRController::BBRController(const size_t mss) : _mss(mss), _cwnd(initial_window(mss)) {}
+
+double BBRController::pacing_gain() const {
+    switch (_mode) {
+        case Mode::Startup:
+            return HIGH_GAIN;
+        case Mode::Drain:
+            return 1 / HIGH_GAIN;
+        case Mode::ProbeBW:
+            return PROBE_BW_GAINS[_cycle_index];
+        case Mode::ProbeRTT:
+            return 1;
+    }
+    return 1;
+}
+
+double BBRController::cwnd_gain() const { return _mode == Mode::ProbeBW ? 2 : HIGH_GAIN; }
+
+size_t BBRController::bdp(const double gain) const {
+    if (_btl_bw == 0 or not _min_rtt_ms.has_value()) {
+        return numeric_limits<size_t>::max();
+    }
+    return size_t(gain * double(_btl_bw) * double(*_min_rtt_ms) / 1000);
+}
+
+bool BBRController::update_round(const AckSample &ack) {
+    _delivered += ack.bytes_acked;
+    if (_delivered < _round_end_delivered) {
+        return false;
+    }
+    // 一轮结束：这一轮内的交付速率就是一个带宽样本，取最近若干轮的最大值
+    // 第 0 轮从构造时开始计时，不代表真实速率，因此不记录
+    if (_round_count > 0) {
+        const uint64_t elapsed = max(ack.now_ms - _round_start_ms, uint64_t(1));
+        _bw_samples[_round_count % BW_WINDOW_ROUNDS] = (_delivered - _round_start_delivered) * 1000 / elapsed;
+        _btl_bw = *max_element(_bw_samples.begin(), _bw_samples.end());
+    }
+    _round_count++;
+    _round_start_delivered = _delivered;
+    _round_start_ms = ack.now_ms;
+    _round_end_delivered = _delivered + ack.bytes_in_flight;
+    return true;
+}
+
+void BBRController::update_mode(const AckSample &ack, const bool round_ended) {
+    if (_mode == Mode::Startup and round_ended and _btl_bw > 0) {
+        // 带宽连续三轮增长不到 25%，说明瓶颈链路已被填满
+        if (_btl_bw >= _full_bw + _full_bw / 4) {
+            _full_bw = _btl_bw;
+            _full_bw_rounds = 0;
+        } else if (++_full_bw_rounds >= 3) {
+            _filled_pipe = true;
+            _mode = Mode::Drain;
+        }
+    }
+    if (_mode == Mode::Drain and ack.bytes_in_flight <= bdp(1)) {
+        // 排空启动阶段在瓶颈处积压的队列后进入稳态，从匀速的阶段开始
+        _mode = Mode::ProbeBW;
+        _cycle_index = 2;
+        _cycle_start_ms = ack.now_ms;
+    }
+    if (_mode == Mode::ProbeBW and _min_rtt_ms.has_value() and ack.now_ms - _cycle_start_ms >= *_min_rtt_ms) {
+        _cycle_index = (_cycle_index + 1) % PROBE_BW_GAINS.size();
+        _cycle_start_ms = ack.now_ms;
+    }
+    if (_mode == Mode::ProbeRTT and ack.now_ms >= _probe_rtt_done_ms) {
+        _mode = _filled_pipe ? Mode::ProbeBW : Mode::Startup;
+        _cycle_start_ms = ack.now_ms;
+        _cwnd = max(_cwnd, _saved_cwnd);
+    }
+}
+
+void BBRController::update_cwnd(const AckSample &ack) {
+    const size_t min_cwnd = 4 * _mss;
+    if (_mode == Mode::ProbeRTT) {
+        _cwnd = min(_cwnd, min_cwnd);
+        return;
+    }
+    const size_t target = max(bdp(cwnd_gain()), min_cwnd);
+    if (_filled_pipe) {
+        _cwnd = min(_cwnd + ack.bytes_acked, target);
+    } else if (_cwnd < target) {
+        _cwnd += ack.bytes_acked;
+    }
+    _cwnd = max(_cwnd, min_cwnd);
+}
+
+void BBRController::on_ack(const AckSample &ack) {
+    bool min_rtt_expired = false;
+    if (ack.rtt_ms.has_value()) {
+        const uint64_t rtt = clamp_rtt(*ack.rtt_ms);
+        min_rtt_expired = _min_rtt_ms.has_value() and ack.now_ms - _min_rtt_stamp_ms > MIN_RTT_WINDOW_MS;
+        if (not _min_rtt_ms.has_value() or rtt <= *_min_rtt_ms or min_rtt_expired) {
+            _min_rtt_ms = rtt;
+            _min_rtt_stamp_ms = ack.now_ms;
+        }
+    }
+
+    const bool round_ended = update_round(ack);
+    update_mode(ack, round_ended);
+
+    // 最小 RTT 太久没有刷新：把在途数据降到很少，以测到不含排队时延的 RTT
+    if (min_rtt_expired and _mode != Mode::ProbeRTT) {
+        _mode = Mode::ProbeRTT;
+        _saved_cwnd = _cwnd;
+        _probe_rtt_done_ms = ack.now_ms + max(PROBE_RTT_MS, *_min_rtt_ms);
+    }
+
+    update_cwnd(ack);
+}
+
+void BBRController::on_loss(const uint64_t /* now_ms */, const LossSignal signal, const size_t bytes_in_flight) {
+    // BBR 不把丢包当作拥塞信号，只在恢复期间遵守包守恒，窗口随后按确认的字节数恢复
+    _cwnd = signal == LossSignal::Timeout ? _mss : max(bytes_in_flight, _mss);
+}
+
+size_t BBRController::ssthresh() const { return numeric_limits<size_t>::max(); }
+
+void BBRController::set_mss(const size_t mss) {
+    _cwnd = rescale(_cwnd, _mss, mss);
+    _saved_cwnd = _saved_cwnd == 0 ? 0 : rescale(_saved_cwnd, _mss, mss);
+    _mss = mss;
+}
+
+uint64_t BBRController::pacing_rate() const {
+    if (_btl_bw == 0) {
+        // 还没有带宽样本时，按初始窗口和 RTT 估计
+        return _min_rtt_ms.has_value() ? window_pacing_rate(_cwnd, *_min_rtt_ms, HIGH_GAIN) : 0;
+    }
+    return uint64_t(pacing_gain() * double(_btl_bw));
+}
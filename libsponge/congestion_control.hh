@@ -0,0 +1,222 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+//! Congestion control algorithms the TCPSender can use
+enum class CongestionControl {
+    None,     //!< No congestion window: the sender is limited only by the receiver's window
+    NewReno,  //!< Slow start and AIMD congestion avoidance (RFC 5681, RFC 6582)
+    Cubic,    //!< CUBIC window growth (RFC 8312)
+    BBR,      //!< Model-based control from the estimated bottleneck bandwidth and minimum RTT
+};
+
+//! What the TCPSender learned from an acknowledgment that acknowledged new data
+struct AckSample {
+    uint64_t now_ms;                   //!< The sender's clock when the ACK arrived
+    size_t bytes_acked;                //!< Sequence space newly acknowledged by this ACK
+    size_t bytes_in_flight;            //!< Sequence space still outstanding after this ACK
+    std::optional<uint64_t> rtt_ms{};  //!< RTT of a newly acknowledged segment that was sent only once
+};
+
+//! Ways the TCPSender detects that a segment was lost
+enum class LossSignal {
+    Timeout,         //!< The retransmission timer expired
+    FastRetransmit,  //!< Duplicate acknowledgments showed a hole
+};
+
+//! \brief A congestion control algorithm, driven by the TCPSender.
+
+//! The sender reports acknowledgments and losses; the controller answers with the congestion
+//! window (how much may be in flight) and the pacing rate (how fast it should be sent).
+class CongestionController {
+  public:
+    virtual ~CongestionController() = default;
+
+    //! \brief An ACK acknowledged new data
+    virtual void on_ack(const AckSample &ack) = 0;
+
+    //! \brief A segment was found to be lost
+    //! \note Called once per loss event, not for each retransmission of the same segment
+    virtual void on_loss(uint64_t now_ms, LossSignal signal, size_t bytes_in_flight) = 0;
+
+    //! \brief The sender's segment size changed (MSS negotiation or path MTU discovery)
+    //! \details The window keeps its size in segments, as it would if it were counted in packets.
+    virtual void set_mss(size_t mss) = 0;
+
+    //! \brief Congestion window, in bytes of sequence space
+    virtual size_t cwnd() const = 0;
+
+    //! \brief Slow start threshold, in bytes (SIZE_MAX while it is unset)
+    virtual size_t ssthresh() const = 0;
+
+    //! \brief Rate at which to send, in bytes per second (0 until there is an RTT sample)
+    virtual uint64_t pacing_rate() const = 0;
+
+    //! \brief Short name of the algorithm, for logging
+    virtual std::string_view name() const = 0;
+};
+
+//! \brief Make a controller for segments of at most `mss` bytes
+//! \returns nullptr for CongestionControl::None
+std::unique_ptr<CongestionController> make_congestion_controller(CongestionControl algorithm, size_t mss);
+
+//! Slow start, then one MSS of growth per RTT; halve the window on loss.
+class NewRenoController : public CongestionController {
+  private:
+    size_t _mss;
+    size_t _cwnd;
+    size_t _ssthresh;
+
+    //! Bytes acknowledged in congestion avoidance that have not yet grown the window
+    size_t _avoidance_credit{0};
+
+    //! Smoothed RTT (zero until the first sample), used only for the pacing rate
+    uint64_t _srtt_ms{0};
+
+  public:
+    explicit NewRenoController(size_t mss);
+
+    void on_ack(const AckSample &ack) override;
+    void on_loss(uint64_t now_ms, LossSignal signal, size_t bytes_in_flight) override;
+    void set_mss(size_t mss) override;
+
+    size_t cwnd() const override { return _cwnd; }
+    size_t ssthresh() const override { return _ssthresh; }
+    uint64_t pacing_rate() const override;
+    std::string_view name() const override { return "newreno"; }
+};
+
+//! Grow the window along a cubic curve centred on the size at the last loss.
+class CubicController : public CongestionController {
+  private:
+    static constexpr double C = 0.4;     //!< Scaling constant, in MSS per second cubed
+    static constexpr double BETA = 0.7;  //!< Multiplicative decrease factor
+
+    size_t _mss;
+    size_t _cwnd;
+    size_t _ssthresh;
+
+    //! Window size (in MSS) just before the last reduction
+    double _w_max{0};
+
+    //! Start of the current congestion avoidance epoch, if one has started
+    std::optional<uint64_t> _epoch_start_ms{};
+
+    //! Seconds the cubic curve takes to climb back to its origin
+    double _k{0};
+
+    //! Window (in MSS) at the plateau of the current curve
+    double _origin{0};
+
+    //! Estimate (in MSS) of the window standard Reno would have reached in this epoch
+    double _w_est{0};
+
+    //! Growth (in bytes) owed to the window but smaller than a byte so far
+    double _growth_credit{0};
+
+    uint64_t _min_rtt_ms{0};
+    uint64_t _srtt_ms{0};
+
+  public:
+    explicit CubicController(size_t mss);
+
+    void on_ack(const AckSample &ack) override;
+    void on_loss(uint64_t now_ms, LossSignal signal, size_t bytes_in_flight) override;
+    void set_mss(size_t mss) override;
+
+    size_t cwnd() const override { return _cwnd; }
+    size_t ssthresh() const override { return _ssthresh; }
+    uint64_t pacing_rate() const override;
+    std::string_view name() const override { return "cubic"; }
+};
+
+//! \brief Control the sender from a model of the path rather than from losses.
+
+//! The controller estimates the bottleneck bandwidth (the highest delivery rate seen over the
+//! last few round trips) and the round-trip propagation delay (the lowest RTT seen recently).
+//! It paces at a multiple of the bandwidth and caps the window at a multiple of their product,
+//! cycling through the Startup, Drain, ProbeBW and ProbeRTT phases of BBR.
+class BBRController : public CongestionController {
+  public:
+    enum class Mode { Startup, Drain, ProbeBW, ProbeRTT };
+
+  private:
+    static constexpr double HIGH_GAIN = 2.885;  //!< 2/ln(2): doubles the sending rate every round
+    static constexpr size_t BW_WINDOW_ROUNDS = 10;
+    static constexpr uint64_t MIN_RTT_WINDOW_MS = 10000;
+    static constexpr uint64_t PROBE_RTT_MS = 200;
+    static constexpr std::array<double, 8> PROBE_BW_GAINS{1.25, 0.75, 1, 1, 1, 1, 1, 1};
+
+    size_t _mss;
+    size_t _cwnd;
+    Mode _mode{Mode::Startup};
+
+    //! Delivery rate (bytes per second) measured in each of the last BW_WINDOW_ROUNDS rounds
+    std::array<uint64_t, BW_WINDOW_ROUNDS> _bw_samples{};
+    uint64_t _btl_bw{0};
+
+    std::optional<uint64_t> _min_rtt_ms{};
+    uint64_t _min_rtt_stamp_ms{0};
+
+    //! \name Round-trip counting: a round ends once everything in flight at its start is acknowledged
+    //!@{
+    uint64_t _delivered{0};
+    uint64_t _round_count{0};
+    uint64_t _round_end_delivered{0};
+    uint64_t _round_start_delivered{0};
+    uint64_t _round_start_ms{0};
+    //!@}
+
+    //! \name Startup ends once the bandwidth stops growing by 25% for three rounds
+    //!@{
+    uint64_t _full_bw{0};
+    unsigned _full_bw_rounds{0};
+    bool _filled_pipe{false};
+    //!@}
+
+    size_t _cycle_index{0};
+    uint64_t _cycle_start_ms{0};
+
+    uint64_t _probe_rtt_done_ms{0};
+    size_t _saved_cwnd{0};
+
+    double pacing_gain() const;
+    double cwnd_gain() const;
+
+    //! Bandwidth-delay product scaled by `gain`, in bytes
+    size_t bdp(double gain) const;
+
+    //! \returns `true` if the ACK ended a round trip (and so produced a bandwidth sample)
+    bool update_round(const AckSample &ack);
+    void update_mode(const AckSample &ack, bool round_ended);
+    void update_cwnd(const AckSample &ack);
+
+  public:
+    explicit BBRController(size_t mss);
+
+    void on_ack(const AckSample &ack) override;
+    void on_loss(uint64_t now_ms, LossSignal signal, size_t bytes_in_flight) override;
+    void set_mss(size_t mss) override;
+
+    size_t cwnd() const override { return _cwnd; }
+    size_t ssthresh() const override;
+    uint64_t pacing_rate() const override;
+    std::string_view name() const override { return "bbr"; }
+
+    //! \brief Current phase of the state machine
+    Mode mode() const { return _mode; }
+
+    //! \brief Estimated bottleneck bandwidth, in bytes per second
+    uint64_t bottleneck_bandwidth() const { return _btl_bw; }
+
+    //! \brief Estimated round-trip propagation delay, in milliseconds
+    std::optional<uint64_t> min_rtt() const { return _min_rtt_ms; }
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
@@ -0,0 +1,70 @@
+#include "route_table.hh"
+
+#include <stdexcept>
+
+using namespace std;
+
+RouteTable::RouteTable() : _root(size_t(1) << ROOT_BITS, 0) {}
+
+//! \param[in] table the table (_root or _children) that holds the entry
+//! \param[in] slot position of the entry in `table`
+//! \returns the index of the child table below the entry, which is created if the entry was a leaf
+size_t RouteTable::child_of(vector<Entry> &table, const size_t slot) {
+    if (is_child(table[slot])) {
+        return table[slot] & ~CHILD_FLAG;
+    }
+    // 新建的子表中每一项都继承原叶子（叶子下推），这样查找时无需回溯
+    const Entry inherited = table[slot];
+    const size_t index = _children.size() / CHILD_SIZE;
+    _children.resize(_children.size() + CHILD_SIZE, inherited);
+    // table 可能就是 _children，扩容后只能通过下标重新访问
+    table[slot] = CHILD_FLAG | index;
+    return index;
+}
+
+//! \param[in] table the table (_root or _children) to update
+//! \param[in] first position of the first entry covered by the prefix
+//! \param[in] count number of consecutive entries covered by the prefix
+//! \param[in] leaf the new prefix's leaf
+void RouteTable::cover(vector<Entry> &table, const size_t first, const size_t count, const Entry leaf) {
+    const uint8_t length = leaf_length(leaf);
+    for (size_t slot = first; slot < first + count; slot++) {
+        const Entry entry = table[slot];
+        if (is_child(entry)) {
+            // 子表中可能已有更长的前缀，只覆盖比新前缀短的叶子
+            cover(_children, (entry & ~CHILD_FLAG) * CHILD_SIZE, CHILD_SIZE, leaf);
+        } else if (leaf_empty(entry) or leaf_length(entry) < length) {
+            table[slot] = leaf;
+        }
+    }
+}
+
+void RouteTable::insert(uint32_t prefix, const uint8_t length, const size_t value) {
+    if (length > 32) {
+        throw runtime_error("RouteTable: prefix length must be at most 32");
+    }
+    if (value >= MAX_VALUES) {
+        throw runtime_error("RouteTable: too many routes");
+    }
+    // 只保留前 length 位（length 为 0 时不能移位 32 位）
+    prefix = length == 0 ? 0 : prefix & (~uint32_t(0) << (32 - length));
+    const Entry leaf = (Entry(length) << LENGTH_SHIFT) | Entry(value + 1);
+
+    // 第一级：前缀不超过 16 位时覆盖一段连续的根表项
+    if (length <= ROOT_BITS) {
+        cover(_root, prefix >> ROOT_BITS, size_t(1) << (ROOT_BITS - length), leaf);
+        return;
+    }
+
+    // 第二级：地址的第 17 到 24 位
+    const size_t second = child_of(_root, prefix >> ROOT_BITS);
+    const size_t second_slot = (prefix >> CHILD_BITS) & 0xff;
+    if (length <= ROOT_BITS + CHILD_BITS) {
+        cover(_children, second * CHILD_SIZE + second_slot, size_t(1) << (ROOT_BITS + CHILD_BITS - length), leaf);
+        return;
+    }
+
+    // 第三级：地址的最后 8 位
+    const size_t third = child_of(_children, second * CHILD_SIZE + second_slot);
+    cover(_children, third * CHILD_SIZE + (prefix & 0xff), size_t(1) << (32 - length), leaf);
+}
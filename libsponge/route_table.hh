@@ -0,0 +1,80 @@
+#ifndef SPONGE_LIBSPONGE_ROUTE_TABLE_HH
+#define SPONGE_LIBSPONGE_ROUTE_TABLE_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+//! \brief A longest-prefix-match table over IPv4 addresses.
+
+//! The table is a multibit trie with strides of 16, 8 and 8 bits (in the style of DIR-24-8),
+//! so a lookup touches at most three table entries no matter how many prefixes are stored.
+//! Shorter prefixes are pushed down into the leaves they cover, so a lookup never has to
+//! backtrack: the entry it finds in the deepest table is already the longest match.
+class RouteTable {
+  private:
+    //! An entry is either a leaf (the route that wins for the addresses it covers, or none)
+    //! or a pointer to a child table that splits it further.
+    //! - bit 31: set if the entry points at a child table (the low bits are the child's index)
+    //! - bits 24-29: length of the prefix that owns the leaf
+    //! - bits 0-23: index of the owning route plus one (zero if no route covers the leaf)
+    using Entry = uint32_t;
+
+    static constexpr Entry CHILD_FLAG = 1u << 31;
+    static constexpr unsigned LENGTH_SHIFT = 24;
+    static constexpr Entry VALUE_MASK = (1u << LENGTH_SHIFT) - 1;
+
+    static constexpr unsigned ROOT_BITS = 16;
+    static constexpr unsigned CHILD_BITS = 8;
+    static constexpr size_t CHILD_SIZE = size_t(1) << CHILD_BITS;
+
+    //! The first level, indexed by the top 16 bits of the address
+    std::vector<Entry> _root;
+
+    //! Every second- and third-level table, CHILD_SIZE entries each, stored back to back
+    std::vector<Entry> _children{};
+
+    //! Number of route values that may be stored (limited by the width of an entry)
+    static constexpr size_t MAX_VALUES = VALUE_MASK;
+
+    static bool is_child(const Entry entry) { return entry & CHILD_FLAG; }
+    static uint8_t leaf_length(const Entry entry) { return (entry >> LENGTH_SHIFT) & 0x3f; }
+    static bool leaf_empty(const Entry entry) { return (entry & VALUE_MASK) == 0; }
+
+    //! Index of the child table below `table[slot]`, splitting the leaf there if needed
+    size_t child_of(std::vector<Entry> &table, const size_t slot);
+
+    //! Store `leaf` in `count` entries of `table`, wherever it is longer than the current leaf
+    void cover(std::vector<Entry> &table, const size_t first, const size_t count, const Entry leaf);
+
+  public:
+    RouteTable();
+
+    //! \brief Add a prefix to the table
+    //! \param[in] prefix the address prefix (bits after the first `length` bits are ignored)
+    //! \param[in] length the number of significant bits of `prefix`, at most 32
+    //! \param[in] value what lookup() returns for addresses that match this prefix best
+    //! \note If the same prefix is added twice, the first value is kept.
+    void insert(uint32_t prefix, uint8_t length, size_t value);
+
+    //! \brief Find the value of the longest prefix that matches `address`, if any
+    std::optional<size_t> lookup(const uint32_t address) const {
+        Entry entry = _root[address >> ROOT_BITS];
+        if (is_child(entry)) {
+            entry = _children[(entry & ~CHILD_FLAG) * CHILD_SIZE + ((address >> CHILD_BITS) & 0xff)];
+            if (is_child(entry)) {
+                entry = _children[(entry & ~CHILD_FLAG) * CHILD_SIZE + (address & 0xff)];
+            }
+        }
+        if (leaf_empty(entry)) {
+            return std::nullopt;
+        }
+        return (entry & VALUE_MASK) - 1;
+    }
+
+    //! \brief Memory used by the trie's tables, in bytes
+    size_t memory_usage() const { return (_root.size() + _children.size()) * sizeof(Entry); }
+};
+
+#endif  // SPONGE_LIBSPONGE_ROUTE_TABLE_HH
@@ -1,6 +1,18 @@
 #include "router.hh"
 
+#include "spsc_ring.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 
 using namespace std;
 
@@ -30,48 +42,271 @@ void Router::add_route(const uint32_t route_prefix,
          << " => " << (next_hop.has_value() ? next_hop->ip() : "(direct)") << " on interface " << interface_num << "\n";
 
     // Your code here.
-    _routes.insert({route_prefix, prefix_length, next_hop, interface_num});
+    _table.insert(route_prefix, prefix_length, _routes.size());
+    _routes.push_back({route_prefix, prefix_length, next_hop, interface_num});
 }
 
-//! \param[in] dgram The datagram to be routed
-void Router::route_one_datagram(InternetDatagram &dgram) {
-    const Route* route = nullptr;
-    // 1.路由器在路由表中查找数据报目的地址匹配的路由，即目的地址的最长prefix_length与route_prefix的最长prefix_length相同。
-    // 2.在匹配的路由中，路由器选择prefix_length最长的路由。
-    for (auto &item : _routes){
-        //这里如果prefix_length为0，那么左移时会出现bug（左移size超过类型大小），所以需要特殊处理
-        uint32_t ip = item.prefix_length == 0 ? 0 : (dgram.header().dst>>(32-item.prefix_length))<<(32-item.prefix_length);
-        if(ip==item.route_prefix){
-            route = &item;
-            break;
+//! Rings and round state shared by the workers, allocated once when the Router is constructed
+struct Router::Mesh {
+    const size_t workers;  //!< workers in the pool, including the thread that calls route()
+
+    //! `rings[from * workers + to]` carries datagrams from worker `from` to worker `to`
+    vector<unique_ptr<SPSCRing<Forward>>> rings{};
+
+    //! Workers taking part in the current round; interface `i` belongs to worker `i % active`
+    size_t active{1};
+
+    //! Number of workers that have drained their own interfaces
+    atomic<size_t> producers_done{0};
+
+    //! Set when a worker throws, so that the others stop waiting for it
+    atomic<bool> failed{false};
+    mutex error_mutex{};
+    exception_ptr error{};
+
+    //! \name Start and end of each round, guarded by `round_mutex`
+    //!@{
+    mutex round_mutex{};
+    condition_variable round_started{};
+    condition_variable round_finished{};
+    uint64_t round{0};     //!< rounds started by route()
+    size_t finished{0};    //!< worker threads done with the current round
+    bool stopping{false};  //!< set when the router is destroyed
+    //!@}
+
+    Mesh(const size_t workers_, const size_t ring_capacity) : workers(workers_) {
+        for (size_t i = 0; workers > 1 and i < workers * workers; i++) {
+            rings.push_back(make_unique<SPSCRing<Forward>>(ring_capacity));
         }
     }
-    // 3.如果没有匹配的路由，则丢弃该数据报。
-    if(route == nullptr){
-        return;
+
+    SPSCRing<Forward> &ring(const size_t from, const size_t to) { return *rings[from * workers + to]; }
+
+    void fail(exception_ptr e) {
+        lock_guard<mutex> lock{error_mutex};
+        if (not error) {
+            error = e;
+        }
+        failed = true;
     }
-    // 4.路由器减少数据报的TTL（存活时间）。如果TTL已经为零，或者在减少之后达到零，路由器应该丢弃数据报。
-    if(dgram.header().ttl <= 1){
-        dgram.header().ttl = 0;
-        return;
+
+    //! Forget the state of a failed round, including datagrams left in the rings
+    void reset() {
+        producers_done = 0;
+        failed = false;
+        error = nullptr;
+        Forward forward;
+        for (auto &ring : rings) {
+            while (ring->try_pop(forward)) {
+            }
+        }
     }
-    dgram.header().ttl--;
-    // 5.否则，路由器将修改后的数据报从接口发送到适当的下一跳（interface(interface_num).send_datagram()）。
-    if(route->next_hop.has_value()){
-        interface(route->interface_num).send_datagram(dgram, route->next_hop.value());
+};
+
+Router::Router(const RouterConfig &cfg)
+    : _cfg(cfg), _stats(max<size_t>(cfg.workers, 1)), _mesh(make_unique<Mesh>(_stats.size(), cfg.ring_capacity)) {
+    if (_cfg.batch_size == 0) {
+        throw runtime_error("Router: batch_size must be positive");
     }
-    else{
-        interface(route->interface_num).send_datagram(dgram, Address::from_ipv4_numeric(dgram.header().dst));
+    try {
+        for (size_t worker = 1; worker < _mesh->workers; worker++) {
+            _threads.emplace_back(&Router::pool_thread, this, worker);
+        }
+    } catch (...) {
+        stop_pool();
+        throw;
     }
 }
 
+Router::~Router() { stop_pool(); }
+
+void Router::stop_pool() {
+    {
+        lock_guard<mutex> lock{_mesh->round_mutex};
+        _mesh->stopping = true;
+    }
+    _mesh->round_started.notify_all();
+    for (auto &thread : _threads) {
+        thread.join();
+    }
+    _threads.clear();
+}
+
+//! \param[in] worker index of the calling worker (at least 1)
+void Router::pool_thread(const size_t worker) {
+    Mesh &mesh = *_mesh;
+    uint64_t seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> lock{mesh.round_mutex};
+            mesh.round_started.wait(lock, [&] { return mesh.stopping or mesh.round != seen; });
+            if (mesh.stopping) {
+                return;
+            }
+            seen = mesh.round;
+        }
+        // 接口数少于线程数时，多余的线程不参与这一轮
+        if (worker < mesh.active) {
+            run_guarded(worker);
+        }
+        {
+            lock_guard<mutex> lock{mesh.round_mutex};
+            mesh.finished++;
+        }
+        mesh.round_finished.notify_one();
+    }
+}
+
+//! \param[in] worker index of the calling worker
+void Router::run_guarded(const size_t worker) {
+    try {
+        run_worker(worker, *_mesh);
+    } catch (...) {
+        _mesh->fail(current_exception());
+    }
+}
+
+//! \param[in] forward a datagram whose route has been looked up
+//! \param[in,out] stats counters of the calling worker
+void Router::send(Forward &forward, RouterWorkerStats &stats) {
+    _interfaces.at(forward.interface_num).send_datagram(forward.dgram, Address::from_ipv4_numeric(forward.next_hop));
+    stats.datagrams_sent++;
+}
+
+//! \param[in] worker index of the calling worker
+//! \param[in,out] batch datagrams taken from the worker's interfaces
+//! \param[in] mesh state shared with the other workers
+void Router::forward_batch(const size_t worker, vector<Forward> &batch, Mesh &mesh) {
+    RouterWorkerStats &stats = _stats[worker];
+    stats.batches++;
+    stats.datagrams_in += batch.size();
+
+    // 1.先对整批数据报查找最长前缀匹配的路由并减少TTL，各次查找互不依赖，访存可以重叠。
+    for (auto &forward : batch) {
+        const IPv4Header &header = as_const(forward.dgram).header();
+        const auto match = _table.lookup(header.dst);
+        // 没有匹配的路由，或者TTL已经为零、减少后为零，都丢弃该数据报。
+        if (not match.has_value() or header.ttl <= 1) {
+            forward.dropped = true;
+            continue;
+        }
+        // 只改写已解析首部中的TTL字节，并按RFC 1624增量更新校验和，发送时无需重新序列化首部
+        forward.dgram.decrement_ttl();
+        const Route &route = _routes[match.value()];
+        forward.interface_num = route.interface_num;
+        // 直连网络的下一跳就是数据报的最终目的地址
+        forward.next_hop = route.next_hop.has_value() ? route.next_hop->ipv4_numeric() : header.dst;
+    }
+
+    // 2.再把数据报从出接口发往下一跳；出接口属于其他线程时，放入通往该线程的环。
+    for (auto &forward : batch) {
+        if (forward.dropped) {
+            stats.datagrams_dropped++;
+            continue;
+        }
+        const size_t owner = forward.interface_num % mesh.active;
+        if (owner == worker) {
+            send(forward, stats);
+            continue;
+        }
+        auto &ring = mesh.ring(worker, owner);
+        while (not ring.try_push(forward)) {
+            // 环已满：先转发别的线程交给自己的数据报，避免两个线程互相等待
+            if (mesh.failed) {
+                return;
+            }
+            drain_handoffs(worker, mesh);
+            this_thread::yield();
+        }
+        stats.handed_off++;
+    }
+}
+
+//! \param[in] worker index of the calling worker
+//! \param[in] mesh state shared with the other workers
+void Router::drain_handoffs(const size_t worker, Mesh &mesh) {
+    Forward forward;
+    for (size_t from = 0; from < mesh.active; from++) {
+        if (from == worker) {
+            continue;
+        }
+        auto &ring = mesh.ring(from, worker);
+        while (ring.try_pop(forward)) {
+            send(forward, _stats[worker]);
+        }
+    }
+}
+
+//! \param[in] worker index of the calling worker
+//! \param[in] mesh state shared with the other workers
+void Router::run_worker(const size_t worker, Mesh &mesh) {
+    const auto start = chrono::steady_clock::now();
+    vector<Forward> batch;
+    batch.reserve(_cfg.batch_size);
+
+    // 1.按批取出本线程负责的接口收到的数据报（移动而不是拷贝），查找路由后转发。
+    for (size_t i = worker; i < _interfaces.size() and not mesh.failed; i += mesh.active) {
+        auto &queue = _interfaces[i].datagrams_out();
+        while (not queue.empty() and not mesh.failed) {
+            while (not queue.empty() and batch.size() < _cfg.batch_size) {
+                batch.push_back({move(queue.front()), 0, 0, false});
+                queue.pop();
+            }
+            forward_batch(worker, batch, mesh);
+            batch.clear();
+            drain_handoffs(worker, mesh);
+        }
+    }
+
+    // 2.自己的接口处理完后，继续转发其他线程交来的数据报，直到所有线程都处理完自己的接口。
+    //   先读取完成计数再清空环：计数达到线程数时，所有放入环的数据报都已可见。
+    mesh.producers_done.fetch_add(1, memory_order_release);
+    while (not mesh.failed) {
+        const bool all_done = mesh.producers_done.load(memory_order_acquire) == mesh.active;
+        drain_handoffs(worker, mesh);
+        if (all_done) {
+            break;
+        }
+        this_thread::yield();
+    }
+
+    _stats[worker].busy_ns += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
 void Router::route() {
     // Go through all the interfaces, and route every incoming datagram to its proper outgoing interface.
+    // 每个接口只属于一个线程（接口 i 属于线程 i % active），该线程负责取出它收到的数据报，
+    // 也是唯一在它上面发送的线程，因此 NetworkInterface 本身无需加锁。
+    Mesh &mesh = *_mesh;
+    mesh.active = max<size_t>(min(mesh.workers, _interfaces.size()), 1);
+    // 等待转发的数据报不足一批时，唤醒其他线程的开销比转发本身还大，由调用线程独自转发
+    size_t waiting = 0;
     for (auto &interface : _interfaces) {
-        auto &queue = interface.datagrams_out();
-        while (not queue.empty()) {
-            route_one_datagram(queue.front());
-            queue.pop();
-        }
+        waiting += interface.datagrams_out().size();
+    }
+    if (mesh.active == 1 or waiting < _cfg.batch_size) {
+        mesh.active = 1;
+        mesh.producers_done = 0;
+        run_worker(0, mesh);
+        return;
+    }
+
+    // 开始新的一轮：线程在获得 round_mutex 后才读取 active 和各接口，因此能看到这里之前的所有写入
+    mesh.producers_done = 0;
+    {
+        lock_guard<mutex> lock{mesh.round_mutex};
+        mesh.finished = 0;
+        mesh.round++;
+    }
+    mesh.round_started.notify_all();
+    run_guarded(0);
+    {
+        unique_lock<mutex> lock{mesh.round_mutex};
+        mesh.round_finished.wait(lock, [&] { return mesh.finished == _threads.size(); });
+    }
+    if (mesh.error) {
+        const exception_ptr error = mesh.error;
+        mesh.reset();
+        rethrow_exception(error);
     }
 }
@@ -2,10 +2,14 @@
 #define SPONGE_LIBSPONGE_ROUTER_HH
 
 #include "network_interface.hh"
+#include "route_table.hh"
 
+#include <cstdint>
+#include <memory>
 #include <optional>
 #include <queue>
-#include <set>
+#include <thread>
+#include <vector>
 
 //! \brief A wrapper for NetworkInterface that makes the host-side
 //! interface asynchronous: instead of returning received datagrams
@@ -39,33 +43,103 @@ class AsyncNetworkInterface : public NetworkInterface {
     std::queue<InternetDatagram> &datagrams_out() { return _datagrams_out; }
 };
 
+//! \brief How a Router spreads its forwarding work
+struct RouterConfig {
+    //! Number of threads that forward datagrams. Interface `i` is owned by worker `i % workers`,
+    //! which drains its incoming datagrams and is the only thread that sends on it.
+    size_t workers = 1;
+    size_t batch_size = 32;       //!< datagrams looked up together before any of them is sent
+    size_t ring_capacity = 1024;  //!< slots in each worker-to-worker ring (a power of two)
+};
+
+//! \brief Forwarding counters of one Router worker, accumulated over every call to Router::route()
+//! \note Each worker's counters get a cache line of their own, so workers updating theirs do not contend
+struct alignas(64) RouterWorkerStats {
+    uint64_t datagrams_in{};       //!< datagrams taken from the worker's own interfaces
+    uint64_t datagrams_sent{};     //!< datagrams sent on the worker's own interfaces
+    uint64_t datagrams_dropped{};  //!< datagrams with no route, or whose TTL expired
+    uint64_t handed_off{};         //!< datagrams passed to another worker's ring
+    uint64_t batches{};            //!< batches of lookups performed
+    uint64_t busy_ns{};            //!< time spent inside Router::route()
+
+    //! Datagrams taken in per second of busy time
+    double datagrams_per_second() const { return busy_ns == 0 ? 0 : datagrams_in * 1e9 / busy_ns; }
+};
+
 //! \brief A router that has multiple network interfaces and
 //! performs longest-prefix-match routing between them.
 class Router {
     //! The router's collection of network interfaces
     std::vector<AsyncNetworkInterface> _interfaces{};
 
-    //! Send a single datagram from the appropriate outbound interface to the next hop,
-    //! as specified by the route with the longest prefix_length that matches the
-    //! datagram's destination address.
-    void route_one_datagram(InternetDatagram &dgram);
+    //! How forwarding is spread across threads
+    RouterConfig _cfg{};
+
+    //! Counters for each worker
+    std::vector<RouterWorkerStats> _stats{};
+
+    //! A datagram whose route has been looked up, on its way to the outbound interface
+    struct Forward {
+        InternetDatagram dgram{};
+        uint32_t next_hop{};
+        size_t interface_num{};
+        bool dropped{};
+    };
+
+    //! Rings and round state shared by the workers, kept for the router's whole lifetime
+    struct Mesh;
+    std::unique_ptr<Mesh> _mesh;
+
+    //! Workers 1 and up (worker 0 is the thread that calls route()), started by the constructor
+    std::vector<std::thread> _threads{};
+
+    //! Body of a worker thread: take part in each round started by route(), until the router is destroyed
+    void pool_thread(const size_t worker);
+
+    //! Forward as worker `worker`, recording any exception in the mesh rather than throwing it
+    void run_guarded(const size_t worker);
+
+    //! Tell the worker threads to exit, and wait for them
+    void stop_pool();
+
+    //! Forward every datagram waiting on the interfaces owned by worker `worker`
+    void run_worker(const size_t worker, Mesh &mesh);
+
+    //! Look up and decrement the TTL of every datagram in `batch`, then send or hand each one off
+    void forward_batch(const size_t worker, std::vector<Forward> &batch, Mesh &mesh);
+
+    //! Send the datagrams that other workers handed to worker `worker`
+    void drain_handoffs(const size_t worker, Mesh &mesh);
+
+    //! Send a datagram on one of the calling worker's own interfaces
+    void send(Forward &forward, RouterWorkerStats &stats);
 
     struct Route {
         uint32_t route_prefix{};
         uint8_t prefix_length{};
         std::optional<Address> next_hop{};
         size_t interface_num{};
-        bool operator<(const Route &other) const {
-            if (prefix_length != other.prefix_length) {
-                return prefix_length > other.prefix_length;
-            }
-            return route_prefix > other.route_prefix;
-        }
     };
 
-    std::set<Route> _routes{};
+    //! Every route that has been added, in order
+    std::vector<Route> _routes{};
+
+    //! Longest-prefix-match index from destination address to position in `_routes`
+    RouteTable _table{};
 
   public:
+    //! Construct a router that forwards on the calling thread
+    Router() : Router(RouterConfig{}) {}
+
+    //! Construct a router that spreads forwarding as described by `cfg`
+    //! \note Starts `cfg.workers - 1` threads, which wait between calls to route()
+    explicit Router(const RouterConfig &cfg);
+    ~Router();
+
+    //! The worker threads refer to the router, so it cannot be copied or moved
+    Router(const Router &other) = delete;
+    Router &operator=(const Router &other) = delete;
+
     //! Add an interface to the router
     //! \param[in] interface an already-constructed network interface
     //! \returns The index of the interface after it has been added to the router
@@ -85,6 +159,9 @@ class Router {
 
     //! Route packets between the interfaces
     void route();
+
+    //! Forwarding counters, one entry per worker
+    const std::vector<RouterWorkerStats> &worker_stats() const { return _stats; }
 };
 
 #endif  // SPONGE_LIBSPONGE_ROUTER_HH
@@ -0,0 +1,27 @@
+#include "rtt_estimator.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+RTTEstimator::RTTEstimator(const uint64_t initial_rto_ms, const uint64_t min_rto_ms, const uint64_t max_rto_ms)
+    : _min_rto_ms(min_rto_ms), _max_rto_ms(max(min_rto_ms, max_rto_ms)), _rto_ms(initial_rto_ms) {}
+
+void RTTEstimator::add_sample(const uint64_t rtt_ms) {
+    const double r = double(rtt_ms);
+    if (not _srtt_ms.has_value()) {
+        // 第一个样本 (RFC 6298 2.2)
+        _srtt_ms = r;
+        _rttvar_ms = r / 2;
+    } else {
+        // 之后的样本：先用旧的 SRTT 更新 RTTVAR，再更新 SRTT (RFC 6298 2.3)
+        _rttvar_ms = 0.75 * _rttvar_ms + 0.25 * fabs(*_srtt_ms - r);
+        _srtt_ms = 0.875 * *_srtt_ms + 0.125 * r;
+    }
+    const double rto = *_srtt_ms + max(double(GRANULARITY_MS), 4 * _rttvar_ms);
+    _rto_ms = min(max(uint64_t(ceil(rto)), _min_rto_ms), _max_rto_ms);
+    _samples++;
+}
+
+uint64_t RTTEstimator::clamp(const uint64_t rto_ms) const { return min(rto_ms, _max_rto_ms); }
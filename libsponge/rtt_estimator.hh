@@ -0,0 +1,49 @@
+#ifndef SPONGE_LIBSPONGE_RTT_ESTIMATOR_HH
+#define SPONGE_LIBSPONGE_RTT_ESTIMATOR_HH
+
+#include <cstdint>
+#include <optional>
+
+//! \brief Round-trip time estimator and retransmission timeout, as specified by RFC 6298.
+
+//! Until the first measurement the timeout is the configured initial value. After that it is
+//! SRTT + max(G, 4 * RTTVAR), clamped to [min_rto, max_rto], where G is the clock granularity.
+//! Callers must only pass samples from segments that were not retransmitted (Karn's algorithm).
+class RTTEstimator {
+  private:
+    uint64_t _min_rto_ms;
+    uint64_t _max_rto_ms;
+
+    std::optional<double> _srtt_ms{};
+    double _rttvar_ms{0};
+    uint64_t _rto_ms;
+    uint64_t _samples{0};
+
+  public:
+    static constexpr uint64_t GRANULARITY_MS = 1;  //!< The sender's clock ticks in milliseconds
+
+    //! \param[in] initial_rto_ms timeout to use before any RTT has been measured
+    //! \param[in] min_rto_ms lower bound on the computed timeout
+    //! \param[in] max_rto_ms upper bound on the computed timeout
+    RTTEstimator(uint64_t initial_rto_ms, uint64_t min_rto_ms, uint64_t max_rto_ms);
+
+    //! \brief Fold in a measured round-trip time
+    void add_sample(uint64_t rtt_ms);
+
+    //! \brief Retransmission timeout, in milliseconds (before any exponential backoff)
+    uint64_t rto() const { return _rto_ms; }
+
+    //! \brief Smoothed round-trip time, if any sample has been taken
+    std::optional<double> srtt() const { return _srtt_ms; }
+
+    //! \brief Round-trip time variation
+    double rttvar() const { return _rttvar_ms; }
+
+    //! \brief Number of samples taken
+    uint64_t samples() const { return _samples; }
+
+    //! \brief Clamp a (backed-off) timeout to the configured maximum
+    uint64_t clamp(uint64_t rto_ms) const;
+};
+
+#endif  // SPONGE_LIBSPONGE_RTT_ESTIMATOR_HH
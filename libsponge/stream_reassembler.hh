@@ -4,15 +4,24 @@
 #include "byte_stream.hh"
 
 #include <cstdint>
-#include <string>
 #include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
   private:
     // Your code here -- add private members as necessary.
-    std::map<size_t, std::string> _unassemble_strs;
+
+    //! 乱序字节的暂存区：下标为 idx 的字节保存在 idx % _capacity 处（首次乱序到达时才分配）
+    std::vector<char> _ring;
+    //! 暂存区中已经收到的字节区间 [first, second)，区间之间互不重叠也不相邻
+    std::map<size_t, size_t> _unassembled_ranges;
+    //! 输出流为 Chunks 模式时改为暂存原始报文负载的 Buffer 分片（以起始下标为键，互不重叠）
+    std::map<size_t, Buffer> _unassembled_chunks;
     size_t _next_assembled_idx;
     size_t _unassembled_bytes_num;
     size_t _eof_idx;
@@ -20,11 +29,23 @@ class StreamReassembler {
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
 
+    //! 装配的核心逻辑；`owner` 非空时 `data` 是它的视图，按序到达的部分可以不经拷贝直接写入 _output
+    void _push(const std::string_view data, const Buffer *owner, const uint64_t index, const bool eof);
+
+    //! 把 [start, start + bytes.size()) 写入环形暂存区并合并区间
+    void _store_ring(const size_t start, const std::string_view bytes);
+
+    //! 把一个 Buffer 分片（截掉与已有分片重叠的部分后）加入 _unassembled_chunks
+    void _store_chunk(size_t start, Buffer chunk);
+
+    //! 字节流已装配到 `end` 之后，丢弃被覆盖的暂存数据，并把与之相接的部分写入 _output
+    void _flush(const size_t end);
+
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    StreamReassembler(const size_t capacity, const ByteStream::Storage storage = ByteStream::Storage::Ring);
 
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
@@ -36,6 +57,14 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a refcounted Buffer.
+    //!
+    //! When the substring continues the assembled stream, the (trimmed) Buffer is handed
+    //! to the output stream directly. If the output stream is in Chunks mode, out-of-order
+    //! substrings are also kept as refcounted slices of `data`, so buffering them costs
+    //! no copy and no allocation beyond the map node.
+    void push_substring(const Buffer &data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -48,6 +77,10 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \brief The stored but not yet reassembled substrings, as ranges of stream indices
+    //! \returns disjoint, non-adjacent [first, last) ranges in increasing order
+    std::vector<std::pair<uint64_t, uint64_t>> received_ranges() const;
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
@@ -1,6 +1,7 @@
 #include "tcp_connection.hh"
 
 #include <iostream>
+#include <limits>
 
 // Dummy implementation of a TCP connection
 
@@ -12,6 +13,19 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
+//! \returns the smallest window scale shift that lets a window of `capacity` bytes be advertised
+static uint8_t window_shift_for(const size_t capacity) {
+    uint8_t shift = 0;
+    while (shift < TCPHeader::MAX_WINDOW_SHIFT && (capacity >> shift) > numeric_limits<uint16_t>::max())
+        shift++;
+    return shift;
+}
+
+//! \returns whether `seg` is a pure ACK: one that carries no data and uses no sequence numbers
+static bool pure_ack(const TCPSegment &seg) {
+    return seg.header().ack && !seg.header().rst && seg.length_in_sequence_space() == 0;
+}
+
 size_t TCPConnection::remaining_outbound_capacity() const {
     return _sender.stream_in().remaining_capacity();
 }
@@ -42,11 +56,29 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         _is_active = false;
         return;
     }
+    // 双方的 SYN 都带有 SACK-permitted 选项时才使用 SACK
+    if (seg.header().syn && seg.header().sack_permitted && _cfg.sack)
+        _sack_enabled = true;
+    // 窗口缩放同样需要双方的 SYN 都带有该选项
+    if (seg.header().syn && seg.header().window_scale.has_value() && _cfg.window_scaling) {
+        _peer_window_shift = min(*seg.header().window_scale, TCPHeader::MAX_WINDOW_SHIFT);
+        _window_shift = window_shift_for(_cfg.recv_capacity);
+    }
+    // 对端的 SYN 给出了它能接收的最大段长；没有给出时沿用自己的配置
+    if (seg.header().syn && seg.header().mss.has_value())
+        _sender.limit_mss(*seg.header().mss);
+    // 段是否恰好从期望的序号开始，且收到前后都没有空洞（没有乱序，也没有填补空洞）
+    const bool in_order = _receiver.ackno() == seg.header().seqno && _receiver.unassembled_bytes() == 0;
     // 把这个段交给TCPReceiver
     _receiver.segment_received(seg);
-    // 如果设置了ACK标志，则告诉TCPSender它关心的传入段的字段：ackno和window_size。
+    // 如果设置了ACK标志，则告诉TCPSender它关心的传入段的字段：ackno和window_size（以及SACK块）。
     if(seg.header().ack){
-        _sender.ack_received(seg.header().ackno, seg.header().win);
+        // SYN 中的窗口不缩放
+        const uint8_t shift = seg.header().syn ? 0 : _peer_window_shift.value_or(0);
+        _sender.ack_received(seg.header().ackno,
+                             uint32_t{seg.header().win} << shift,
+                             _sack_enabled ? seg.header().sack : TCPHeader::SackList{},
+                             seg.length_in_sequence_space() == 0);
     }
     
     //状态变化(按照个人的情况可进行修改)
@@ -74,11 +106,23 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
 
     // 如果收到的数据包里没有任何数据，则这个数据包可能只是为了 keep-alive
     if (seg.length_in_sequence_space() || (_receiver.ackno().has_value() && seg.header().seqno == _receiver.ackno().value() - 1))
-        _sender.send_empty_segment();
+        acknowledge(seg, in_order && _receiver.unassembled_bytes() == 0);
 
     load_segments_out();
 }
 
+void TCPConnection::acknowledge(const TCPSegment &seg, const bool in_order) {
+    // 乱序、填补空洞、FIN 和 keep-alive 都立即确认，以免拖慢对端的丢包恢复和连接关闭
+    if (!_cfg.delayed_ack || !in_order || seg.header().fin || seg.payload().size() == 0 ||
+        ++_unacked_segments >= _cfg.ack_every) {
+        _sender.send_empty_segment();
+        return;
+    }
+    // 否则等待后续的段或延迟确认定时器；发出的数据段会捎带确认
+    if (!_ack_waited_us.has_value())
+        _ack_waited_us = 0;
+}
+
 bool TCPConnection::active() const {
     return _is_active;
 }
@@ -90,10 +134,19 @@ size_t TCPConnection::write(const string &data) {
 }
 
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
-void TCPConnection::tick(const size_t ms_since_last_tick) {
+void TCPConnection::tick(const size_t ms_since_last_tick) { tick_us(uint64_t{ms_since_last_tick} * 1000); }
+
+//! \param[in] us_since_last_tick number of microseconds since the last call to this method
+void TCPConnection::tick_us(const uint64_t us_since_last_tick) {
     if(!_is_active)
         return;
-    _sender.tick(ms_since_last_tick);
+    _sender.tick_us(us_since_last_tick);
+    // 延迟的确认等待超时后发出
+    if (_ack_waited_us.has_value()) {
+        *_ack_waited_us += us_since_last_tick;
+        if (*_ack_waited_us >= uint64_t{_cfg.ack_delay} * 1000)
+            _sender.send_empty_segment();
+    }
     // 2.如果连续重传的次数超过上限TCPConfig::MAX_RETX_ATTEMPTS，则终止连接，并发送一个重置段给对端（设置了RST标志的空段）。
     if(_sender.consecutive_retransmissions()>TCPConfig::MAX_RETX_ATTEMPTS){
         _sender.stream_in().set_error();
@@ -111,6 +164,26 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
     }
 }
 
+optional<uint64_t> TCPConnection::time_until_next_tick_us() const {
+    if(!_is_active)
+        return {};
+    optional<uint64_t> wait = _sender.time_until_next_tick_us();
+    // 有确认在等待时，到时需要发出
+    if (_ack_waited_us.has_value()) {
+        const uint64_t delay = uint64_t{_cfg.ack_delay} * 1000;
+        wait = min(wait.value_or(UINT64_MAX), *_ack_waited_us >= delay ? 0 : delay - *_ack_waited_us);
+    }
+    // 两个流都已结束，等待 linger 时间结束后关闭连接
+    if(_linger_after_streams_finish && _receiver.stream_out().input_ended() && _sender.bytes_in_flight()==0
+        && _sender.stream_in().eof()){
+        const size_t linger = 10*_cfg.rt_timeout;
+        const size_t since = time_since_last_segment_received();
+        const uint64_t remaining = since>=linger ? 0 : uint64_t{linger-since}*1000;
+        wait = min(wait.value_or(UINT64_MAX), remaining);
+    }
+    return wait;
+}
+
 void TCPConnection::end_input_stream() {
     _sender.stream_in().end_input();
     load_segments_out();
@@ -143,15 +216,41 @@ void TCPConnection::load_segments_out(bool connect) {
         return;
     // 1.TCPSender将一个段推入它的传出队列，并设置了它在传出段上负责的字段（segno，SYN,负载以及FIN）。
     _sender.fill_window();
-    while(!_sender.segments_out().empty()){
-        auto segment = _sender.segments_out().front();
-        _sender.segments_out().pop();
+    for (; !_sender.segments_out().empty(); _sender.segments_out().pop()) {
+        // 在发送方队列中原地填写首部，再把段移入连接的队列，负载不会被复制
+        TCPSegment &segment = _sender.segments_out().front();
         // 2.在发送段之前，TCPConnection将向TCPReceiver询问它负责传出段的字段：ackno和window_size，如果有一个ackno，它将设置ACK标志以及TCPSegment中的内容。
         if(_receiver.ackno().has_value()){
             segment.header().ack = true;
             segment.header().ackno = _receiver.ackno().value();
-            segment.header().win = _receiver.window_size();
+            // 超过 16 位的窗口缩放后通告，缩放后仍然放不下（或未协商缩放）时通告能表示的最大窗口
+            const uint8_t shift = segment.header().syn ? 0 : _window_shift;
+            segment.header().win = min(_receiver.window_size() >> shift, size_t{numeric_limits<uint16_t>::max()});
+            if (_sack_enabled)
+                segment.header().sack = _receiver.sack();
+            // 对端的 SYN 没有提供 SACK 时，SYN+ACK 也不能提供
+            else if (segment.header().syn)
+                segment.header().sack_permitted = false;
         }
-        _segments_out.push(segment);
+        // SYN 中告诉对端自己能接收的最大段长
+        if (segment.header().syn)
+            segment.header().mss = min(_cfg.mss, size_t{numeric_limits<uint16_t>::max()});
+        // 主动打开时提供窗口缩放；被动打开时只有对端提供了才回应
+        if (segment.header().syn && _cfg.window_scaling &&
+            (!_receiver.ackno().has_value() || _peer_window_shift.has_value()))
+            segment.header().window_scale = window_shift_for(_cfg.recv_capacity);
+        // 任何带 ACK 的段都确认了目前收到的全部数据，延迟的确认不必再发
+        if (segment.header().ack) {
+            _unacked_segments = 0;
+            _ack_waited_us.reset();
+        }
+        // 连续收到多个段时，队列中尚未取走的纯 ACK 由确认号更大的纯 ACK 取代；
+        // 确认号相同的是重复 ACK，是对端判断丢包的依据，不能合并
+        if (_cfg.delayed_ack && pure_ack(segment) && !_segments_out.empty() && pure_ack(_segments_out.back()) &&
+            _segments_out.back().header().ackno != segment.header().ackno) {
+            _segments_out.back() = move(segment);
+            continue;
+        }
+        _segments_out.push(move(segment));
     }
 }
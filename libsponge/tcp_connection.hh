@@ -10,11 +10,11 @@
 class TCPConnection {
   private:
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPReceiver _receiver{_cfg.recv_capacity, _cfg.recv_storage};
+    TCPSender _sender{_cfg};
 
     //! outbound queue of segments that the TCPConnection wants sent
-    std::queue<TCPSegment> _segments_out{};
+    TCPSegmentQueue _segments_out{};
 
     //! Should the TCPConnection stay active (and keep ACKing)
     //! for 10 * _cfg.rt_timeout milliseconds after both streams have ended,
@@ -22,8 +22,27 @@ class TCPConnection {
     bool _linger_after_streams_finish{true};
     bool _is_active{true};
 
+    //! Both sides offered SACK-permitted on their SYNs
+    bool _sack_enabled{false};
+
+    //! \name Window scaling, used once both SYNs carried the window scale option
+    //!@{
+    std::optional<uint8_t> _peer_window_shift{};  //!< shift applied to the windows the peer advertises
+    uint8_t _window_shift{0};                     //!< shift applied to the windows this side advertises
+    //!@}
+
+    //! \name Delayed ACKs: in-order data is acknowledged every `ack_every` segments, or once the
+    //! oldest unacknowledged segment has waited `ack_delay` milliseconds
+    //!@{
+    unsigned _unacked_segments{0};             //!< segments received since this side last sent an ACK
+    std::optional<uint64_t> _ack_waited_us{};  //!< how long the oldest of them has waited, if any wait
+    //!@}
+
     size_t _timestamp{0};
 
+    //! \brief Acknowledge `seg` now, or let the ACK wait for more data or for the delayed ACK timer
+    void acknowledge(const TCPSegment &seg, bool in_order);
+
   public:
     //! \name "Input" interface for the writer
     //!@{
@@ -60,6 +79,12 @@ class TCPConnection {
     size_t time_since_last_segment_received() const;
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
+    //! \brief the sender's congestion controller, or nullptr if congestion control is off
+    const CongestionController *congestion_controller() const { return _sender.congestion_controller(); }
+    //! \brief the sender's RTT estimate, retransmission timeout and retransmission count
+    TCPSenderStats stats() const { return _sender.stats(); }
+    //! \brief payload size of the segments the sender sends now (negotiated, or found by probing)
+    size_t mss() const { return _sender.mss(); }
     //!@}
 
     //! \name Methods for the owner or operating system to call
@@ -73,11 +98,18 @@ class TCPConnection {
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! Called when time elapses, with microsecond resolution
+    void tick_us(const uint64_t us_since_last_tick);
+
+    //! \brief How long until the connection next needs a tick (to retransmit, send a paced segment or
+    //! stop lingering); empty if it only needs ticks to notice the passage of time
+    std::optional<uint64_t> time_until_next_tick_us() const;
+
     //! \brief TCPSegments that the TCPConnection has enqueued for transmission.
     //! \note The owner or operating system will dequeue these and
     //! put each one into the payload of a lower-layer datagram (usually Internet datagrams (IP),
     //! but could also be user datagrams (UDP) or any other kind).
-    std::queue<TCPSegment> &segments_out() { return _segments_out; }
+    TCPSegmentQueue &segments_out() { return _segments_out; }
 
     //! \brief Is the connection still alive in any way?
     //! \returns `true` if either stream is still running or if the TCPConnection is lingering
@@ -1,5 +1,7 @@
 #include "fd_adapter.hh"
 
+#include "util.hh"
+
 #include <iostream>
 #include <stdexcept>
 #include <utility>
@@ -7,7 +9,9 @@
 using namespace std;
 
 //! \details This function first attempts to parse a TCP segment from the next UDP
-//! payload recv()d from the socket.
+//! payload received from the socket. Datagrams are received in batches (into the receive
+//! pool, so without allocating): when none from the last batch is left, this function
+//! receives all the datagrams that are waiting, and returns the first.
 //!
 //! If this succeeds, it then checks that the received segment is related to the
 //! current connection. When a TCP connection has been established, this means
@@ -19,23 +23,44 @@ using namespace std;
 //! the result that future outgoing segments go to the sender of the SYN segment.
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
 optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
-    auto datagram = _sock.recv();
+    if (not _offload_configured) {
+        configure_offload();
+    }
+    if (not read_pending()) {
+        _next_received = 0;
+        _sock.recv_batch(_received, receive_pool());
+        if (_received.empty()) {
+            return {};
+        }
+    }
+
+    // a datagram coalesced by GRO is read one segment-sized piece at a time
+    UDPSocket::received_buffer &datagram = _received[_next_received];
+    const Address &source_address = datagram.source_address;
+    Buffer payload = datagram.payload;
+    if (datagram.segment_size > 0 and payload.size() > datagram.segment_size) {
+        payload.remove_suffix(payload.size() - datagram.segment_size);
+        datagram.payload.remove_prefix(datagram.segment_size);
+    } else {
+        datagram.payload = Buffer{};
+        _next_received++;
+    }
 
     // is it for us?
-    if (not listening() and (datagram.source_address != config().destination)) {
+    if (not listening() and (source_address != config().destination)) {
         return {};
     }
 
     // is the payload a valid TCP segment?
     TCPSegment seg;
-    if (ParseResult::NoError != seg.parse(move(datagram.payload), 0)) {
+    if (ParseResult::NoError != seg.parse(move(payload), 0)) {
         return {};
     }
 
     // should we target this source in all future replies?
     if (listening()) {
         if (seg.header().syn and not seg.header().rst) {
-            config_mutable().destination = datagram.source_address;
+            config_mutable().destination = source_address;
             set_listening(false);
         } else {
             return {};
@@ -45,12 +70,80 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
     return seg;
 }
 
-//! Serialize a TCP segment and send it as the payload of a UDP datagram.
+//! Serialize a TCP segment to be sent as the payload of a UDP datagram.
 //! \param[in] seg is the TCP segment to write
+//! \note A full batch is sent right away; a partial one waits for flush().
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
-    _sock.sendto(config().destination, seg.serialize(0));
+    // with GSO, a full batch is MAX_BATCH runs of segments rather than MAX_BATCH segments
+    const size_t full_batch = UDPSocket::MAX_BATCH * (_offload ? UDPSocket::MAX_GSO_SEGMENTS : 1);
+    seg.for_each_wire_segment([&](const TCPSegment &piece) {
+        _unsent.push_back(piece.serialize(0));
+        if (_unsent.size() >= full_batch) {
+            flush();
+        }
+    });
+}
+
+//! \details With GSO, each run of segments that serialize to the same size (ended, perhaps, by one
+//! shorter segment, such as the last piece of a super-segment) is sent as one GSO payload, which the
+//! kernel cuts back into datagrams, or hands whole to a receiver that uses GRO.
+void TCPOverUDPSocketAdapter::flush() {
+    if (_unsent.empty()) {
+        return;
+    }
+    if (not _offload_configured) {
+        configure_offload();
+    }
+    if (not _offload) {
+        _sock.send_batch(config().destination, _unsent);
+        _unsent.clear();
+        return;
+    }
+
+    _gso_payloads.clear();
+    _gso_sizes.clear();
+    for (size_t i = 0; i < _unsent.size();) {
+        const size_t segment_size = _unsent[i].size();
+        size_t run_size = segment_size;
+        size_t count = 1;
+        BufferList run = move(_unsent[i++]);
+        while (i < _unsent.size() and count < UDPSocket::MAX_GSO_SEGMENTS and _unsent[i].size() <= segment_size and
+               run_size + _unsent[i].size() <= UDPSocket::MAX_GSO_PAYLOAD) {
+            const bool last = _unsent[i].size() < segment_size;
+            run_size += _unsent[i].size();
+            count++;
+            run.append(_unsent[i++]);
+            if (last) {
+                break;
+            }
+        }
+        _gso_payloads.push_back(move(run));
+        _gso_sizes.push_back(count > 1 ? segment_size : 0);
+    }
+    _sock.send_batch(config().destination, _gso_payloads, _gso_sizes);
+    _unsent.clear();
+}
+
+//! \details GRO is turned on for the socket the first time the adapter reads or flushes, and GSO is
+//! used from then on, unless datagrams go through io_uring (which does not pass the segment size along)
+//! or the kernel does not support them.
+void TCPOverUDPSocketAdapter::configure_offload() {
+    _offload_configured = true;
+    if (not config().udp_offload) {
+        return;
+    }
+    if (_sock.ring() != nullptr) {
+        cerr << "DEBUG: UDP GSO/GRO is not used with io_uring.\n";
+        return;
+    }
+    try {
+        _sock.set_gro(true);
+        _offload = true;
+    } catch (const unix_error &e) {
+        cerr << "DEBUG: UDP GSO/GRO is unavailable (" << e.what() << ").\n";
+    }
 }
 
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
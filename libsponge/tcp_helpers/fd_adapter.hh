@@ -10,17 +10,33 @@
 
 #include <optional>
 #include <utility>
+#include <vector>
 
 //! \brief Basic functionality for file descriptor adaptors
 //! \details See TCPOverUDPSocketAdapter and TCPOverIPv4OverTunFdAdapter for more information.
 class FdAdapterBase {
   private:
-    FdAdapterConfig _cfg{};  //!< Configuration values
-    bool _listen = false;    //!< Is the connected TCP FSM in listen state?
+    //! Slabs hold many packets, and are reused once the segments read from them are gone
+    static constexpr size_t RECEIVE_SLAB_SIZE = 256 * 1024;
+
+    //! Largest packet read from a TUN or TAP device: an IPv4 datagram, with an Ethernet header
+    static constexpr size_t MAX_PACKET_SIZE = 65535 + 14;
+
+    FdAdapterConfig _cfg{};                       //!< Configuration values
+    bool _listen = false;                         //!< Is the connected TCP FSM in listen state?
+    BufferPool _receive_pool{RECEIVE_SLAB_SIZE};  //!< Storage for received packets
 
   protected:
     FdAdapterConfig &config_mutable() { return _cfg; }
 
+    //! Storage to read packets into, so that receiving a packet does not allocate
+    BufferPool &receive_pool() { return _receive_pool; }
+
+    //! \brief Read one packet from `fd` (a device that returns a packet per read) into the receive pool
+    //! \note The read asks for room for the largest packet, not for a whole slab, so that consecutive
+    //! packets share a slab.
+    Buffer read_packet(FileDescriptor &fd) { return fd.read(_receive_pool, MAX_PACKET_SIZE); }
+
   public:
     //! \brief Set the listening flag
     //! \param[in] l is the new value for the flag
@@ -40,12 +56,34 @@ class FdAdapterBase {
 
     //! Called periodically when time elapses
     void tick(const size_t) {}
+
+    //! Whether packets already received are waiting to be read (even if the file descriptor is not readable)
+    bool read_pending() const { return false; }
+
+    //! Send the segments that have been written and not yet sent
+    void flush() {}
 };
 
 //! \brief A FD adaptor that reads and writes TCP segments in UDP payloads
 class TCPOverUDPSocketAdapter : public FdAdapterBase {
   private:
+    static constexpr size_t UDP_OVER_IPV4_OVERHEAD = 28;  //!< IPv4 and UDP headers
+
     UDPSocket _sock;
+    std::vector<UDPSocket::received_buffer> _received{};  //!< Datagrams received by one UDPSocket::recv_batch
+    size_t _next_received{0};                             //!< Index in `_received` of the next one to read
+    std::vector<BufferList> _unsent{};                    //!< Serialized segments waiting for flush()
+
+    //! \name UDP GSO and GRO (see FdAdapterConfig::udp_offload)
+    //!@{
+    bool _offload_configured{false};          //!< Whether configure_offload() has run
+    bool _offload{false};                     //!< Whether GSO and GRO are in use
+    std::vector<BufferList> _gso_payloads{};  //!< Runs of same-size segments, each sent with GSO
+    std::vector<uint16_t> _gso_sizes{};       //!< Segment size of each run (0 for a run of one)
+
+    //! Turn GRO on (and so start sending with GSO) if the config asks for it and the kernel supports it
+    void configure_offload();
+    //!@}
 
   public:
     //! Construct from a UDPSocket sliced into a FileDescriptor
@@ -54,9 +92,18 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
     //! Attempts to read and return a TCP segment related to the current connection from a UDP payload
     std::optional<TCPSegment> read();
 
-    //! Writes a TCP segment into a UDP payload
+    //! Whether datagrams received in the same batch (or GRO datagram) as the last one read are waiting to be read
+    bool read_pending() const { return _next_received < _received.size(); }
+
+    //! Writes a TCP segment into a UDP payload (sent by the next flush())
     void write(TCPSegment &seg);
 
+    //! Sends the segments written since the last flush, a batch of datagrams (or GSO runs) per system call
+    void flush();
+
+    //! Largest TCP payload that fits in a UDP datagram (over IPv4) of `config().mtu` bytes
+    size_t max_payload_size() const { return config().mtu - UDP_OVER_IPV4_OVERHEAD - TCPHeader::LENGTH; }
+
     //! Access the underlying UDP socket
     operator UDPSocket &() { return _sock; }
 
@@ -5,12 +5,20 @@
 
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 using namespace std;
 
 ParseResult IPv4Datagram::parse(const Buffer buffer) {
     NetParser p{buffer};
-    _header.parse(p);
+    const ParseResult header_result = _header.parse(p);
+    // keep the wire header only if it checked out, so forwarding can patch it incrementally
+    if (header_result == ParseResult::NoError) {
+        _raw_header = buffer;
+        _raw_header.remove_suffix(buffer.size() - 4 * size_t(_header.hlen));
+    } else {
+        _raw_header = Buffer{};
+    }
     _payload = p.buffer();
 
     if (_payload.size() != _header.payload_length()) {
@@ -25,6 +33,12 @@ BufferList IPv4Datagram::serialize() const {
         throw runtime_error("IPv4Datagram::serialize: payload is wrong size");
     }
 
+    if (_raw_header.size() > 0) {
+        BufferList ret{_raw_header};
+        ret.append(_payload);
+        return ret;
+    }
+
     IPv4Header header_out = _header;
     header_out.cksum = 0;
     const string header_zero_checksum = header_out.serialize();
@@ -39,3 +53,23 @@ BufferList IPv4Datagram::serialize() const {
     ret.append(_payload);
     return ret;
 }
+
+void IPv4Datagram::decrement_ttl() {
+    if (_header.ttl == 0) {
+        throw runtime_error("IPv4Datagram::decrement_ttl: TTL is already zero");
+    }
+    // TTL and protocol share the header's fifth 16-bit word (bytes 8 and 9)
+    const uint16_t old_word = uint16_t(_header.ttl << 8 | _header.proto);
+    _header.ttl--;
+    const uint16_t new_word = uint16_t(_header.ttl << 8 | _header.proto);
+    _header.cksum = InternetChecksum::update(_header.cksum, old_word, new_word);
+
+    // copy on write: the parsed header is a view of storage shared with the caller (and perhaps other threads)
+    if (_raw_header.size() > 0) {
+        string raw = _raw_header.copy();
+        raw[8] = char(_header.ttl);
+        raw[10] = char(_header.cksum >> 8);
+        raw[11] = char(_header.cksum & 0xff);
+        _raw_header = Buffer{move(raw)};
+    }
+}
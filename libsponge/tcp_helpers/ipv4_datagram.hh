@@ -4,23 +4,41 @@
 #include "buffer.hh"
 #include "ipv4_header.hh"
 
+#include <string>
+
 //! \brief [IPv4](\ref rfc::rfc791) Internet datagram
 class IPv4Datagram {
   private:
     IPv4Header _header{};
     BufferList _payload{};
 
+    //! The header exactly as it was parsed (options included): a read-only view of the received bytes,
+    //! replaced by a patched copy of its own when decrement_ttl() is called. Empty if the datagram was
+    //! not parsed, or its header may have been changed since.
+    Buffer _raw_header{};
+
   public:
     //! \brief Parse the segment from a string
     ParseResult parse(const Buffer buffer);
 
     //! \brief Serialize the segment to a string
+    //! \note A parsed datagram whose header has not been modified reuses its wire header as is.
     BufferList serialize() const;
 
+    //! \brief Decrement the TTL for forwarding, updating the checksum incrementally (RFC 1624)
+    //! \details Patches the TTL and checksum of a copy of the parsed wire header, so forwarding
+    //! a datagram does not have to rebuild and re-checksum the whole header. The received bytes,
+    //! which the caller and copies of this datagram may share, are left as they were.
+    void decrement_ttl();
+
     //! \name Accessors
     //!@{
     const IPv4Header &header() const { return _header; }
-    IPv4Header &header() { return _header; }
+    //! \note Gives up the parsed wire header, since the caller may change any field
+    IPv4Header &header() {
+        _raw_header = Buffer{};
+        return _header;
+    }
 
     const BufferList &payload() const { return _payload; }
     BufferList &payload() { return _payload; }
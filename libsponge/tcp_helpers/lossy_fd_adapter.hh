@@ -49,11 +49,13 @@ class LossyFdAdapter {
 
     //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
     //! \param[in] seg is the packet to either write or drop
+    //! \note Each wire segment of a super-segment is dropped (or not) on its own
     void write(TCPSegment &seg) {
-        if (_should_drop(true)) {
-            return;
-        }
-        return _adapter.write(seg);
+        seg.for_each_wire_segment([&](TCPSegment &piece) {
+            if (not _should_drop(true)) {
+                _adapter.write(piece);
+            }
+        });
     }
 
     //! \name
@@ -63,6 +65,9 @@ class LossyFdAdapter {
     void set_listening(const bool l) { _adapter.set_listening(l); }      //!< FdAdapterBase::set_listening passthrough
     const FdAdapterConfig &config() const { return _adapter.config(); }  //!< FdAdapterBase::config passthrough
     FdAdapterConfig &config_mut() { return _adapter.config_mut(); }      //!< FdAdapterBase::config_mut passthrough
+    size_t max_payload_size() const { return _adapter.max_payload_size(); }  //!< Largest TCP payload passthrough
+    bool read_pending() const { return _adapter.read_pending(); }            //!< Pending reads passthrough
+    void flush() { _adapter.flush(); }                                       //!< FdAdapterBase::flush passthrough
     void tick(const size_t ms_since_last_tick) {
         _adapter.tick(ms_since_last_tick);
     }  //!< FdAdapterBase::tick passthrough
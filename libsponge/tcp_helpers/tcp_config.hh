@@ -2,6 +2,8 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
@@ -15,11 +17,30 @@ class TCPConfig {
     static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr uint16_t RTO_MIN_DFLT = 200;      //!< Default lower bound on the adaptive timeout
+    static constexpr uint32_t RTO_MAX_DFLT = 60000;    //!< Default upper bound on the adaptive timeout
+    static constexpr uint16_t ACK_DELAY_DFLT = 40;     //!< Default longest delay of a delayed ACK
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
+    bool adaptive_rto = false;                //!< Compute the timeout from measured RTTs (RFC 6298)
+    uint16_t rto_min = RTO_MIN_DFLT;          //!< Lower bound on the adaptive timeout, in milliseconds
+    uint32_t rto_max = RTO_MAX_DFLT;          //!< Upper bound on the adaptive timeout, in milliseconds
+    bool fast_retransmit = false;             //!< Retransmit on three duplicate ACKs rather than on timeout
+    bool sack = false;                        //!< Offer selective acknowledgments (RFC 2018) to the peer
+    bool window_scaling = false;              //!< Offer window scaling (RFC 7323), for windows beyond 64 KiB
+    bool trim_retransmissions = false;        //!< Retransmit only the unacked part of a partially acked segment
+    bool pacing = false;                      //!< Space data segments at the congestion controller's pacing rate
+    size_t mss = MAX_PAYLOAD_SIZE;            //!< Largest payload to send or receive (offered in the SYN's MSS option)
+    bool mtu_probing = false;                 //!< Start from MAX_PAYLOAD_SIZE and probe for the path MTU (RFC 4821)
+    bool gso = false;                         //!< Send super-segments that the adapter splits into MSS-sized ones
+    bool delayed_ack = false;                 //!< Delay and coalesce the ACKs of in-order data (RFC 1122 4.2.3.2)
+    unsigned ack_every = 2;                   //!< With delayed ACKs, ACK at least every this many segments
+    uint16_t ack_delay = ACK_DELAY_DFLT;      //!< With delayed ACKs, longest an ACK may wait, in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
+    ByteStream::Storage recv_storage = ByteStream::Storage::Ring;  //!< How the inbound stream stores received bytes
     std::optional<WrappingInt32> fixed_isn{};
+    CongestionControl congestion_control = CongestionControl::None;  //!< Congestion control for the sender
 };
 
 //! Config for classes derived from FdAdapter
@@ -30,6 +51,12 @@ class FdAdapterConfig {
 
     uint16_t loss_rate_dn = 0;  //!< Downlink loss rate (for LossyFdAdapter)
     uint16_t loss_rate_up = 0;  //!< Uplink loss rate (for LossyFdAdapter)
+
+    uint16_t mtu = 1500;  //!< MTU of the link the adapter sends on, which bounds the TCP payload size
+
+    bool io_uring = false;  //!< Read and write datagrams through io_uring, where the kernel supports it
+
+    bool udp_offload = false;  //!< Send with UDP GSO and receive with UDP GRO, where the kernel supports them
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_CONFIG_HH
@@ -1,9 +1,15 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
 
+bool TCPHeader::SackList::operator==(const SackList &other) const {
+    const auto same = [](const SackBlock &a, const SackBlock &b) { return a.left == b.left && a.right == b.right; };
+    return count == other.count && equal(blocks.begin(), blocks.begin() + count, other.blocks.begin(), same);
+}
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -37,8 +43,52 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    // options: each is a kind byte, then (except for EOL and NOP) a length byte covering the whole option
+    mss.reset();
+    window_scale.reset();
+    sack_permitted = false;
+    sack = {};
+    size_t remaining = doff * 4 - TCPHeader::LENGTH;
+    while (remaining > 0 && !p.error()) {
+        const uint8_t kind = p.u8();
+        remaining--;
+        if (kind == OPT_EOL) {
+            break;
+        }
+        if (kind == OPT_NOP) {
+            continue;
+        }
+        if (remaining == 0) {
+            break;
+        }
+        const uint8_t len = p.u8();
+        remaining--;
+        if (len < 2 || size_t(len - 2) > remaining) {
+            // malformed option: ignore the rest of the option list
+            break;
+        }
+        size_t body = len - 2;
+        remaining -= body;
+        if (kind == OPT_MSS && body == 2) {
+            mss = p.u16();
+            body = 0;
+        } else if (kind == OPT_WINDOW_SCALE && body == 1) {
+            window_scale = p.u8();
+            body = 0;
+        } else if (kind == OPT_SACK_PERMITTED && body == 0) {
+            sack_permitted = true;
+        } else if (kind == OPT_SACK && body % 8 == 0) {
+            for (; body > 0 && sack.count < SackList::MAX_BLOCKS; body -= 8) {
+                sack.blocks[sack.count].left = WrappingInt32{p.u32()};
+                sack.blocks[sack.count].right = WrappingInt32{p.u32()};
+                sack.count++;
+            }
+        }
+        p.remove_prefix(body);  // unknown option, or the part of one that was not interpreted
+    }
+
+    // skip any padding or anything extra in the header
+    p.remove_prefix(remaining);
 
     if (p.error()) {
         return p.get_error();
@@ -47,21 +97,36 @@ ParseResult TCPHeader::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
+//! \returns the length in bytes of the options, before padding
+static size_t options_length(const TCPHeader &header) {
+    return (header.mss.has_value() ? 4 : 0) + (header.window_scale.has_value() ? 4 : 0) +
+           (header.sack_permitted ? 2 : 0) + (header.sack.count > 0 ? 2 + 8 * header.sack.count : 0);
+}
+
+uint8_t TCPHeader::data_offset() const {
+    return max(doff, static_cast<uint8_t>((LENGTH + options_length(*this) + 3) / 4));
+}
+
 //! Serialize the TCPHeader to a string (does not recompute the checksum)
+//! \note `doff` is raised if the options do not fit in the header it describes
 string TCPHeader::serialize() const {
     // sanity check
     if (doff < 5) {
         throw runtime_error("TCP header too short");
     }
+    if (sack.count > SackList::MAX_BLOCKS) {
+        throw runtime_error("TCP header has too many SACK blocks");
+    }
+    const uint8_t offset = data_offset();
 
     string ret;
-    ret.reserve(4 * doff);
+    ret.reserve(4 * offset);
 
     NetUnparser::u16(ret, sport);              // source port
     NetUnparser::u16(ret, dport);              // destination port
     NetUnparser::u32(ret, seqno.raw_value());  // sequence number
     NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    NetUnparser::u8(ret, offset << 4);         // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
@@ -72,7 +137,31 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    if (mss.has_value()) {
+        NetUnparser::u8(ret, OPT_MSS);
+        NetUnparser::u8(ret, 4);
+        NetUnparser::u16(ret, *mss);
+    }
+    if (window_scale.has_value()) {
+        NetUnparser::u8(ret, OPT_NOP);  // keeps the options after it aligned
+        NetUnparser::u8(ret, OPT_WINDOW_SCALE);
+        NetUnparser::u8(ret, 3);
+        NetUnparser::u8(ret, *window_scale);
+    }
+    if (sack_permitted) {
+        NetUnparser::u8(ret, OPT_SACK_PERMITTED);
+        NetUnparser::u8(ret, 2);
+    }
+    if (sack.count > 0) {
+        NetUnparser::u8(ret, OPT_SACK);
+        NetUnparser::u8(ret, 2 + 8 * sack.count);
+        for (size_t i = 0; i < sack.count; i++) {
+            NetUnparser::u32(ret, sack.blocks[i].left.raw_value());
+            NetUnparser::u32(ret, sack.blocks[i].right.raw_value());
+        }
+    }
+
+    ret.resize(4 * offset);  // pad the options with EOL and expand header to advertised size
 
     return ret;
 }
@@ -90,19 +179,37 @@ string TCPHeader::to_string() const {
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
        << "TCP uptr: " << +uptr << '\n';
+    if (mss.has_value()) {
+        ss << "TCP option: MSS " << dec << *mss << hex << '\n';
+    }
+    if (window_scale.has_value()) {
+        ss << "TCP option: window scale " << dec << +*window_scale << hex << '\n';
+    }
+    if (sack_permitted) {
+        ss << "TCP option: SACK permitted\n";
+    }
+    for (size_t i = 0; i < sack.count; i++) {
+        ss << "TCP option: SACK " << sack.blocks[i].left << "-" << sack.blocks[i].right << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    for (size_t i = 0; i < sack.count; i++) {
+        ss << (i == 0 ? ",sack=" : ",") << sack.blocks[i].left << "-" << sack.blocks[i].right;
+    }
+    ss << ")";
     return ss.str();
 }
 
 bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
-    return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
-           psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+    // (doff is compared as serialized, so a header whose options raised it equals its parsed copy)
+    return seqno == other.seqno && ackno == other.ackno && data_offset() == other.data_offset() && urg == other.urg &&
+           ack == other.ack && psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin &&
+           win == other.win && uptr == other.uptr && mss == other.mss && window_scale == other.window_scale &&
+           sack_permitted == other.sack_permitted && sack == other.sack;
 }
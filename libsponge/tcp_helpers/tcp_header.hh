@@ -4,10 +4,41 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <array>
+#include <optional>
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note Of the TCP options, only maximum segment size, window scale ([RFC 7323](\ref rfc::rfc7323)),
+//! SACK-permitted and SACK ([RFC 2018](\ref rfc::rfc2018)) are interpreted; the others are skipped when parsing.
 struct TCPHeader {
-    static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t LENGTH = 20;             //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_LENGTH = 60;         //!< Largest header `doff` can describe, including options
+    static constexpr uint8_t MAX_WINDOW_SHIFT = 14;  //!< Largest window scale shift allowed by RFC 7323
+
+    //! Option kinds
+    enum OptionKind : uint8_t {
+        OPT_EOL = 0,             //!< End of option list
+        OPT_NOP = 1,             //!< No-operation (padding)
+        OPT_MSS = 2,             //!< Maximum segment size, sent only on SYN segments
+        OPT_WINDOW_SCALE = 3,    //!< Window scale shift count, sent only on SYN segments
+        OPT_SACK_PERMITTED = 4,  //!< SACK-permitted, sent only on SYN segments
+        OPT_SACK = 5,            //!< Selective acknowledgment blocks
+    };
+
+    //! A block of sequence space that was received out of order: [left, right)
+    struct SackBlock {
+        WrappingInt32 left{0};
+        WrappingInt32 right{0};
+    };
+
+    //! The blocks carried by a SACK option (at most four fit in the option space)
+    struct SackList {
+        static constexpr size_t MAX_BLOCKS = 4;
+        std::array<SackBlock, MAX_BLOCKS> blocks{};
+        uint8_t count = 0;
+
+        bool operator==(const SackList &other) const;
+    };
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -50,6 +81,17 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options
+    //!@{
+    std::optional<uint16_t> mss{};          //!< Maximum segment size option (largest payload the sender accepts)
+    std::optional<uint8_t> window_scale{};  //!< Window scale option (shift count)
+    bool sack_permitted = false;            //!< SACK-permitted option
+    SackList sack{};                        //!< SACK option (omitted if there are no blocks)
+    //!@}
+
+    //! \brief Data offset that will be serialized: `doff`, or more if the options need the room
+    uint8_t data_offset() const;
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
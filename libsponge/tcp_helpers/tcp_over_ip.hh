@@ -4,6 +4,7 @@
 #include "buffer.hh"
 #include "fd_adapter.hh"
 #include "ipv4_datagram.hh"
+#include "ipv4_header.hh"
 #include "tcp_segment.hh"
 
 #include <optional>
@@ -14,6 +15,9 @@ class TCPOverIPv4Adapter : public FdAdapterBase {
     std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
 
     InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+
+    //! Largest TCP payload that fits in a datagram of `config().mtu` bytes
+    size_t max_payload_size() const { return config().mtu - IPv4Header::LENGTH - TCPHeader::LENGTH; }
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
@@ -3,42 +3,112 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <utility>
 #include <variant>
 
 using namespace std;
 
 //! \param[in] buffer string/Buffer to be parsed
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+//! \details The header and the payload are summed separately in a single pass over the
+//! bytes, so the payload's checksum can be kept for a later serialize().
 ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer_checksum) {
+    NetParser p{buffer};
+    const ParseResult header_result = _header.parse(p);
+    _payload = p.buffer();
+    _payload_checksum.reset();
+
+    if (header_result != ParseResult::NoError) {
+        // report a bad checksum in preference to a malformed header, as before
+        InternetChecksum check(datagram_layer_checksum);
+        check.add(buffer);
+        return check.value() ? ParseResult::BadChecksum : header_result;
+    }
+
     InternetChecksum check(datagram_layer_checksum);
-    check.add(buffer);
+    check.add(buffer.str().substr(0, buffer.size() - _payload.size()));
+    InternetChecksum payload_check;
+    payload_check.add(_payload);
+    check.add(payload_check);
     if (check.value()) {
         return ParseResult::BadChecksum;
     }
 
-    NetParser p{buffer};
-    _header.parse(p);
-    _payload = p.buffer();
-    return p.get_error();
+    _payload_checksum = payload_check;
+    return ParseResult::NoError;
 }
 
 size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
+void TCPSegment::set_payload(Buffer payload, const InternetChecksum &checksum) {
+    _payload = move(payload);
+    _payload_checksum = checksum;
+}
+
+void TCPSegment::set_gso_payload(Buffer payload, const size_t gso_size, vector<InternetChecksum> piece_checksums) {
+    _payload = move(payload);
+    _gso_size = gso_size;
+    _piece_checksums = move(piece_checksums);
+    // the checksum of the whole payload follows from those of its pieces
+    if (_piece_checksums.empty()) {
+        _payload_checksum.reset();
+        return;
+    }
+    InternetChecksum whole;
+    for (const auto &piece : _piece_checksums) {
+        whole.add(piece);
+    }
+    _payload_checksum = whole;
+}
+
+vector<TCPSegment> TCPSegment::split() const {
+    vector<TCPSegment> pieces;
+    const size_t size = _payload.size();
+    const size_t step = _gso_size > 0 ? _gso_size : max(size, size_t{1});
+    pieces.reserve((size + step - 1) / step);
+    for (size_t offset = 0, i = 0; offset < size || pieces.empty(); offset += step, i++) {
+        const size_t len = min(step, size - offset);
+        TCPSegment piece;
+        piece._header = _header;
+        piece._header.seqno = _header.seqno + uint32_t(offset);
+        const bool last = offset + len == size;
+        piece._header.fin = _header.fin && last;
+        piece._header.psh = _header.psh && last;
+        piece._payload = _payload;
+        piece._payload.remove_prefix(offset);
+        piece._payload.remove_suffix(size - offset - len);
+        if (i < _piece_checksums.size()) {
+            piece._payload_checksum = _piece_checksums[i];
+        }
+        pieces.push_back(move(piece));
+    }
+    return pieces;
+}
+
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
     TCPHeader header_out = _header;
     header_out.cksum = 0;
+    string header = header_out.serialize();
 
     // calculate checksum -- taken over entire segment
     InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
-    check.add(_payload);
-    header_out.cksum = check.value();
+    check.add(header);
+    if (_payload_checksum.has_value()) {
+        check.add(_payload_checksum.value());
+    } else {
+        check.add(_payload);
+    }
+    const uint16_t cksum = check.value();
+
+    // patch the checksum into the serialized header instead of serializing it again
+    header[CHECKSUM_OFFSET] = char(cksum >> 8);
+    header[CHECKSUM_OFFSET + 1] = char(cksum & 0xff);
 
-    BufferList ret;
-    ret.append(header_out.serialize());
+    BufferList ret{Buffer{move(header)}};
     ret.append(_payload);
 
     return ret;
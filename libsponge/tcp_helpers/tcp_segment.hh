@@ -2,30 +2,101 @@
 #define SPONGE_LIBSPONGE_TCP_SEGMENT_HH
 
 #include "buffer.hh"
+#include "ring_queue.hh"
 #include "tcp_header.hh"
+#include "util.hh"
 
 #include <cstdint>
+#include <optional>
+#include <queue>
+#include <vector>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
   private:
+    static constexpr size_t CHECKSUM_OFFSET = 16;  //!< position of the checksum in the serialized header
+
     TCPHeader _header{};
     Buffer _payload{};
 
+    //! Checksum of the payload, if it was computed when the payload was parsed or copied out of
+    //! a ByteStream. Empty if not, or if the payload may have been changed since.
+    std::optional<InternetChecksum> _payload_checksum{};
+
+    //! Payload size of the wire segments that this segment is split into before it is sent (0 if
+    //! it is sent as it is)
+    size_t _gso_size{0};
+
+    //! Checksum of each `_gso_size` piece of the payload (empty if they are not known)
+    std::vector<InternetChecksum> _piece_checksums{};
+
   public:
     //! \brief Parse the segment from a string
     ParseResult parse(const Buffer buffer, const uint32_t datagram_layer_checksum = 0);
 
     //! \brief Serialize the segment to a string
+    //! \note The header is built once and its checksum patched in; the payload is not read
+    //! again if its checksum is already known.
     BufferList serialize(const uint32_t datagram_layer_checksum = 0) const;
 
+    //! \brief Set the payload along with its checksum (e.g. from ByteStream::read with a checksum)
+    //! \param[in] payload the new payload
+    //! \param[in] checksum an InternetChecksum (with no initial sum) over exactly the bytes of `payload`
+    void set_payload(Buffer payload, const InternetChecksum &checksum);
+
+    //! \name Segmentation offload
+    //! A super-segment carries the payload of several wire segments through the sender and the
+    //! connection as one segment, so that they are queued, and have their header filled in, once.
+    //! The adapter splits it with for_each_wire_segment() as it sends it.
+    //!@{
+
+    //! \brief Make this a super-segment with the given payload
+    //! \param[in] payload the new payload
+    //! \param[in] gso_size payload size of each wire segment (the last may be shorter)
+    //! \param[in] piece_checksums an InternetChecksum over each `gso_size` piece of `payload`
+    void set_gso_payload(Buffer payload, const size_t gso_size, std::vector<InternetChecksum> piece_checksums);
+
+    //! \brief Payload size of the wire segments this segment is split into (0 if it is not split)
+    size_t gso_size() const { return _gso_size; }
+
+    //! \brief Checksum of each wire segment's payload (empty if they are not known)
+    const std::vector<InternetChecksum> &piece_checksums() const { return _piece_checksums; }
+
+    //! \brief The wire segments of a super-segment
+    //! \details Each has a copy of this segment's header, with its seqno advanced and FIN and PSH
+    //! set only on the last. The payloads share this segment's storage and keep their checksums.
+    //! \note Not for SYN segments
+    std::vector<TCPSegment> split() const;
+
+    //! \brief Call `f` on each wire segment: this segment itself, unless it is a super-segment to split
+    template <typename F>
+    void for_each_wire_segment(F &&f) {
+        if (_gso_size == 0 || _payload.size() <= _gso_size) {
+            f(*this);
+            return;
+        }
+        for (TCPSegment &piece : split()) {
+            f(piece);
+        }
+    }
+    //!@}
+
     //! \name Accessors
     //!@{
     const TCPHeader &header() const { return _header; }
     TCPHeader &header() { return _header; }
 
     const Buffer &payload() const { return _payload; }
-    Buffer &payload() { return _payload; }
+
+    //! \brief Checksum of the payload, if it is known without reading the payload
+    const std::optional<InternetChecksum> &payload_checksum() const { return _payload_checksum; }
+
+    //! \note Gives up the cached payload checksums, since the caller may replace the payload
+    Buffer &payload() {
+        _payload_checksum.reset();
+        _piece_checksums.clear();
+        return _payload;
+    }
     //!@}
 
     //! \brief Segment's length in sequence space
@@ -33,4 +104,7 @@ class TCPSegment {
     size_t length_in_sequence_space() const;
 };
 
+//! \brief A FIFO of segments on their way out, kept in a ring so that steady traffic does not allocate
+using TCPSegmentQueue = std::queue<TCPSegment, RingQueue<TCPSegment>>;
+
 #endif  // SPONGE_LIBSPONGE_TCP_SEGMENT_HH
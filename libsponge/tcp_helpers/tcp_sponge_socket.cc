@@ -2,9 +2,11 @@
 
 #include "network_interface.hh"
 #include "parser.hh"
+#include "timer_wheel.hh"
 #include "tun.hh"
 #include "util.hh"
 
+#include <chrono>
 #include <cstddef>
 #include <exception>
 #include <iostream>
@@ -19,23 +21,57 @@
 using namespace std;
 
 static constexpr size_t TCP_TICK_MS = 10;
+static constexpr uint64_t TIMER_GRANULARITY_US = 10;
 
 //! \param[in] condition is a function returning true if loop should continue
+//! \details Rather than waking up every TCP_TICK_MS, the loop sleeps until the next event or the next
+//! timer in a TimerWheel: the connection's own deadline (retransmission, paced segment, end of
+//! lingering), or the datagram adapter's periodic tick.
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
-    auto base_time = timestamp_ms();
+    TimerWheel timers{TIMER_GRANULARITY_US, timestamp_us()};
+    uint64_t tcp_time = timestamp_us();
+    uint64_t adapter_time = timestamp_ms();
+
+    const auto tick_tcp = [&] {
+        const auto now = timestamp_us();
+        if (_tcp.value().active()) {
+            _tcp.value().tick_us(now - tcp_time);
+        }
+        tcp_time = now;
+    };
+
+    function<void()> tick_adapter = [&] {
+        const auto now = timestamp_ms();
+        if (_tcp.value().active()) {
+            _datagram_adapter.tick(now - adapter_time);
+        }
+        adapter_time = now;
+        timers.schedule(timestamp_us() + TCP_TICK_MS * 1000, tick_adapter);
+    };
+    timers.schedule(timestamp_us() + TCP_TICK_MS * 1000, tick_adapter);
+
+    optional<TimerWheel::TimerId> tcp_timer{};
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        // the connection's next deadline may have moved since it was last ticked
+        if (tcp_timer.has_value()) {
+            timers.cancel(tcp_timer.value());
+            tcp_timer.reset();
+        }
+        const auto tcp_wait = _tcp.value().time_until_next_tick_us();
+        if (tcp_wait.has_value()) {
+            tcp_timer = timers.schedule(tcp_time + tcp_wait.value(), tick_tcp);
+        }
+
+        const auto now = timestamp_us();
+        const auto deadline = timers.next_deadline().value_or(now + TCP_TICK_MS * 1000);
+        const auto ret = _eventloop.wait_next_event(chrono::microseconds(deadline > now ? deadline - now : 0));
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
 
-        if (_tcp.value().active()) {
-            const auto next_time = timestamp_ms();
-            _tcp.value().tick(next_time - base_time);
-            _datagram_adapter.tick(next_time - base_time);
-            base_time = next_time;
-        }
+        timers.advance(timestamp_us());
+        tick_tcp();
     }
 }
 
@@ -50,12 +86,24 @@ TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> da
     _thread_data.set_blocking(false);
 }
 
+//! \note The adapter must already be configured: the MSS is capped at the largest payload its link carries
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
-    _tcp.emplace(config);
+    TCPConfig tcp_config = config;
+    tcp_config.mss = min(tcp_config.mss, _datagram_adapter.max_payload_size());
+    _tcp.emplace(tcp_config);
 
     // Set up the event loop
 
+    // With io_uring, the adapter's datagrams are read into (and written from) slots of the ring, and a
+    // single system call per wait submits the writes and polls and collects the completed reads.
+    if (_datagram_adapter.config().io_uring) {
+        _eventloop = EventLoop{EventLoop::Backend::IoUring};
+        if (not _eventloop.attach_to_ring(_datagram_adapter)) {
+            cerr << "DEBUG: io_uring is unavailable, using epoll.\n";
+        }
+    }
+
     // There are four possible events to handle:
     //
     // 1) Incoming datagram received (needs to be given to
@@ -76,10 +124,13 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _eventloop.add_rule(_datagram_adapter,
                         Direction::In,
                         [&] {
-                            auto seg = _datagram_adapter.read();
-                            if (seg) {
-                                _tcp->segment_received(move(seg.value()));
-                            }
+                            // the adapter may have received a batch of datagrams: hand all of them to TCP
+                            do {
+                                auto seg = _datagram_adapter.read();
+                                if (seg) {
+                                    _tcp->segment_received(move(seg.value()));
+                                }
+                            } while (_datagram_adapter.read_pending() and _tcp->active());
 
                             // debugging output:
                             if (_thread_data.eof() and _tcp.value().bytes_in_flight() == 0 and not _fully_acked) {
@@ -158,6 +209,8 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
                                 _datagram_adapter.write(_tcp->segments_out().front());
                                 _tcp->segments_out().pop();
                             }
+                            // send what the adapter batched up
+                            _datagram_adapter.flush();
                         },
                         [&] { return not _tcp->segments_out().empty(); });
 }
@@ -208,10 +261,10 @@ void TCPSpongeSocket<AdaptT>::connect(const TCPConfig &c_tcp, const FdAdapterCon
         throw runtime_error("connect() with TCPConnection already initialized");
     }
 
-    _initialize_TCP(c_tcp);
-
     _datagram_adapter.config_mut() = c_ad;
 
+    _initialize_TCP(c_tcp);
+
     cerr << "DEBUG: Connecting to " << c_ad.destination.to_string() << "...\n";
     _tcp->connect();
 
@@ -236,11 +289,11 @@ void TCPSpongeSocket<AdaptT>::listen_and_accept(const TCPConfig &c_tcp, const Fd
         throw runtime_error("listen_and_accept() with TCPConnection already initialized");
     }
 
-    _initialize_TCP(c_tcp);
-
     _datagram_adapter.config_mut() = c_ad;
     _datagram_adapter.set_listening(true);
 
+    _initialize_TCP(c_tcp);
+
     cerr << "DEBUG: Listening for incoming connection...\n";
     _tcp_loop([&] {
         const auto s = _tcp->state();
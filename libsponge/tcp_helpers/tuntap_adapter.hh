@@ -21,14 +21,16 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
     //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
     std::optional<TCPSegment> read() {
         InternetDatagram ip_dgram;
-        if (ip_dgram.parse(_tun.read()) != ParseResult::NoError) {
+        if (ip_dgram.parse(read_packet(_tun)) != ParseResult::NoError) {
             return {};
         }
         return unwrap_tcp_in_ip(ip_dgram);
     }
 
-    //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    //! Creates an IPv4 datagram from a TCP segment (from each piece of a super-segment) and writes it to the TUN device
+    void write(TCPSegment &seg) {
+        seg.for_each_wire_segment([&](TCPSegment &piece) { _tun.write(wrap_tcp_in_ip(piece).serialize()); });
+    }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -1,5 +1,7 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+
 // Dummy implementation of a TCP receiver
 
 // For Lab 2, please replace with a real implementation that passes the
@@ -37,17 +39,44 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
     // -1是因为要去除SYN
     size_t index = unwrap(seqno, _isn.value(), _reassembler.stream_out().bytes_written())-1;
 
-    _reassembler.push_substring(seg.payload().copy(), index, header.fin);
+    // 记下最近一个乱序到达的段，SACK 中首先报告包含它的区间
+    if (index > _reassembler.stream_out().bytes_written() && seg.payload().size() > 0)
+        _last_out_of_order = index;
+
+    _reassembler.push_substring(seg.payload(), index, header.fin);
 
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const {
     if(!_isn.has_value())
         return nullopt;
-    auto out = _reassembler.stream_out();
+    const auto &out = _reassembler.stream_out();
     return wrap(out.bytes_written() + (out.input_ended()?2:1), _isn.value());
 }
 
 size_t TCPReceiver::window_size() const {
     return _capacity - _reassembler.stream_out().buffer_size();
 }
+
+TCPHeader::SackList TCPReceiver::sack() const {
+    TCPHeader::SackList sack;
+    if (!_isn.has_value() || _reassembler.empty())
+        return sack;
+    const auto ranges = _reassembler.received_ranges();
+    // 流下标加 1（SYN 占用一个序号）即为绝对序号
+    const auto add = [&](const pair<uint64_t, uint64_t> &range) {
+        if (sack.count < sack.blocks.size())
+            sack.blocks[sack.count++] = {wrap(range.first + 1, _isn.value()), wrap(range.second + 1, _isn.value())};
+    };
+    const auto recent = find_if(ranges.begin(), ranges.end(), [&](const auto &range) {
+        return _last_out_of_order.has_value() && range.first <= *_last_out_of_order &&
+               *_last_out_of_order < range.second;
+    });
+    if (recent != ranges.end())
+        add(*recent);
+    for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+        if (it != recent)
+            add(*it);
+    }
+    return sack;
+}
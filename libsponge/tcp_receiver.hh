@@ -24,12 +24,17 @@ class TCPReceiver {
 
     bool _fin = false;
 
+    //! stream index of the most recent segment that arrived out of order (reported first in SACK blocks)
+    std::optional<uint64_t> _last_out_of_order = std::nullopt;
+
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity) {}
+    //! \param storage how the inbound ByteStream keeps received bytes
+    TCPReceiver(const size_t capacity, const ByteStream::Storage storage = ByteStream::Storage::Ring)
+        : _reassembler(capacity, storage), _capacity(capacity) {}
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -52,6 +57,12 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief SACK blocks describing the data received out of order ([RFC 2018](\ref rfc::rfc2018))
+    //!
+    //! The block holding the most recently received segment comes first; the rest follow in
+    //! sequence order, as many as fit.
+    TCPHeader::SackList sack() const;
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
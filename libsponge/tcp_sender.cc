@@ -2,7 +2,11 @@
 
 #include "tcp_config.hh"
 
+#include <limits>
 #include <random>
+#include <string>
+#include <utility>
+#include <vector>
 
 // Dummy implementation of a TCP sender
 
@@ -17,24 +21,104 @@ using namespace std;
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
+//! \param[in] congestion_control the congestion control algorithm (None to be limited only by the receiver's window)
+TCPSender::TCPSender(const size_t capacity,
+                     const uint16_t retx_timeout,
+                     const std::optional<WrappingInt32> fixed_isn,
+                     const CongestionControl congestion_control)
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , _initial_retransmission_timeout{retx_timeout}
     , _retransmission_timeout{retx_timeout}
-    , _stream(capacity) {}
+    , _stream(capacity)
+    , _congestion(make_congestion_controller(congestion_control, TCPConfig::MAX_PAYLOAD_SIZE))
+    , _rtt(retx_timeout, TCPConfig::RTO_MIN_DFLT, TCPConfig::RTO_MAX_DFLT) {}
+
+//! \param[in] config the sender's capacity, timeouts, ISN and congestion control
+TCPSender::TCPSender(const TCPConfig &config)
+    : TCPSender(config.send_capacity, config.rt_timeout, config.fixed_isn, config.congestion_control) {
+    _rtt = RTTEstimator(config.rt_timeout, config.rto_min, config.rto_max);
+    _adaptive_rto = config.adaptive_rto;
+    _fast_retransmit = config.fast_retransmit;
+    _trim_retransmissions = config.trim_retransmissions;
+    _pacing = config.pacing;
+    _sack = config.sack;
+    _mtu_probing = config.mtu_probing;
+    _gso = config.gso;
+    _max_mss = max(config.mss, size_t{1});
+    _probe_limit = _max_mss + 1;
+    // 探测路径 MTU 时从保守的大小开始
+    set_mss(_mtu_probing ? min(_max_mss, TCPConfig::MAX_PAYLOAD_SIZE) : _max_mss);
+}
+
+void TCPSender::set_mss(const size_t mss) {
+    _mss = mss;
+    if (_congestion)
+        _congestion->set_mss(mss);
+}
+
+//! \param peer_mss the MSS option of the peer's SYN
+void TCPSender::limit_mss(const size_t peer_mss) {
+    _max_mss = min(_max_mss, max(peer_mss, size_t{1}));
+    _probe_limit = min(_probe_limit, _max_mss + 1);
+    if (_mss > _max_mss)
+        set_mss(_max_mss);
+}
+
+size_t TCPSender::gso_limit() const {
+    size_t limit = GSO_MAX_SIZE;
+    // 按节奏发送时，一个超级段不超过一个突发允许的量
+    const uint64_t rate = pacing_rate();
+    if (rate > 0)
+        limit = min<uint64_t>(limit, rate * PACING_QUANTUM_US / 1000000);
+    return max(limit / _mss, size_t{1}) * _mss;
+}
+
+size_t TCPSender::probe_size() {
+    // 连接建立后、没有丢包需要处理时才探测，并且同时只有一个探测段在途
+    if (!_mtu_probing || _probe.has_value() || _acked_seqno == 0 || _recovery_point.has_value() ||
+        _consecutive_retransmissions > 0)
+        return 0;
+    // 搜索结束一段时间后重新开始，路径 MTU 可能变大了
+    if (_probe_limit <= _max_mss && _time - _last_probe_at >= MTU_PROBE_INTERVAL_MS)
+        _probe_limit = _max_mss + 1;
+    if (_mss >= _max_mss)
+        return 0;
+    // 先直接试探上限；失败后在可行的大小和失败的大小之间二分查找
+    if (_probe_limit > _max_mss)
+        return _max_mss;
+    if (_probe_limit - _mss <= MTU_PROBE_GRANULARITY)
+        return 0;
+    return (_mss + _probe_limit) / 2;
+}
 
 uint64_t TCPSender::bytes_in_flight() const { return _next_seqno - _acked_seqno; }
 
+//! \param[in] lost_bytes outstanding sequence space that is presumed lost (and so no longer in the network)
+size_t TCPSender::congestion_room(const size_t lost_bytes) const {
+    if (!_congestion)
+        return numeric_limits<size_t>::max();
+    // 已被 SACK 的段不再占用网络，不计入在途数据
+    const size_t pipe = bytes_in_flight() - _sacked_bytes - lost_bytes;
+    const size_t cwnd = _congestion->cwnd();
+    return cwnd > pipe ? cwnd - pipe : 0;
+}
+
 void TCPSender::fill_window() {
-    if ((_window_size == 0 ? 1 : _window_size) - bytes_in_flight() <= 0)
+    // 缩放后的窗口按 2 的幂向下取整，可能比已发出的数据还小，不能直接相减
+    const size_t window = _window_size == 0 ? 1 : _window_size;
+    if (window <= bytes_in_flight())
+        return;
+    // 拥塞窗口已满时，等待确认后再发送
+    if (congestion_room() == 0)
         return;
 
     // 首次发送数据时，发送一个SYN
     if (_next_seqno == 0) {
         TCPSegment segment;
         segment.header().syn = true;
+        segment.header().sack_permitted = _sack;
         segment.header().seqno = next_seqno();
-        send_segment(segment);
+        send_segment(move(segment));
         _next_seqno++;
         return;
     }
@@ -47,31 +131,58 @@ void TCPSender::fill_window() {
         TCPSegment segment;
         segment.header().fin = true;
         segment.header().seqno = next_seqno();
-        send_segment(segment);
+        send_segment(move(segment));
         _next_seqno++;
         return;
     }
 
     // 发送数据
+    const uint64_t rate = pacing_rate();
     while (_stream.buffer_size() > 0 && _next_seqno < _stream.bytes_written() + 2) {
+        // 按照节奏发送：还没到下一个段的发送时间时，等待 tick
+        if (rate > 0 && _time_us < _next_send_us)
+            break;
         TCPSegment segment;
         segment.header().seqno = next_seqno();
-        size_t len = min(TCPConfig::MAX_PAYLOAD_SIZE, _stream.buffer_size());
-        size_t maxLen = (_window_size == 0 ? 1 : _window_size) - bytes_in_flight();
+        size_t len = min(_mss, _stream.buffer_size());
+        if (window <= bytes_in_flight())
+            break;
+        size_t maxLen = window - bytes_in_flight();
+        maxLen = min(maxLen, congestion_room());
+        // 探测路径 MTU：数据和窗口都足够时，发送一个比 MSS 大的段
+        const size_t probe = probe_size();
+        const bool probing = probe > 0 && _stream.buffer_size() >= probe && maxLen >= probe;
+        if (probing) {
+            len = probe;
+            _probe = MtuProbe{_next_seqno, probe};
+        } else if (_gso)
+            len = min(gso_limit(), _stream.buffer_size());
         len = min(len, maxLen);
 
         if (len <= 0)
             break;
 
-        segment.payload() = _stream.read(len);
+        // 从流中直接拷贝到缓冲池的存储中，同时计算校验和，序列化时无需再读一遍负载
+        if (!probing && len > _mss) {
+            // 超级段：每个 MSS 大小的部分单独求校验和，拆分时不必再读一遍负载
+            vector<InternetChecksum> piece_checksums;
+            Buffer payload = _payloads.make(len, [&](char *dst) { _stream.read(len, dst, _mss, piece_checksums); });
+            segment.set_gso_payload(move(payload), _mss, move(piece_checksums));
+        } else {
+            InternetChecksum payload_checksum;
+            Buffer payload = _payloads.make(len, [&](char *dst) { _stream.read(len, dst, payload_checksum); });
+            segment.set_payload(move(payload), payload_checksum);
+        }
         // 如果发送的数据长度小于最大负载长度（留一个位给FIN），并且输入流已关闭，那么就设置FIN标志
         if (len < maxLen && _stream.eof()) {
             segment.header().fin = true;
             _fin = true;
             _next_seqno++;
         }
-        send_segment(segment);
+        send_segment(move(segment));
         _next_seqno += len;
+        if (rate > 0)
+            _next_send_us = max(_next_send_us, _time_us - min(_time_us, PACING_QUANTUM_US)) + len * 1000000 / rate;
 
         if (len == maxLen)
             break;
@@ -80,70 +191,339 @@ void TCPSender::fill_window() {
 
 //! \param ackno The remote receiver's ackno (acknowledgment number)
 //! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+void TCPSender::ack_received(const WrappingInt32 ackno, const uint32_t window_size) {
+    ack_received(ackno, window_size, {}, true);
+}
+
+//! \param ackno The remote receiver's ackno (acknowledgment number)
+//! \param window_size The remote receiver's advertised window size
+//! \param sack The SACK blocks carried by the segment (if SACK was negotiated)
+//! \param may_be_duplicate whether the segment carried no data
+void TCPSender::ack_received(const WrappingInt32 ackno,
+                             const uint32_t window_size,
+                             const TCPHeader::SackList &sack,
+                             const bool may_be_duplicate) {
     uint64_t ackno_absolute = unwrap(ackno, _isn, _next_seqno);
 
     if (ackno_absolute > _next_seqno)
         return;
 
+    const uint32_t previous_window_size = _window_size;
     // 如果对端的ackno等于已经确认的最大序列号，那么就只更新窗口大小，不做其他操作
     if (ackno_absolute == _acked_seqno)
         _window_size = max(_window_size, window_size);
 
+    if (sack.count > 0)
+        apply_sack(sack);
+
     // 只有当对端的ackno大于已经确认的最大序列号时，才会更新已经确认的最大序列号，并更新其它状态
 //    if (ackno_absolute <= _acked_seqno)
 //        return;
 
+    const uint64_t previous_acked_seqno = _acked_seqno;
     bool updated = false;
-    while (!_segments_not_acked.empty()) {
-        auto segment = _segments_not_acked.front();
-        _acked_seqno = unwrap(segment.header().seqno, _isn, _acked_seqno);
-        if (_acked_seqno+segment.length_in_sequence_space() > ackno_absolute)
-            break;
-        _segments_not_acked.pop();
+    optional<uint64_t> rtt{};
+    // 队列中记录的是绝对序号，确认时不需要逐段 unwrap，也不需要拷贝段
+    while (!_segments_not_acked.empty() &&
+           _segments_not_acked.front().seqno + _segments_not_acked.front().acked < ackno_absolute) {
+        auto &outstanding = _segments_not_acked.front();
+        // 只用没有重传过的段测量 RTT，否则无法分辨确认的是哪一次发送
+        if (!outstanding.retransmitted)
+            rtt = _time - outstanding.sent_at;
         updated = true;
+        // 部分确认：只记下已确认的前缀，剩下的部分仍然在途
+        if (outstanding.end() > ackno_absolute) {
+            const size_t newly_acked = ackno_absolute - outstanding.seqno - outstanding.acked;
+            if (outstanding.sacked)
+                _sacked_bytes -= newly_acked;
+            outstanding.acked += newly_acked;
+            break;
+        }
+        if (outstanding.sacked)
+            _sacked_bytes -= outstanding.unacked();
+        _segments_not_acked.pop_front();
     }
 
-    if(!updated)
+    if(!updated) {
+        // 重复 ACK：不携带数据、没有确认新数据、窗口不变，且仍有数据在途
+        if (_fast_retransmit && may_be_duplicate && ackno_absolute == previous_acked_seqno &&
+            window_size == previous_window_size && !_segments_not_acked.empty())
+            duplicate_ack();
         return;
+    }
 
     _acked_seqno = ackno_absolute;
+    if (_congestion)
+        _congestion->on_ack({_time, size_t(ackno_absolute - previous_acked_seqno), bytes_in_flight(), rtt});
+    // 探测段被确认，说明路径能承载这个大小
+    if (_probe.has_value() && ackno_absolute >= _probe->seqno + _probe->size) {
+        set_mss(_probe->size);
+        _probe.reset();
+        _last_probe_at = _time;
+    }
 
     _timestamp = _time;
     _consecutive_retransmissions = 0;
-    _retransmission_timeout = _initial_retransmission_timeout;
+    if (rtt.has_value())
+        _rtt.add_sample(*rtt);
+    // 自适应 RTO 按 Karn 算法处理：确认的都是重传过的段时，保留退避后的超时时间
+    if (!_adaptive_rto)
+        _retransmission_timeout = _initial_retransmission_timeout;
+    else if (rtt.has_value())
+        _retransmission_timeout = _rtt.rto();
     _window_size = window_size;
+
+    _duplicate_acks = 0;
+    if (_recovery_point.has_value()) {
+        // 恢复点之前的数据全部确认后退出快速恢复；否则是部分确认，说明下一个段也丢了（NewReno）
+        if (ackno_absolute >= *_recovery_point)
+            _recovery_point.reset();
+        else
+            retransmit_holes();
+    }
+    fill_window();
+}
+
+void TCPSender::apply_sack(const TCPHeader::SackList &sack) {
+    for (size_t i = 0; i < sack.count; i++) {
+        const uint64_t left = unwrap(sack.blocks[i].left, _isn, _next_seqno);
+        const uint64_t right = unwrap(sack.blocks[i].right, _isn, _next_seqno);
+        // 忽略已被累计确认的、超出已发送范围的或者无效的块
+        if (right <= _acked_seqno || right > _next_seqno || left >= right)
+            continue;
+        for (size_t j = 0; j < _segments_not_acked.size(); j++) {
+            auto &outstanding = _segments_not_acked[j];
+            if (outstanding.seqno >= right)
+                break;
+            if (!outstanding.sacked && outstanding.seqno + outstanding.acked >= left && outstanding.end() <= right) {
+                outstanding.sacked = true;
+                _sacked_bytes += outstanding.unacked();
+            }
+        }
+    }
+}
+
+void TCPSender::duplicate_ack() {
+    _duplicate_acks++;
+    if (!_recovery_point.has_value()) {
+        if (_duplicate_acks < DUPLICATE_ACK_THRESHOLD)
+            return;
+        // 第三个重复 ACK：进入快速恢复，直到恢复点之前的数据都被确认
+        _recovery_point = _next_seqno;
+        for (size_t i = 0; i < _segments_not_acked.size(); i++)
+            _segments_not_acked[i].resent = false;
+        // 丢失的是探测段时，原因是它太大而不是拥塞；被 SACK 的数据已经离开网络，不算作丢包时的在途数据
+        if (_congestion && !is_probe(_segments_not_acked.front()))
+            _congestion->on_loss(_time, LossSignal::FastRetransmit, bytes_in_flight() - _sacked_bytes);
+    }
+    // SACK 可能报告了新的空洞；被 SACK 的数据离开了网络，拥塞窗口也可能允许发送新数据
+    retransmit_holes();
     fill_window();
 }
 
+void TCPSender::retransmit_holes() {
+    // 第一个未确认的段被认为已经丢失；其后没有被 SACK 的段，只有在它之后被 SACK 的段不少于 DupThresh 个，
+    // 或者字节数超过 (DupThresh - 1) * SMSS 时才被认为丢失（RFC 6675 的 IsLost）。只被 SACK 了一个后面的段
+    // 可能只是乱序，不应重传中间所有的段。满足条件的段之前的段也都满足，因此丢失的段是队列的一个前缀。
+    size_t lost_count = min<size_t>(1, _segments_not_acked.size());
+    size_t sacked_above = 0;
+    size_t sacked_bytes_above = 0;
+    for (size_t i = _segments_not_acked.size(); i > 1; i--) {
+        const auto &outstanding = _segments_not_acked[i - 1];
+        if (outstanding.sacked) {
+            sacked_above++;
+            sacked_bytes_above += outstanding.unacked();
+        } else if (sacked_above >= DUPLICATE_ACK_THRESHOLD ||
+                   sacked_bytes_above > (DUPLICATE_ACK_THRESHOLD - 1) * _mss) {
+            lost_count = i;
+            break;
+        }
+    }
+    // 丢失的段已经离开了网络，不计入在途数据
+    size_t lost_bytes = 0;
+    for (size_t i = 0; i < lost_count; i++) {
+        const auto &outstanding = _segments_not_acked[i];
+        if (!outstanding.sacked && !outstanding.resent)
+            lost_bytes += outstanding.unacked();
+    }
+
+    // 重传同样受拥塞窗口限制，但至少重传一个段
+    size_t room = congestion_room(lost_bytes);
+    bool resent_any = false;
+    for (size_t i = 0; i < lost_count; i++) {
+        auto &outstanding = _segments_not_acked[i];
+        const size_t length = outstanding.unacked();
+        if (outstanding.sacked || outstanding.resent)
+            continue;
+        if (resent_any && room < length)
+            break;
+        retransmit(outstanding);
+        outstanding.resent = true;
+        _fast_retransmissions++;
+        resent_any = true;
+        room -= min(room, length);
+    }
+}
+
+TCPSegment TCPSender::make_segment(const Outstanding &outstanding) const {
+    TCPSegment segment;
+    segment.header().seqno = wrap(outstanding.seqno, _isn);
+    segment.header().syn = outstanding.syn;
+    segment.header().sack_permitted = outstanding.syn && _sack;
+    segment.header().fin = outstanding.fin;
+    if (!_trim_retransmissions || outstanding.acked == 0) {
+        if (outstanding.checksum.has_value())
+            segment.set_payload(outstanding.payload, *outstanding.checksum);
+        else
+            segment.payload() = outstanding.payload;
+        return segment;
+    }
+    // 去掉已确认的前缀：Buffer 只移动起始位置，不拷贝数据，但校验和需要重新计算
+    size_t acked = outstanding.acked;
+    if (outstanding.syn) {
+        segment.header().syn = false;
+        segment.header().sack_permitted = false;
+        acked--;
+    }
+    segment.header().seqno = wrap(outstanding.seqno + outstanding.acked, _isn);
+    segment.payload() = outstanding.payload;
+    segment.payload().remove_prefix(acked);
+    return segment;
+}
+
+void TCPSender::retransmit(Outstanding &outstanding) {
+    // 探测段丢失，说明路径承载不了这个大小
+    if (is_probe(outstanding)) {
+        _probe_limit = _probe->size;
+        _probe.reset();
+        _last_probe_at = _time;
+    }
+    // 比当前 MSS 大的段（丢失的探测段，或者路径 MTU 变小了）分成几个段重传，FIN 留在最后一段
+    TCPSegment segment = make_segment(outstanding);
+    const Buffer payload = as_const(segment).payload();
+    size_t offset = 0;
+    for (; payload.size() - offset > _mss; offset += _mss) {
+        TCPSegment piece;
+        piece.header().seqno = segment.header().seqno + uint32_t(offset);
+        piece.payload() = payload;
+        piece.payload().remove_prefix(offset);
+        piece.payload().remove_suffix(payload.size() - offset - _mss);
+        _segments_out.push(move(piece));
+    }
+    if (offset > 0) {
+        segment.header().seqno = segment.header().seqno + uint32_t(offset);
+        segment.payload() = payload;
+        segment.payload().remove_prefix(offset);
+    }
+    _segments_out.push(move(segment));
+    outstanding.retransmitted = true;
+    _retransmissions++;
+}
+
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
-void TCPSender::tick(const size_t ms_since_last_tick) {
-    _time += ms_since_last_tick;
+void TCPSender::tick(const size_t ms_since_last_tick) { tick_us(uint64_t{ms_since_last_tick} * 1000); }
+
+//! \param[in] us_since_last_tick the number of microseconds since the last call to this method
+void TCPSender::tick_us(const uint64_t us_since_last_tick) {
+    _time_us += us_since_last_tick;
+    _time = _time_us / 1000;
     if (_segments_not_acked.empty())
         _timestamp = _time;
     else {
         if (_time - _timestamp >= _retransmission_timeout) {
-            _segments_out.push(_segments_not_acked.front());
+            const bool probe_lost = is_probe(_segments_not_acked.front());
+            // 连续超时可能是路径 MTU 变小了（黑洞）：退回保守的 MSS 重传，之后重新搜索
+            const size_t base_mss = min(_max_mss, TCPConfig::MAX_PAYLOAD_SIZE);
+            if (_mtu_probing && _consecutive_retransmissions + 1 >= MTU_BLACK_HOLE_TIMEOUTS && _mss > base_mss) {
+                set_mss(base_mss);
+                _probe.reset();
+                _probe_limit = _max_mss + 1;
+                _last_probe_at = _time;
+            }
+            retransmit(_segments_not_acked.front());
             _timestamp = _time;
             // 如果窗口大小为0，那么就会一直以稳定的速率重传1个字节的数据，以探测对端是否已经恢复
             if(_window_size!=0){
+                // 同一个段再次超时不算新的丢包事件
+                if (_congestion && _consecutive_retransmissions == 0 && !probe_lost)
+                    _congestion->on_loss(_time, LossSignal::Timeout, bytes_in_flight());
+                // 超时后退出快速恢复，并且不再依据之前的 SACK 信息（接收方可能已丢弃这些数据）
+                _recovery_point.reset();
+                _duplicate_acks = 0;
+                for (size_t i = 0; i < _segments_not_acked.size(); i++)
+                    _segments_not_acked[i].sacked = false;
+                _sacked_bytes = 0;
                 _consecutive_retransmissions++;
-                _retransmission_timeout *= 2;
+                if (_adaptive_rto)
+                    _retransmission_timeout = _rtt.clamp(2 * uint64_t(_retransmission_timeout));
+                else
+                    _retransmission_timeout *= 2;
             }
         }
     }
+    // 按节奏可以发送下一个段了
+    if (pacing_rate() > 0 && _stream.buffer_size() > 0 && _next_send_us <= _time_us)
+        fill_window();
+}
+
+uint64_t TCPSender::pacing_rate() const { return _pacing && _congestion ? _congestion->pacing_rate() : 0; }
+
+optional<uint64_t> TCPSender::time_until_next_tick_us() const {
+    optional<uint64_t> wait{};
+    if (!_segments_not_acked.empty()) {
+        const uint64_t expiry_us = (uint64_t{_timestamp} + _retransmission_timeout) * 1000;
+        wait = expiry_us > _time_us ? expiry_us - _time_us : 0;
+    }
+    // 有数据在等待发送，且只是因为节奏而没有发出
+    if (pacing_rate() > 0 && _stream.buffer_size() > 0 && _next_send_us > _time_us)
+        wait = min(wait.value_or(UINT64_MAX), _next_send_us - _time_us);
+    return wait;
 }
 
 unsigned int TCPSender::consecutive_retransmissions() const { return _consecutive_retransmissions; }
 
+TCPSenderStats TCPSender::stats() const {
+    return {_rtt.srtt(),
+            _rtt.rttvar(),
+            _retransmission_timeout,
+            _rtt.samples(),
+            _retransmissions,
+            _fast_retransmissions};
+}
+
 void TCPSender::send_empty_segment() {
     TCPSegment segment;
     segment.header().seqno = next_seqno();
     segment.header().ack = true;
-    _segments_out.push(segment);
+    _segments_out.push(move(segment));
 }
 
-void TCPSender::send_segment(const TCPSegment &segment) {
-    _segments_out.push(segment);
-    _segments_not_acked.push(segment);
+void TCPSender::send_segment(TCPSegment &&sent) {
+    const TCPSegment &segment = sent;
+    // 超级段的每个部分分别记录，确认、SACK 和重传仍以线上的段为单位
+    const uint64_t seqno = unwrap(segment.header().seqno, _isn, _next_seqno);
+    const Buffer &payload = segment.payload();
+    const bool split = segment.gso_size() > 0;
+    const size_t step = split ? segment.gso_size() : payload.size();
+    size_t offset = 0;
+    for (size_t i = 0; offset < payload.size() || i == 0; i++) {
+        const size_t len = min(step, payload.size() - offset);
+        Outstanding outstanding;
+        outstanding.seqno = seqno + offset;
+        outstanding.payload = payload;
+        if (split) {
+            outstanding.payload.remove_prefix(offset);
+            outstanding.payload.remove_suffix(payload.size() - offset - len);
+            if (i < segment.piece_checksums().size())
+                outstanding.checksum = segment.piece_checksums()[i];
+        } else
+            outstanding.checksum = segment.payload_checksum();
+        outstanding.syn = segment.header().syn;
+        outstanding.fin = segment.header().fin && offset + len == payload.size();
+        outstanding.sent_at = _time;
+        _segments_not_acked.push_back(move(outstanding));
+        offset += len;
+    }
+    // 记录完成后再把段移入发送队列，负载与记录共享存储
+    _segments_out.push(move(sent));
 }
\ No newline at end of file
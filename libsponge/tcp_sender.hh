@@ -2,13 +2,27 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "ring_queue.hh"
+#include "rtt_estimator.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
 #include <functional>
+#include <memory>
 #include <queue>
 
+//! Round-trip time and retransmission statistics of a TCPSender
+struct TCPSenderStats {
+    std::optional<double> srtt_ms{};   //!< Smoothed round-trip time, once one has been measured
+    double rttvar_ms{0};               //!< Round-trip time variation
+    uint64_t rto_ms{0};                //!< Current retransmission timeout, including any backoff
+    uint64_t rtt_samples{0};           //!< Number of round-trip times measured
+    uint64_t retransmissions{0};       //!< Number of segments retransmitted
+    uint64_t fast_retransmissions{0};  //!< Of those, the number retransmitted without waiting for the timer
+};
+
 //! \brief The "sender" part of a TCP implementation.
 
 //! Accepts a ByteStream, divides it up into segments and sends the
@@ -21,10 +35,35 @@ class TCPSender {
     WrappingInt32 _isn;
 
     //! outbound queue of segments that the TCPSender wants sent
-    std::queue<TCPSegment> _segments_out{};
+    TCPSegmentQueue _segments_out{};
+
+    //! storage that the payloads of new segments are copied into; a slab is reused once all the
+    //! segments carved from it have been acknowledged and sent
+    BufferPool _payloads{};
+
+    //! A segment that has been sent but not yet (fully) acked
+    struct Outstanding {
+        uint64_t seqno{0};  //!< absolute sequence number of the segment
+        Buffer payload{};   //!< the payload (shares storage with the sent segment)
+        bool syn{false};
+        bool fin{false};
+        size_t acked{0};  //!< sequence space at the front that has been acknowledged
+
+        //! checksum of `payload`, so that retransmitting it does not read the payload again
+        std::optional<InternetChecksum> checksum{};
+
+        size_t sent_at{0};          //!< time of the first transmission
+        bool retransmitted{false};  //!< RTT samples are not taken from retransmitted segments (Karn's algorithm)
+        bool sacked{false};         //!< the receiver has selectively acknowledged the segment
+        bool resent{false};         //!< retransmitted during the current fast recovery
 
-    //! queue of segments that are not yet acked
-    std::queue<TCPSegment> _segments_not_acked{};
+        size_t length() const { return syn + payload.size() + fin; }
+        uint64_t end() const { return seqno + length(); }
+        size_t unacked() const { return length() - acked; }
+    };
+
+    //! segments that are not yet (fully) acked, oldest first
+    RingQueue<Outstanding> _segments_not_acked{};
 
     //! retransmission timer for the connection
     unsigned int _initial_retransmission_timeout;
@@ -40,21 +79,122 @@ class TCPSender {
     //! the (absolute) sequence number for the last byte acked
     uint64_t _acked_seqno{0};
 
+    //! the sender's clock, in milliseconds (whole milliseconds of `_time_us`)
     size_t _time{0};
 
+    uint64_t _time_us{0};
+
     size_t _timestamp{0};
 
     unsigned int _consecutive_retransmissions{0};
 
-    uint16_t _window_size{1};
+    uint32_t _window_size{1};
 
     bool _fin{false};
 
+    //! congestion controller (nullptr if the sender is limited only by the receiver's window)
+    std::unique_ptr<CongestionController> _congestion;
+
+    //! RTT estimator (always measured, but only sets the timeout if `_adaptive_rto` is set)
+    RTTEstimator _rtt;
+
+    bool _adaptive_rto{false};
+
+    //! retransmit only the unacknowledged part of a partially acknowledged segment
+    bool _trim_retransmissions{false};
+
+    //! \name Pacing: spread the segments of a window over the RTT at the controller's pacing rate
+    //!@{
+    //! the sender may run up to this far behind its pacing schedule, so that coarse ticks do not slow it down
+    static constexpr uint64_t PACING_QUANTUM_US = 1000;
+
+    bool _pacing{false};
+    uint64_t _next_send_us{0};  //!< when the pacing schedule lets the next data segment go out
+    //!@}
+
+    //! the rate to pace data segments at, in bytes per second (0 if they are not paced)
+    uint64_t pacing_rate() const;
+
+    uint64_t _retransmissions{0};
+
+    //! \name Fast retransmit and recovery
+    //!@{
+    static constexpr unsigned DUPLICATE_ACK_THRESHOLD = 3;
+
+    bool _fast_retransmit{false};
+    bool _sack{false};  //!< offer SACK-permitted on our SYN
+    unsigned _duplicate_acks{0};
+    std::optional<uint64_t> _recovery_point{};  //!< _next_seqno when fast recovery began (empty if not recovering)
+    size_t _sacked_bytes{0};                    //!< sequence space of the outstanding segments that were SACKed
+    uint64_t _fast_retransmissions{0};
+    //!@}
+
+    //! \name Segmentation offload: send several MSS of new data as one super-segment
+    //!@{
+    static constexpr size_t GSO_MAX_SIZE = 65536;  //!< largest super-segment payload
+
+    bool _gso{false};
+
+    //! payload size of the next super-segment: as much as GSO_MAX_SIZE allows, but no more than the
+    //! pacing schedule releases at once
+    size_t gso_limit() const;
+    //!@}
+
+    //! \name Segment size, and path MTU discovery by probing with larger segments (RFC 4821)
+    //!@{
+    static constexpr size_t MTU_PROBE_GRANULARITY = 8;       //!< stop searching once the bounds are this close
+    static constexpr size_t MTU_PROBE_INTERVAL_MS = 600000;  //!< search again (the path may have changed) after this
+    static constexpr unsigned MTU_BLACK_HOLE_TIMEOUTS = 2;   //!< timeouts in a row after which to fall back
+
+    size_t _mss{TCPConfig::MAX_PAYLOAD_SIZE};      //!< payload size of the segments sent now
+    size_t _max_mss{TCPConfig::MAX_PAYLOAD_SIZE};  //!< largest payload that we and the peer accept
+    bool _mtu_probing{false};
+    size_t _probe_limit{TCPConfig::MAX_PAYLOAD_SIZE + 1};  //!< smallest probe size that was lost
+    size_t _last_probe_at{0};                              //!< when the last probe was acked or lost
+
+    //! the probe in flight: its sequence number and size
+    struct MtuProbe {
+        uint64_t seqno;
+        size_t size;
+    };
+    std::optional<MtuProbe> _probe{};
+
+    void set_mss(const size_t mss);
+
+    //! size of the probe to send next, or 0 if no probe should be sent now
+    size_t probe_size();
+
+    bool is_probe(const Outstanding &outstanding) const {
+        return _probe.has_value() && outstanding.seqno == _probe->seqno;
+    }
+    //!@}
+
+    //! rebuild the segment to retransmit for `outstanding`
+    TCPSegment make_segment(const Outstanding &outstanding) const;
+
+    void retransmit(Outstanding &outstanding);
+
+    //! mark the outstanding segments covered by SACK blocks
+    void apply_sack(const TCPHeader::SackList &sack);
+
+    //! a duplicate ACK arrived: enter fast recovery on the third one
+    void duplicate_ack();
+
+    //! during fast recovery, retransmit the segments that are presumed lost and not yet resent
+    void retransmit_holes();
+
+    //! bytes that the congestion window allows to be sent right now
+    size_t congestion_room(const size_t lost_bytes = 0) const;
+
   public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const CongestionControl congestion_control = CongestionControl::None);
+
+    //! Initialize a TCPSender from the sender fields of a TCPConfig
+    explicit TCPSender(const TCPConfig &config);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -66,18 +206,33 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    void ack_received(const WrappingInt32 ackno, const uint32_t window_size);
+
+    //! \brief A new acknowledgment was received, along with the SACK blocks of its segment
+    //! \param may_be_duplicate whether the segment carried no data, so that it counts as a duplicate
+    //!                         ACK if it acknowledges nothing new
+    void ack_received(const WrappingInt32 ackno,
+                      const uint32_t window_size,
+                      const TCPHeader::SackList &sack,
+                      const bool may_be_duplicate);
+
+    //! \brief The peer's SYN offered a maximum segment size: send no larger payloads
+    void limit_mss(const size_t peer_mss);
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
 
-    void send_segment(const TCPSegment& segment);
+    //! \brief Send a segment, and keep track of it (of each of its pieces, if it is a super-segment) until it is acked
+    void send_segment(TCPSegment &&segment);
 
     //! \brief create and send segments to fill as much of the window as possible
     void fill_window();
 
     //! \brief Notifies the TCPSender of the passage of time
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief Notifies the TCPSender of the passage of time, with microsecond resolution
+    void tick_us(const uint64_t us_since_last_tick);
     //!@}
 
     //! \name Accessors
@@ -95,7 +250,21 @@ class TCPSender {
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
     //! (ackno and window size) before sending.
-    std::queue<TCPSegment> &segments_out() { return _segments_out; }
+    TCPSegmentQueue &segments_out() { return _segments_out; }
+
+    //! \brief The congestion controller (cwnd, ssthresh and pacing rate), or nullptr if there is none
+    const CongestionController *congestion_controller() const { return _congestion.get(); }
+
+    //! \brief RTT estimate and retransmission counters
+    TCPSenderStats stats() const;
+
+    //! \brief Payload size of the segments sent now
+    size_t mss() const { return _mss; }
+
+    //! \brief Time until the sender next needs a tick: the retransmission timer expires, or
+    //! pacing lets a waiting segment go out
+    //! \returns empty if no timer is running
+    std::optional<uint64_t> time_until_next_tick_us() const;
     //!@}
 
     //! \name What is the next sequence number? (used for testing)
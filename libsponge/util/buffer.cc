@@ -7,11 +7,42 @@ void Buffer::remove_prefix(const size_t n) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    _length -= n;
+    if (_storage and _length == 0) {
         _storage.reset();
     }
 }
 
+void Buffer::remove_suffix(const size_t n) {
+    if (n > str().size()) {
+        throw out_of_range("Buffer::remove_suffix");
+    }
+    _length -= n;
+    if (_storage and _length == 0) {
+        _storage.reset();
+    }
+}
+
+void BufferPool::next_slab() {
+    _used = 0;
+    // slabs are filled in turn, so the one after the current slab is the one most likely to be idle
+    for (size_t i = 1; i <= _slabs.size(); i++) {
+        const size_t candidate = (_current + i) % _slabs.size();
+        if (_slabs[candidate].use_count() == 1) {
+            _current = candidate;
+            return;
+        }
+    }
+    auto slab = make_shared<string>(_slab_size, '\0');
+    if (_slabs.size() < MAX_SLABS) {
+        _current = _slabs.size();
+        _slabs.push_back(move(slab));
+    } else {
+        // every slab is in use: let go of the current one (its Buffers keep it alive) and replace it
+        _slabs[_current] = move(slab);
+    }
+}
+
 void BufferList::append(const BufferList &other) {
     for (const auto &buf : other._buffers) {
         _buffers.push_back(buf);
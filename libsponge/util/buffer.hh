@@ -16,12 +16,18 @@ class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
     size_t _starting_offset{};
+    size_t _length{};
 
   public:
     Buffer() = default;
 
     //! \brief Construct by taking ownership of a string
-    Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
+    Buffer(std::string &&str) noexcept
+        : _storage(std::make_shared<std::string>(std::move(str))), _length(_storage->size()) {}
+
+    //! \brief Construct a view of `length` bytes of shared storage, starting at `offset`
+    Buffer(std::shared_ptr<std::string> storage, const size_t offset, const size_t length)
+        : _storage(std::move(storage)), _starting_offset(offset), _length(length) {}
 
     //! \name Expose contents as a std::string_view
     //!@{
@@ -29,7 +35,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->data() + _starting_offset, _length};
     }
 
     operator std::string_view() const { return str(); }
@@ -47,6 +53,78 @@ class Buffer {
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Like remove_prefix, only shrinks this view of the shared storage.
+    void remove_suffix(const size_t n);
+};
+
+//! \brief Carves Buffers out of large slabs of storage, and reuses each slab once no Buffer refers to it
+//! \details Making a Buffer from a std::string takes two allocations (the string and its shared
+//! ownership). Carving it out of a slab takes none, except when a new slab is needed; and a slab
+//! whose Buffers have all been destroyed is filled again rather than freed, so a steady flow of
+//! short-lived Buffers (such as the payloads of segments until they are acknowledged) does not
+//! allocate at all. At most MAX_SLABS slabs are kept for reuse.
+class BufferPool {
+  public:
+    static constexpr size_t DEFAULT_SLAB_SIZE = 65536;
+    static constexpr size_t MAX_SLABS = 64;
+
+  private:
+    size_t _slab_size;
+    std::vector<std::shared_ptr<std::string>> _slabs{};
+    size_t _current{0};  //!< index in `_slabs` of the slab being filled
+    size_t _used{0};     //!< bytes of it already handed out
+
+    //! \brief Move on to a slab with room for `len` bytes: an idle one if there is one, else a new one
+    void next_slab();
+
+  public:
+    explicit BufferPool(const size_t slab_size = DEFAULT_SLAB_SIZE) : _slab_size(slab_size) {}
+
+    //! Size of each slab, and so of the largest Buffer made without an allocation of its own
+    size_t slab_size() const { return _slab_size; }
+
+    //! \brief A Buffer of `len` bytes, written by `fill(char *dst)`
+    //! \note A Buffer larger than a slab gets storage of its own.
+    template <typename Fill>
+    Buffer make(const size_t len, Fill &&fill) {
+        if (len > _slab_size) {
+            std::string storage(len, '\0');
+            fill(storage.data());
+            return Buffer{std::move(storage)};
+        }
+        if (_slabs.empty() or _used + len > _slab_size) {
+            next_slab();
+        }
+        fill(_slabs[_current]->data() + _used);
+        Buffer ret{_slabs[_current], _used, len};
+        _used += len;
+        return ret;
+    }
+
+    //! \brief A Buffer of up to `capacity` bytes, written by `size_t fill(char *dst)`, which returns how many it wrote
+    //! \details For reading into a Buffer before knowing how long it will be: `fill` gets `capacity` bytes of
+    //! slab, and only what it writes is taken from the slab. The storage is not cleared first. If `fill`
+    //! throws, nothing is taken.
+    template <typename Fill>
+    Buffer make_up_to(const size_t capacity, Fill &&fill) {
+        if (capacity > _slab_size) {
+            std::string storage(capacity, '\0');
+            storage.resize(fill(storage.data()));
+            return Buffer{std::move(storage)};
+        }
+        if (_slabs.empty() or _used + capacity > _slab_size) {
+            next_slab();
+        }
+        const size_t len = fill(_slabs[_current]->data() + _used);
+        if (len == 0) {
+            return {};
+        }
+        Buffer ret{_slabs[_current], _used, len};
+        _used += len;
+        return ret;
+    }
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
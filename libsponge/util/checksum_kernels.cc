@@ -0,0 +1,219 @@
+#include "checksum_kernels.hh"
+
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SPONGE_CHECKSUM_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+//! Add with end-around carry, so that no carry out of the 64-bit accumulator is lost
+inline uint64_t add_with_carry(uint64_t acc, const uint64_t value) {
+    acc += value;
+    return acc + (acc < value);
+}
+
+//! Fold a 64-bit one's-complement accumulator down to 16 bits
+inline uint16_t fold(uint64_t acc) {
+    acc = (acc >> 32) + (acc & 0xffffffff);
+    acc = (acc >> 32) + (acc & 0xffffffff);
+    acc = (acc >> 16) + (acc & 0xffff);
+    acc = (acc >> 16) + (acc & 0xffff);
+    return acc;
+}
+
+template <typename T>
+inline T load(const char *data) {
+    T value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+//! Copy `len` bytes to `dst` if the kernel is the fused copy-and-checksum variant
+template <bool COPY>
+inline void copy_if(char *&dst, const char *src, const size_t len) {
+    if constexpr (COPY) {
+        memcpy(dst, src, len);
+        dst += len;
+    }
+}
+
+//! Sum of the bytes as host-order 16-bit words, unfolded (at most 2^64 - 1 before the fold)
+//! \note With COPY set, each block is also stored to `dst` while it is in registers.
+template <bool COPY>
+uint64_t sum_scalar(char *dst, const char *data, size_t len) {
+    // two independent accumulators, so consecutive additions do not wait on each other's carry
+    uint64_t acc0 = 0, acc1 = 0;
+    while (len >= 16) {
+        const uint64_t w0 = load<uint64_t>(data);
+        const uint64_t w1 = load<uint64_t>(data + 8);
+        acc0 = add_with_carry(acc0, w0);
+        acc1 = add_with_carry(acc1, w1);
+        copy_if<COPY>(dst, data, 16);
+        data += 16;
+        len -= 16;
+    }
+    uint64_t acc = add_with_carry(acc0, acc1);
+    if (len >= 8) {
+        acc = add_with_carry(acc, load<uint64_t>(data));
+        copy_if<COPY>(dst, data, 8);
+        data += 8;
+        len -= 8;
+    }
+    if (len >= 4) {
+        acc = add_with_carry(acc, load<uint32_t>(data));
+        copy_if<COPY>(dst, data, 4);
+        data += 4;
+        len -= 4;
+    }
+    if (len >= 2) {
+        acc = add_with_carry(acc, load<uint16_t>(data));
+        copy_if<COPY>(dst, data, 2);
+        data += 2;
+        len -= 2;
+    }
+    if (len == 1) {
+        // the odd byte is the first byte of a zero-padded word, whatever the host byte order
+        uint16_t last = 0;
+        memcpy(&last, data, 1);
+        acc = add_with_carry(acc, last);
+        copy_if<COPY>(dst, data, 1);
+    }
+    return acc;
+}
+
+#ifdef SPONGE_CHECKSUM_X86
+// The vector kernels split every 32-bit lane into its two 16-bit words (mask and shift) and add
+// them into separate 32-bit lane accumulators. Each lane gains at most 0xffff per step, so the
+// accumulators are flushed into the 64-bit total long before they could overflow.
+constexpr size_t STEPS_PER_FLUSH = 32768;
+
+template <bool COPY>
+uint64_t sum_sse2(char *dst, const char *data, size_t len) {
+    const __m128i low_words = _mm_set1_epi32(0xffff);
+    uint64_t total = 0;
+    while (len >= 32) {
+        __m128i acc0 = _mm_setzero_si128(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+        for (size_t step = 0; step < STEPS_PER_FLUSH and len >= 32; step++) {
+            const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+            const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16));
+            acc0 = _mm_add_epi32(acc0, _mm_and_si128(v0, low_words));
+            acc1 = _mm_add_epi32(acc1, _mm_srli_epi32(v0, 16));
+            acc2 = _mm_add_epi32(acc2, _mm_and_si128(v1, low_words));
+            acc3 = _mm_add_epi32(acc3, _mm_srli_epi32(v1, 16));
+            if constexpr (COPY) {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), v0);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), v1);
+                dst += 32;
+            }
+            data += 32;
+            len -= 32;
+        }
+        for (const __m128i acc : {acc0, acc1, acc2, acc3}) {
+            uint32_t parts[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(parts), acc);
+            for (const uint32_t part : parts) {
+                total = add_with_carry(total, part);
+            }
+        }
+    }
+    return add_with_carry(total, sum_scalar<COPY>(dst, data, len));
+}
+
+template <bool COPY>
+__attribute__((target("avx2"))) uint64_t sum_avx2(char *dst, const char *data, size_t len) {
+    const __m256i low_words = _mm256_set1_epi32(0xffff);
+    uint64_t total = 0;
+    while (len >= 64) {
+        __m256i acc0 = _mm256_setzero_si256(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+        for (size_t step = 0; step < STEPS_PER_FLUSH and len >= 64; step++) {
+            const __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+            const __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + 32));
+            acc0 = _mm256_add_epi32(acc0, _mm256_and_si256(v0, low_words));
+            acc1 = _mm256_add_epi32(acc1, _mm256_srli_epi32(v0, 16));
+            acc2 = _mm256_add_epi32(acc2, _mm256_and_si256(v1, low_words));
+            acc3 = _mm256_add_epi32(acc3, _mm256_srli_epi32(v1, 16));
+            if constexpr (COPY) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), v0);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 32), v1);
+                dst += 64;
+            }
+            data += 64;
+            len -= 64;
+        }
+        for (const __m256i acc : {acc0, acc1, acc2, acc3}) {
+            uint32_t parts[8];
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(parts), acc);
+            for (const uint32_t part : parts) {
+                total = add_with_carry(total, part);
+            }
+        }
+    }
+    // clear the upper halves before running non-VEX code (the scalar tail's copies use SSE moves),
+    // which would otherwise pay the AVX-SSE transition penalty on every instruction
+    _mm256_zeroupper();
+    return add_with_carry(total, sum_scalar<COPY>(dst, data, len));
+}
+#endif  // SPONGE_CHECKSUM_X86
+
+//! Run `kernel`, copying to `dst` as well if COPY is set
+template <bool COPY>
+uint16_t run_kernel(char *dst, const char *data, const size_t len, const ChecksumKernel kernel) {
+    switch (kernel) {
+        case ChecksumKernel::Scalar:
+            return fold(sum_scalar<COPY>(dst, data, len));
+#ifdef SPONGE_CHECKSUM_X86
+        case ChecksumKernel::SSE2:
+            return fold(sum_sse2<COPY>(dst, data, len));
+        case ChecksumKernel::AVX2:
+            return fold(sum_avx2<COPY>(dst, data, len));
+#endif
+        default:
+            throw runtime_error("checksum kernel not available on this platform");
+    }
+}
+
+}  // namespace
+
+bool checksum_kernel_supported(const ChecksumKernel kernel) {
+    switch (kernel) {
+        case ChecksumKernel::Scalar:
+            return true;
+#ifdef SPONGE_CHECKSUM_X86
+        case ChecksumKernel::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case ChecksumKernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+//! \details SSE2 is never picked: with only four 32-bit lanes it does fewer useful additions per
+//! instruction than the 64-bit scalar loop, which measured faster on every size we tried.
+ChecksumKernel checksum_best_kernel() {
+    static const ChecksumKernel best =
+        checksum_kernel_supported(ChecksumKernel::AVX2) ? ChecksumKernel::AVX2 : ChecksumKernel::Scalar;
+    return best;
+}
+
+//! \param[in] data the bytes to sum
+//! \param[in] len number of bytes
+//! \param[in] kernel which loop to use (must be supported by this CPU)
+uint16_t checksum_partial(const char *data, const size_t len, const ChecksumKernel kernel) {
+    return run_kernel<false>(nullptr, data, len, kernel);
+}
+
+//! \param[out] dst where to copy the bytes (must not overlap `src`)
+//! \param[in] src the bytes to copy and sum
+//! \param[in] len number of bytes
+//! \param[in] kernel which loop to use (must be supported by this CPU)
+uint16_t checksum_copy_partial(char *dst, const char *src, const size_t len, const ChecksumKernel kernel) {
+    return run_kernel<true>(dst, src, len, kernel);
+}
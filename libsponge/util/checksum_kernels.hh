@@ -0,0 +1,30 @@
+#ifndef SPONGE_LIBSPONGE_CHECKSUM_KERNELS_HH
+#define SPONGE_LIBSPONGE_CHECKSUM_KERNELS_HH
+
+#include <cstddef>
+#include <cstdint>
+
+//! \brief The word-at-a-time summing loops behind InternetChecksum::add
+enum class ChecksumKernel {
+    Scalar,  //!< 64 bits per addition with end-around carry; works everywhere
+    SSE2,    //!< 128 bits per step, x86 only
+    AVX2     //!< 256 bits per step, x86 CPUs that support AVX2 only
+};
+
+//! \brief Whether `kernel` can run on this CPU
+bool checksum_kernel_supported(const ChecksumKernel kernel);
+
+//! \brief The fastest kernel this CPU supports (decided once, on first use)
+ChecksumKernel checksum_best_kernel();
+
+//! \brief One's-complement sum of `len` bytes, read as 16-bit words in *host* byte order
+//! \details A trailing odd byte is summed as if it were followed by a zero byte. The result is
+//! folded to 16 bits and is zero only if every byte is zero. Because the one's-complement sum
+//! does not depend on byte order ([RFC 1071](\ref rfc::rfc1071) section 2), converting the
+//! result from big-endian to host order gives the network-order sum of the same bytes.
+uint16_t checksum_partial(const char *data, const size_t len, const ChecksumKernel kernel);
+
+//! \brief checksum_partial() fused with a copy: each block is stored to `dst` as it is summed
+uint16_t checksum_copy_partial(char *dst, const char *src, const size_t len, const ChecksumKernel kernel);
+
+#endif  // SPONGE_LIBSPONGE_CHECKSUM_KERNELS_HH
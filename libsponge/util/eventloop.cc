@@ -2,7 +2,13 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <iterator>
+#include <poll.h>
 #include <stdexcept>
 #include <system_error>
 #include <utility>
@@ -10,22 +16,228 @@
 
 using namespace std;
 
+//! Most ready fds reported by one epoll wait; any others are reported by the next
+static constexpr size_t MAX_READY = 1024;
+
+//! Calls [epoll_pwait2(2)](\ref man2::epoll_pwait2), which needs Linux 5.11 and glibc 2.35; fails with ENOSYS
+//! if either is older
+static int epoll_pwait2_if_supported(const int epfd, epoll_event *events, const int max, const timespec *timeout) {
+#if defined(__GLIBC__) and (__GLIBC__ > 2 or (__GLIBC__ == 2 and __GLIBC_MINOR__ >= 35))
+    return ::epoll_pwait2(epfd, events, max, timeout, nullptr);
+#else
+    (void)epfd, (void)events, (void)max, (void)timeout;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
 unsigned int EventLoop::Rule::service_count() const {
     return direction == Direction::In ? fd.read_count() : fd.write_count();
 }
 
+//! \param[in] backend is Backend::Poll to call [poll(2)](\ref man2::poll) on every rule at each wait,
+//!                    or Backend::Epoll or Backend::EpollEdge to keep the fds registered with epoll,
+//!                    or Backend::IoUring to submit polls and I/O to an io_uring
+EventLoop::EventLoop(const Backend backend) : _backend(backend) {
+    if (backend == Backend::IoUring) {
+        if (IoUring::available()) {
+            _io = make_shared<IoUringDatagrams>();
+            return;
+        }
+        _backend = Backend::Epoll;
+    }
+    if (_backend != Backend::Poll) {
+        _epoll.emplace(SystemCall("epoll_create1", ::epoll_create1(EPOLL_CLOEXEC)));
+        _ready.resize(MAX_READY);
+    }
+}
+
 //! \param[in] fd is the FileDescriptor to be polled
 //! \param[in] direction indicates whether to poll for reading (Direction::In) or writing (Direction::Out)
 //! \param[in] callback is called when `fd` is ready.
 //! \param[in] interest is called by EventLoop::wait_next_event. If it returns `true`, `fd` will
 //!                     be polled, otherwise `fd` will be ignored only for this execution of `wait_next_event.
 //! \param[in] cancel is called when the rule is cancelled (e.g. on hangup, EOF, or closure).
-void EventLoop::add_rule(const FileDescriptor &fd,
-                         const Direction direction,
-                         const CallbackT &callback,
-                         const InterestT &interest,
-                         const CallbackT &cancel) {
-    _rules.push_back({fd.duplicate(), direction, callback, interest, cancel});
+//! \returns an id for enable() and disable()
+EventLoop::RuleId EventLoop::add_rule(const FileDescriptor &fd,
+                                      const Direction direction,
+                                      const CallbackT &callback,
+                                      const InterestT &interest,
+                                      const CallbackT &cancel) {
+    const RuleId id = _next_id++;
+    _rules.push_back({fd.duplicate(), direction, callback, interest, cancel, id, true, false, 0});
+    const RuleIter rule = prev(_rules.end());
+    _rule_ids.emplace(id, rule);
+    if (not _epoll and not _io) {
+        return id;
+    }
+
+    const int fd_num = fd.fd_num();
+    auto reg = _registrations.find(fd_num);
+    if (reg != _registrations.end()) {
+        // the number may still be registered for an fd that was closed (and reused by the kernel)
+        // before its rules noticed
+        vector<RuleIter> stale;
+        copy_if(reg->second.rules.begin(), reg->second.rules.end(), back_inserter(stale), [](const RuleIter &r) {
+            return r->fd.closed();
+        });
+        for (const RuleIter &r : stale) {
+            cancel_rule(r);
+        }
+        reg = _registrations.find(fd_num);
+    }
+    if (reg == _registrations.end()) {
+        if (_epoll) {
+            epoll_event event{};
+            event.data.fd = fd_num;
+            SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_ADD, fd_num, &event));
+        }
+        reg = _registrations.emplace(fd_num, Registration{}).first;
+    }
+    reg->second.rules.push_back(rule);
+    if (is_datagram_rule(*rule)) {
+        _datagram_rules.push_back(rule);
+    }
+
+    if (rule->interest) {
+        _polled_rules.push_back(rule);
+    } else {
+        _enabled_explicit++;
+        set_interested(*rule, true);
+    }
+    return id;
+}
+
+//! \param[in] fd is the FileDescriptor to be watched
+//! \param[in] direction indicates whether to watch for reading (Direction::In) or writing (Direction::Out)
+//! \param[in] callback is called when `fd` is ready, while the rule is enabled
+//! \param[in] cancel is called when the rule is cancelled (e.g. on hangup, EOF, or closure).
+//! \returns an id for enable() and disable()
+EventLoop::RuleId EventLoop::add_explicit_rule(const FileDescriptor &fd,
+                                               const Direction direction,
+                                               const CallbackT &callback,
+                                               const CallbackT &cancel) {
+    return add_rule(fd, direction, callback, InterestT{}, cancel);
+}
+
+void EventLoop::enable(const RuleId id) {
+    const auto found = _rule_ids.find(id);
+    if (found == _rule_ids.end() or found->second->enabled) {
+        return;
+    }
+    Rule &rule = *found->second;
+    rule.enabled = true;
+    if ((_epoll or _io) and not rule.interest) {
+        _enabled_explicit++;
+        if ((rule.direction == Direction::In and rule.fd.eof()) or rule.fd.closed()) {
+            cancel_rule(found->second);
+            return;
+        }
+        set_interested(rule, true);
+    }
+}
+
+void EventLoop::disable(const RuleId id) {
+    const auto found = _rule_ids.find(id);
+    if (found == _rule_ids.end() or not found->second->enabled) {
+        return;
+    }
+    Rule &rule = *found->second;
+    rule.enabled = false;
+    if (_epoll or _io) {
+        if (not rule.interest) {
+            _enabled_explicit--;
+        }
+        set_interested(rule, false);
+    }
+}
+
+void EventLoop::set_interested(Rule &rule, const bool interested) {
+    if (rule.interested != interested) {
+        rule.interested = interested;
+        if (_io) {
+            arm(rule);
+        } else {
+            update_registration(rule.fd.fd_num());
+        }
+    }
+}
+
+void EventLoop::arm(Rule &rule) {
+    if (is_datagram_rule(rule)) {
+        if (rule.interested) {
+            _io->start_reads(rule.fd.fd_num());
+        }
+        return;
+    }
+    IoUring &ring = _io->ring();
+    if (rule.interested) {
+        rule.generation++;
+        ring.prepare_poll(rule.fd.fd_num(), rule.direction == Direction::In ? POLLIN : POLLOUT, poll_tag(rule));
+    } else {
+        ring.prepare_poll_remove(poll_tag(rule), 0);
+    }
+}
+
+//! \param[in] fd is the FileDescriptor whose datagrams to read and write through the ring
+bool EventLoop::attach_to_ring(const FileDescriptor &fd) { return _io and fd.duplicate().use_ring(_io); }
+
+//! \param[in] rearm is `true` to modify the registration even if its events are unchanged, which makes
+//!                  an edge-triggered fd that is still ready be reported again
+void EventLoop::update_registration(const int fd, const bool rearm) {
+    Registration &reg = _registrations.at(fd);
+    uint32_t events = 0;
+    for (const RuleIter &rule : reg.rules) {
+        if (rule->interested) {
+            events |= rule->direction == Direction::In ? EPOLLIN : EPOLLOUT;
+        }
+    }
+    if (_backend == Backend::EpollEdge and events != 0) {
+        events |= EPOLLET;
+    }
+    if (events == reg.events and not rearm) {
+        return;
+    }
+    reg.events = events;
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    // a closed fd has left the epoll set by itself
+    SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_MOD, fd, &event), EBADF);
+}
+
+void EventLoop::cancel_rule(const RuleIter rule) {
+    rule->cancel();
+    _rule_ids.erase(rule->id);
+    if (_io and rule->interested) {
+        rule->interested = false;
+        arm(*rule);
+    }
+    if (_epoll or _io) {
+        if (rule->interest) {
+            _polled_rules.erase(find(_polled_rules.begin(), _polled_rules.end(), rule));
+        } else if (rule->enabled) {
+            _enabled_explicit--;
+        }
+        const auto datagram_rule = find(_datagram_rules.begin(), _datagram_rules.end(), rule);
+        if (datagram_rule != _datagram_rules.end()) {
+            _datagram_rules.erase(datagram_rule);
+        }
+        const int fd = rule->fd.fd_num();
+        Registration &reg = _registrations.at(fd);
+        reg.rules.erase(find(reg.rules.begin(), reg.rules.end(), rule));
+        if (reg.rules.empty()) {
+            if (_epoll and ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_DEL, fd, nullptr) < 0 and errno != EBADF and
+                errno != ENOENT) {
+                throw unix_error("epoll_ctl");
+            }
+            _registrations.erase(fd);
+        } else if (_epoll) {
+            rule->interested = false;
+            update_registration(fd);
+        }
+    }
+    _rules.erase(rule);
 }
 
 //! \param[in] timeout_ms is the timeout value passed to [poll(2)](\ref man2::poll); `wait_next_event`
@@ -59,27 +271,38 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //! will result in a busy loop (poll returns on a ready file descriptor; file descriptor is not read or
 //! written, so it is still ready; the next call to poll will immediately return).
 EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
+    return wait_next_event(timeout_ms < 0 ? chrono::microseconds{-1} : chrono::milliseconds{timeout_ms});
+}
+
+//! \param[in] timeout is the timeout passed to [ppoll(2)](\ref man2::poll) (negative to wait forever)
+//! \returns Eventloop::Result indicating success, timeout, or no more Rule objects to poll.
+EventLoop::Result EventLoop::wait_next_event(const chrono::microseconds timeout) {
+    if (_io) {
+        return wait_uring(timeout);
+    }
+    return _epoll ? wait_epoll(timeout) : wait_poll(timeout);
+}
+
+EventLoop::Result EventLoop::wait_poll(const chrono::microseconds timeout) {
     vector<pollfd> pollfds{};
     pollfds.reserve(_rules.size());
     bool something_to_poll = false;
 
     // set up the pollfd for each rule
-    for (auto it = _rules.cbegin(); it != _rules.cend();) {  // NOTE: it gets erased or incremented in loop body
+    for (auto it = _rules.begin(); it != _rules.end();) {  // NOTE: it gets erased or incremented in loop body
         const auto &this_rule = *it;
         if (this_rule.direction == Direction::In && this_rule.fd.eof()) {
             // no more reading on this rule, it's reached eof
-            this_rule.cancel();
-            it = _rules.erase(it);
+            cancel_rule(it++);
             continue;
         }
 
         if (this_rule.fd.closed()) {
-            this_rule.cancel();
-            it = _rules.erase(it);
+            cancel_rule(it++);
             continue;
         }
 
-        if (this_rule.interest()) {
+        if (wants(this_rule)) {
             pollfds.push_back({this_rule.fd.fd_num(), static_cast<short>(this_rule.direction), 0});
             something_to_poll = true;
         } else {
@@ -95,7 +318,11 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
 
     // call poll -- wait until one of the fds satisfies one of the rules (writeable/readable)
     try {
-        if (0 == SystemCall("poll", ::poll(pollfds.data(), pollfds.size(), timeout_ms))) {
+        timespec ts{};
+        ts.tv_sec = timeout.count() / 1000000;
+        ts.tv_nsec = timeout.count() % 1000000 * 1000;
+        const timespec *const ts_or_forever = timeout.count() < 0 ? nullptr : &ts;
+        if (0 == SystemCall("ppoll", ::ppoll(pollfds.data(), pollfds.size(), ts_or_forever, nullptr))) {
             return Result::Timeout;
         }
     } catch (unix_error const &e) {
@@ -121,8 +348,7 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
             // if we asked for the status, and the _only_ condition was a hangup, this FD is defunct:
             //   - if it was POLLIN and nothing is readable, no more will ever be readable
             //   - if it was POLLOUT, it will not be writable again
-            this_rule.cancel();
-            it = _rules.erase(it);
+            cancel_rule(it++);
             continue;
         }
 
@@ -132,7 +358,7 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
             this_rule.callback();
 
             // only check for busy wait if we're not canceling or exiting
-            if (count_before == this_rule.service_count() and this_rule.interest()) {
+            if (count_before == this_rule.service_count() and wants(this_rule)) {
                 throw runtime_error(
                     "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
             }
@@ -143,3 +369,225 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
 
     return Result::Success;
 }
+
+//! \param[in] timeout is the timeout passed to [epoll_pwait2(2)](\ref man2::epoll_wait) (negative to wait forever)
+//! \returns Eventloop::Result indicating success, timeout, or no more Rule objects to poll.
+//! \details Only the rules with an interest callback are visited before waiting, and only the rules
+//! of ready fds after it; explicit rules change the registrations when they are enabled or disabled.
+EventLoop::Result EventLoop::wait_epoll(const chrono::microseconds timeout) {
+    bool something_to_poll = _enabled_explicit > 0;
+    for (size_t i = 0; i < _polled_rules.size();) {
+        const RuleIter rule = _polled_rules[i];
+        if ((rule->direction == Direction::In and rule->fd.eof()) or rule->fd.closed()) {
+            cancel_rule(rule);  // removes it from _polled_rules
+            continue;
+        }
+        const bool interested = wants(*rule);
+        set_interested(*rule, interested);
+        something_to_poll |= interested;
+        i++;
+    }
+
+    // quit if there is nothing left to poll
+    if (not something_to_poll) {
+        return Result::Exit;
+    }
+
+    int ready = 0;
+    try {
+        if (not _pwait2_unsupported) {
+            timespec ts{};
+            ts.tv_sec = timeout.count() / 1000000;
+            ts.tv_nsec = timeout.count() % 1000000 * 1000;
+            const timespec *const ts_or_forever = timeout.count() < 0 ? nullptr : &ts;
+            ready = epoll_pwait2_if_supported(_epoll->fd_num(), _ready.data(), int(_ready.size()), ts_or_forever);
+            _pwait2_unsupported = ready < 0 and errno == ENOSYS;
+            if (not _pwait2_unsupported) {
+                SystemCall("epoll_pwait2", ready);
+            }
+        }
+        if (_pwait2_unsupported) {
+            // millisecond timeouts only: round up, so a short timeout does not become a busy poll
+            const int64_t timeout_ms = timeout.count() < 0 ? -1 : min((timeout.count() + 999) / 1000, int64_t(INT_MAX));
+            ready = SystemCall("epoll_wait",
+                               ::epoll_wait(_epoll->fd_num(), _ready.data(), int(_ready.size()), int(timeout_ms)));
+        }
+    } catch (unix_error const &e) {
+        if (e.code().value() == EINTR) {
+            return Result::Exit;
+        }
+        throw;
+    }
+    if (ready == 0) {
+        return Result::Timeout;
+    }
+
+    for (int i = 0; i < ready; i++) {
+        const int fd = _ready[i].data.fd;
+        const uint32_t revents = _ready[i].events;
+        if (revents & EPOLLERR) {
+            throw runtime_error("EventLoop: error on polled file descriptor");
+        }
+
+        // callbacks may add or cancel rules of this fd, so the rules are looked up again each time
+        for (size_t j = 0;;) {
+            const auto reg = _registrations.find(fd);
+            if (reg == _registrations.end() or j >= reg->second.rules.size()) {
+                break;
+            }
+            const RuleIter rule = reg->second.rules[j];
+            const bool ready_for_rule = revents & (rule->direction == Direction::In ? EPOLLIN : EPOLLOUT);
+            if (not rule->interested) {
+                j++;
+                continue;
+            }
+            if ((revents & EPOLLHUP) and not ready_for_rule) {
+                // the only condition was a hangup: this FD is defunct (see wait_poll)
+                cancel_rule(rule);
+                continue;
+            }
+            if (not ready_for_rule) {
+                j++;
+                continue;
+            }
+
+            const auto count_before = rule->service_count();
+            rule->callback();
+
+            if ((rule->direction == Direction::In and rule->fd.eof()) or rule->fd.closed()) {
+                cancel_rule(rule);
+                continue;
+            }
+            // an edge-triggered fd is reported once per change, so a callback that did nothing does not spin
+            if (_backend == Backend::Epoll and count_before == rule->service_count() and wants(*rule)) {
+                throw runtime_error(
+                    "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
+            }
+            j++;
+        }
+
+        // a hung-up fd will see no new edge, so it is reported again until its rules reach EOF
+        if (_backend == Backend::EpollEdge and (revents & EPOLLHUP) and _registrations.count(fd)) {
+            update_registration(fd, true);
+        }
+    }
+
+    return Result::Success;
+}
+
+//! \param[in] timeout is the longest to wait for a completion (negative to wait forever)
+//! \returns Eventloop::Result indicating success, timeout, or no more Rule objects to poll.
+//! \details The polls and writes prepared since the last wait are submitted by the same
+//! [io_uring_enter(2)](\ref man2::io_uring_enter) call that waits for completions.
+EventLoop::Result EventLoop::wait_uring(const chrono::microseconds timeout) {
+    bool something_to_poll = _enabled_explicit > 0;
+    for (size_t i = 0; i < _polled_rules.size();) {
+        const RuleIter rule = _polled_rules[i];
+        if ((rule->direction == Direction::In and rule->fd.eof()) or rule->fd.closed()) {
+            cancel_rule(rule);  // removes it from _polled_rules
+            continue;
+        }
+        const bool interested = wants(*rule);
+        set_interested(*rule, interested);
+        something_to_poll |= interested;
+        i++;
+    }
+
+    // quit if there is nothing left to poll, but first hand the kernel any writes still queued (e.g. a final RST)
+    if (not something_to_poll) {
+        _io->ring().enter(0);
+        return Result::Exit;
+    }
+
+    // datagrams that were read but not yet taken are handled without waiting
+    bool datagram_waiting = false;
+    for (const RuleIter &rule : _datagram_rules) {
+        datagram_waiting |= rule->interested and _io->readable(rule->fd.fd_num());
+    }
+
+    IoUring &ring = _io->ring();
+    try {
+        if (datagram_waiting) {
+            ring.enter(0);
+        } else {
+            timespec ts{};
+            ts.tv_sec = timeout.count() / 1000000;
+            ts.tv_nsec = timeout.count() % 1000000 * 1000;
+            ring.enter(1, timeout.count() < 0 ? nullptr : &ts);
+        }
+    } catch (unix_error const &e) {
+        if (e.code().value() == EINTR) {
+            return Result::Exit;
+        }
+        throw;
+    }
+    ring.reap();
+    _io->handle_completions();
+
+    // callbacks may prepare operations that complete (and are reaped) before the next wait
+    _fired.assign(ring.completed().begin(), ring.completed().end());
+    ring.completed().clear();
+
+    bool triggered = false;
+    for (const IoUring::Completion &completion : _fired) {
+        const auto found = _rule_ids.find(completion.user_data >> 8);
+        if (found == _rule_ids.end() or not found->second->interested or
+            poll_tag(*found->second) != completion.user_data) {
+            continue;  // a removed poll, or a poll of a rule that has been canceled or polled again since
+        }
+        const RuleIter rule = found->second;
+        rule->interested = false;  // the poll has fired
+        if (completion.res < 0) {
+            throw unix_error("poll", -completion.res);
+        }
+
+        const auto revents = uint32_t(completion.res);
+        if (revents & (POLLERR | POLLNVAL)) {
+            throw runtime_error("EventLoop: error on polled file descriptor");
+        }
+        const bool ready = revents & (rule->direction == Direction::In ? POLLIN : POLLOUT);
+        if ((revents & POLLHUP) and not ready) {
+            // the only condition was a hangup: this FD is defunct (see wait_poll)
+            cancel_rule(rule);
+            continue;
+        }
+        if (not wants(*rule)) {
+            continue;  // submitted again once the rule is interested
+        }
+
+        const auto count_before = rule->service_count();
+        rule->callback();
+        triggered = true;
+        if ((rule->direction == Direction::In and rule->fd.eof()) or rule->fd.closed()) {
+            cancel_rule(rule);
+            continue;
+        }
+        if (count_before == rule->service_count() and wants(*rule)) {
+            throw runtime_error(
+                "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
+        }
+        set_interested(*rule, wants(*rule));
+    }
+
+    // each datagram waiting for an interested rule runs its callback once
+    for (size_t i = 0; i < _datagram_rules.size();) {
+        const RuleIter rule = _datagram_rules[i];
+        bool canceled = false;
+        while (_io->readable(rule->fd.fd_num()) and wants(*rule)) {
+            const auto count_before = rule->service_count();
+            rule->callback();
+            triggered = true;
+            if (rule->fd.eof() or rule->fd.closed()) {
+                cancel_rule(rule);  // removes it from _datagram_rules
+                canceled = true;
+                break;
+            }
+            if (count_before == rule->service_count()) {
+                throw runtime_error("EventLoop: busy wait detected: callback did not read a datagram it was given");
+            }
+        }
+        i += not canceled;
+    }
+
+    return triggered ? Result::Success : Result::Timeout;
+}
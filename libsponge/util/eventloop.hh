@@ -2,11 +2,19 @@
 #define SPONGE_LIBSPONGE_EVENTLOOP_HH
 
 #include "file_descriptor.hh"
+#include "io_uring.hh"
 
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <list>
+#include <memory>
+#include <optional>
 #include <poll.h>
+#include <sys/epoll.h>
+#include <unordered_map>
+#include <vector>
 
 //! Waits for events on file descriptors and executes corresponding callbacks.
 class EventLoop {
@@ -17,6 +25,24 @@ class EventLoop {
         Out = POLLOUT  //!< Callback will be triggered when Rule::fd is writable.
     };
 
+    //! How the EventLoop waits for its file descriptors
+    enum class Backend {
+        Poll,       //!< [poll(2)](\ref man2::poll) on every rule at each wait: O(rules) per wait
+        Epoll,      //!< level-triggered [epoll(7)](\ref man7::epoll): O(ready fds) per wait
+        EpollEdge,  //!< edge-triggered epoll: callbacks must read or write until the fd would block
+        IoUring     //!< [io_uring(7)](\ref man7::io_uring), or Epoll where it is unavailable: see attach_to_ring()
+    };
+
+    //! Identifies a rule, to enable or disable it later
+    using RuleId = uint64_t;
+
+    //! Returned by each call to EventLoop::wait_next_event.
+    enum class Result {
+        Success,  //!< At least one Rule was triggered.
+        Timeout,  //!< No rules were triggered before timeout.
+        Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
+    };
+
   private:
     using CallbackT = std::function<void(void)>;  //!< Callback for ready Rule::fd
     using InterestT = std::function<bool(void)>;  //!< `true` return indicates Rule::fd should be polled.
@@ -28,33 +54,116 @@ class EventLoop {
         FileDescriptor fd;    //!< FileDescriptor to monitor for activity.
         Direction direction;  //!< Direction::In for reading from fd, Direction::Out for writing to fd.
         CallbackT callback;   //!< A callback that reads or writes fd.
-        InterestT interest;   //!< A callback that returns `true` whenever fd should be polled.
+        InterestT interest;   //!< A callback that returns `true` whenever fd should be polled (empty for explicit rules).
         CallbackT cancel;     //!< A callback that is called when the rule is cancelled (e.g. on hangup)
+        RuleId id;            //!< Identifies the rule to enable() and disable()
+        bool enabled;         //!< Set by enable() and disable(); a disabled rule is never polled
+        bool interested;      //!< Whether fd was last registered for Rule::direction on behalf of this rule
+        uint8_t generation;   //!< Counts the polls submitted for this rule (io_uring), to tell a stale one
 
         //! Returns the number of times fd has been read or written, depending on the value of Rule::direction.
         //! \details This function is used internally by EventLoop; you will not need to call it
         unsigned int service_count() const;
     };
 
+    using RuleIter = std::list<Rule>::iterator;
+
+    Backend _backend;
     std::list<Rule> _rules{};  //!< All rules that have been added and not canceled.
+    std::unordered_map<RuleId, RuleIter> _rule_ids{};
+    RuleId _next_id{1};
 
-  public:
-    //! Returned by each call to EventLoop::wait_next_event.
-    enum class Result {
-        Success,  //!< At least one Rule was triggered.
-        Timeout,  //!< No rules were triggered before timeout.
-        Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
+    //! \name epoll and io_uring backends
+    //! Each fd is registered once, for the union of the directions its rules are interested in.
+    //! Explicit rules change the registration only when they are enabled or disabled; rules with
+    //! an interest callback are asked before each wait, as with poll.
+    //!@{
+    struct Registration {
+        std::vector<RuleIter> rules{};  //!< the rules watching the fd
+        uint32_t events{0};             //!< the events the fd is registered for (epoll)
     };
+    std::unordered_map<int, Registration> _registrations{};
+    std::vector<RuleIter> _polled_rules{};  //!< rules with an interest callback
+    size_t _enabled_explicit{0};            //!< explicit rules that are enabled
+    //!@}
+
+    //! \name epoll backends
+    //!@{
+    std::optional<FileDescriptor> _epoll{};
+    std::vector<epoll_event> _ready{};
+    bool _pwait2_unsupported{false};  //!< epoll_pwait2 failed with ENOSYS, so waits use epoll_wait
+
+    //! \brief Register `fd` for what its rules are now interested in
+    void update_registration(int fd, bool rearm = false);
+    //!@}
+
+    //! \name io_uring backend
+    //! Rules are polled with one-shot IORING_OP_POLL_ADD operations, submitted again after each
+    //! callback while the rule is still interested (which makes them level-triggered). The rules
+    //! reading fds attached to the ring take the datagrams that its reads have completed instead.
+    //!@{
+    std::shared_ptr<IoUringDatagrams> _io{};
+    std::vector<RuleIter> _datagram_rules{};    //!< Direction::In rules of fds attached to the ring
+    std::vector<IoUring::Completion> _fired{};  //!< poll completions being dispatched
+
+    //! \brief Submit or remove a rule's poll (or start its fd's reads) as Rule::interested says
+    void arm(Rule &rule);
+    uint64_t poll_tag(const Rule &rule) const { return rule.id << 8 | rule.generation; }
+    bool is_datagram_rule(const Rule &rule) const {
+        return rule.direction == Direction::In and _io and rule.fd.ring() == _io.get();
+    }
+    //!@}
+
+    //! \brief Whether a rule is interested in its fd, according to its interest callback
+    bool wants(const Rule &rule) const { return rule.enabled and (not rule.interest or rule.interest()); }
+    //! \brief Set what a rule is interested in, and update its fd's registration if that changed
+    void set_interested(Rule &rule, bool interested);
+    //! \brief Call the rule's cancel callback and forget the rule
+    void cancel_rule(RuleIter rule);
+
+    Result wait_poll(std::chrono::microseconds timeout);
+    Result wait_epoll(std::chrono::microseconds timeout);
+    Result wait_uring(std::chrono::microseconds timeout);
+
+  public:
+    //! \param[in] backend how to wait for the file descriptors
+    explicit EventLoop(const Backend backend = Backend::Poll);
 
     //! Add a rule whose callback will be called when `fd` is ready in the specified Direction.
-    void add_rule(const FileDescriptor &fd,
-                  const Direction direction,
-                  const CallbackT &callback,
-                  const InterestT &interest = [] { return true; },
-                  const CallbackT &cancel = [] {});
+    RuleId add_rule(const FileDescriptor &fd,
+                    const Direction direction,
+                    const CallbackT &callback,
+                    const InterestT &interest = [] { return true; },
+                    const CallbackT &cancel = [] {});
+
+    //! Add a rule that is interested in `fd` whenever it is enabled, rather than whenever an
+    //! interest callback says so. Under an epoll backend, such a rule costs nothing while it waits.
+    RuleId add_explicit_rule(const FileDescriptor &fd,
+                             const Direction direction,
+                             const CallbackT &callback,
+                             const CallbackT &cancel = [] {});
+
+    //! \name Switch a rule on or off (rules start enabled); no effect if the rule was canceled
+    //!@{
+    void enable(const RuleId id);
+    void disable(const RuleId id);
+    //!@}
+
+    //! The backend the EventLoop waits with (Backend::Epoll if Backend::IoUring was asked for but is unavailable)
+    Backend backend() const { return _backend; }
 
-    //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
+    //! \brief With Backend::IoUring, read and write `fd`'s datagrams through the ring (see IoUringDatagrams)
+    //! \details Attach an fd before adding its rules. Its Direction::In rules then run once for each
+    //! datagram the ring has read, and its writes are submitted together at the next wait.
+    //! \returns `false` if the backend is not Backend::IoUring, or the ring has no room for `fd`
+    bool attach_to_ring(const FileDescriptor &fd);
+
+    //! Waits for ready fds (with [poll(2)](\ref man2::poll) or [epoll(7)](\ref man7::epoll)) and then executes
+    //! callback for each ready fd.
     Result wait_next_event(const int timeout_ms);
+
+    //! Like wait_next_event(int), but with a timeout of microsecond resolution (negative to wait forever).
+    Result wait_next_event(const std::chrono::microseconds timeout);
 };
 
 using Direction = EventLoop::Direction;
@@ -69,6 +178,17 @@ using Direction = EventLoop::Direction;
 //! (for Rule::direction == Direction::In) or writable (for Rule::direction == Direction::Out).
 //! Once this occurs, the Rule is canceled, i.e., the EventLoop deletes it.
 //!
+//! With Backend::Epoll or Backend::EpollEdge, the fds stay registered with the kernel between
+//! waits, and a wait costs time in proportion to the number of ready fds, plus the number of
+//! rules that have an interest callback. A Rule installed using EventLoop::add_explicit_rule has
+//! none: it is interested while it is enabled, and EventLoop::enable and EventLoop::disable change
+//! its registration. With Backend::EpollEdge, an fd is reported only when it becomes ready, so its
+//! callbacks must read (or write) until the fd would block; a hung-up fd is reported at each wait
+//! until its rules are canceled. The kernel drops a closed fd from the epoll set without telling
+//! anyone, so an explicit rule whose fd is closed elsewhere is canceled only when it is enabled
+//! again or its fd number is reused by a new rule; until then it still counts as interested for
+//! the purposes of Result::Exit. Disable such a rule before closing its fd.
+//!
 //! A Rule installed using EventLoop::add_cancelable_rule will be polled and canceled under the
 //! same conditions, with the additional condition that if Rule::callback returns `true`, the
 //! Rule will be canceled.
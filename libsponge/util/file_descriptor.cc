@@ -1,5 +1,6 @@
 #include "file_descriptor.hh"
 
+#include "io_uring.hh"
 #include "util.hh"
 
 #include <algorithm>
@@ -19,6 +20,9 @@ FileDescriptor::FDWrapper::FDWrapper(const int fd) : _fd(fd) {
 }
 
 void FileDescriptor::FDWrapper::close() {
+    if (_ring) {
+        _ring->detach(_fd);
+    }
     SystemCall("close", ::close(_fd));
     _eof = _closed = true;
 }
@@ -48,6 +52,14 @@ FileDescriptor FileDescriptor::duplicate() const { return FileDescriptor(_intern
 //! \param[out] str is the string to be read
 void FileDescriptor::read(std::string &str, const size_t limit) {
     constexpr size_t BUFFER_SIZE = 1024 * 1024;  // maximum size of a read
+    if (ring() != nullptr and ring()->take(fd_num(), str, limit, nullptr, nullptr) >= 0) {
+        if (limit > 0 and str.empty()) {
+            _internal_fd->_eof = true;
+        }
+        register_read();
+        return;
+    }
+
     const size_t size_to_read = min(BUFFER_SIZE, limit);
     str.resize(size_to_read);
 
@@ -73,7 +85,50 @@ string FileDescriptor::read(const size_t limit) {
     return ret;
 }
 
+//! \param[in] buffers are where to put the bytes read, in order
+//! \param[in] count is the number of buffers
+//! \returns the number of bytes read (zero at EOF)
+size_t FileDescriptor::read_into(const iovec *buffers, const size_t count) {
+    size_t capacity = 0;
+    for (size_t i = 0; i < count; i++) {
+        capacity += buffers[i].iov_len;
+    }
+
+    ssize_t bytes_read = ring() == nullptr ? -1 : ring()->take(fd_num(), buffers, count, nullptr, nullptr);
+    if (bytes_read < 0) {
+        bytes_read = SystemCall("readv", ::readv(fd_num(), buffers, int(count)));
+    }
+    bytes_read = min(bytes_read, ssize_t(capacity));
+    if (capacity > 0 and bytes_read == 0) {
+        _internal_fd->_eof = true;
+    }
+
+    register_read();
+    return bytes_read;
+}
+
+//! \param[out] buffer is where to put the bytes read
+//! \param[in] capacity is the size of `buffer`; fewer bytes may be read
+//! \returns the number of bytes read (zero at EOF)
+size_t FileDescriptor::read(char *buffer, const size_t capacity) {
+    const iovec only{buffer, capacity};
+    return read_into(&only, 1);
+}
+
+//! \param[in] pool provides the storage, which is reused once the Buffers made from it are gone
+//! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
+//! \returns a Buffer holding the bytes read (empty at EOF)
+Buffer FileDescriptor::read(BufferPool &pool, const size_t limit) {
+    const size_t capacity = min(limit, pool.slab_size());
+    return pool.make_up_to(capacity, [&](char *dst) { return read(dst, capacity); });
+}
+
 size_t FileDescriptor::write(BufferViewList buffer, const bool write_all) {
+    if (ring() != nullptr and ring()->write(fd_num(), buffer, nullptr, 0)) {
+        register_write();
+        return buffer.size();
+    }
+
     size_t total_bytes_written = 0;
 
     do {
@@ -108,3 +163,12 @@ void FileDescriptor::set_blocking(const bool blocking_state) {
 
     SystemCall("fcntl", fcntl(fd_num(), F_SETFL, flags));
 }
+
+//! \param[in] ring is the ring that will read and write the descriptor
+bool FileDescriptor::use_ring(const shared_ptr<IoUringDatagrams> &ring) {
+    if (not ring->attach(fd_num())) {
+        return false;
+    }
+    _internal_fd->_ring = ring;
+    return true;
+}
@@ -7,6 +7,10 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <sys/uio.h>
+#include <vector>
+
+class IoUringDatagrams;
 
 //! A reference-counted handle to a file descriptor
 class FileDescriptor {
@@ -14,11 +18,12 @@ class FileDescriptor {
     //! \details FileDescriptor objects contain a std::shared_ptr to a FDWrapper.
     class FDWrapper {
       public:
-        int _fd;                    //!< The file descriptor number returned by the kernel
-        bool _eof = false;          //!< Flag indicating whether FDWrapper::_fd is at EOF
-        bool _closed = false;       //!< Flag indicating whether FDWrapper::_fd has been closed
-        unsigned _read_count = 0;   //!< The number of times FDWrapper::_fd has been read
-        unsigned _write_count = 0;  //!< The numberof times FDWrapper::_fd has been written
+        int _fd;                                    //!< The file descriptor number returned by the kernel
+        bool _eof = false;                          //!< Flag indicating whether FDWrapper::_fd is at EOF
+        bool _closed = false;                       //!< Flag indicating whether FDWrapper::_fd has been closed
+        unsigned _read_count = 0;                   //!< The number of times FDWrapper::_fd has been read
+        unsigned _write_count = 0;                  //!< The numberof times FDWrapper::_fd has been written
+        std::shared_ptr<IoUringDatagrams> _ring{};  //!< Reads and writes FDWrapper::_fd, if set
 
         //! Construct from a file descriptor number returned by the kernel
         explicit FDWrapper(const int fd);
@@ -44,6 +49,9 @@ class FileDescriptor {
     // private constructor used to duplicate the FileDescriptor (increase the reference count)
     explicit FileDescriptor(std::shared_ptr<FDWrapper> other_shared_ptr);
 
+    //! Read into `count` caller-owned `buffers` with [readv(2)](\ref man2::readv)
+    size_t read_into(const iovec *buffers, const size_t count);
+
   protected:
     void register_read() { ++_internal_fd->_read_count; }    //!< increment read count
     void register_write() { ++_internal_fd->_write_count; }  //!< increment write count
@@ -61,6 +69,15 @@ class FileDescriptor {
     //! Read up to `limit` bytes into `str` (caller can allocate storage)
     void read(std::string &str, const size_t limit = std::numeric_limits<size_t>::max());
 
+    //! Read up to `capacity` bytes into caller-owned storage (which is not cleared first)
+    size_t read(char *buffer, const size_t capacity);
+
+    //! Read into caller-owned `buffers`, filling each before the next
+    size_t readv(const std::vector<iovec> &buffers) { return read_into(buffers.data(), buffers.size()); }
+
+    //! Read up to `limit` bytes (and at most one slab's worth) into a Buffer carved out of `pool`
+    Buffer read(BufferPool &pool, const size_t limit = std::numeric_limits<size_t>::max());
+
     //! Write a string, possibly blocking until all is written
     size_t write(const char *str, const bool write_all = true) { return write(BufferViewList(str), write_all); }
 
@@ -79,6 +96,10 @@ class FileDescriptor {
     //! Set blocking(true) or non-blocking(false)
     void set_blocking(const bool blocking_state);
 
+    //! \brief Read and write datagrams through `ring` from now on (see IoUringDatagrams)
+    //! \returns `false` if the ring has no room for another file descriptor
+    bool use_ring(const std::shared_ptr<IoUringDatagrams> &ring);
+
     //! \name FDWrapper accessors
     //!@{
 
@@ -96,6 +117,9 @@ class FileDescriptor {
 
     //! number of writes
     unsigned int write_count() const { return _internal_fd->_write_count; }
+
+    //! the ring that reads and writes the descriptor, if any
+    IoUringDatagrams *ring() const { return _internal_fd->_ring.get(); }
     //!@}
 
     //! \name Copy/move constructor/assignment operators
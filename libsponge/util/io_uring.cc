@@ -0,0 +1,411 @@
+#include "io_uring.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+//! Calls [io_uring_setup(2)](\ref man2::io_uring_setup); glibc has no wrapper
+static int io_uring_setup(const unsigned entries, io_uring_params *params) {
+    return int(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+//! \param[in] entries is the size of the submission queue (the completion queue is twice as big)
+IoUring::IoUring(const unsigned entries) : _fd(SystemCall("io_uring_setup", io_uring_setup(entries, &_params))) {
+    const unsigned needed = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((_params.features & needed) != needed) {
+        throw runtime_error("io_uring: kernel lacks the features used by IoUring");
+    }
+
+    const size_t sq_size = _params.sq_off.array + _params.sq_entries * sizeof(unsigned);
+    const size_t cq_size = _params.cq_off.cqes + _params.cq_entries * sizeof(io_uring_cqe);
+    _ring_size = max(sq_size, cq_size);
+    _ring = ::mmap(
+        nullptr, _ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd.fd_num(), IORING_OFF_SQ_RING);
+    if (_ring == MAP_FAILED) {
+        _ring = nullptr;
+        throw unix_error("mmap");
+    }
+    _sqes_size = _params.sq_entries * sizeof(io_uring_sqe);
+    void *const sqes =
+        ::mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd.fd_num(), IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        const int error = errno;
+        ::munmap(_ring, _ring_size);
+        throw unix_error("mmap", error);
+    }
+    _sqes = static_cast<io_uring_sqe *>(sqes);
+
+    char *const ring = static_cast<char *>(_ring);
+    _sq_head = reinterpret_cast<unsigned *>(ring + _params.sq_off.head);
+    _sq_tail = reinterpret_cast<unsigned *>(ring + _params.sq_off.tail);
+    _sq_array = reinterpret_cast<unsigned *>(ring + _params.sq_off.array);
+    _cq_head = reinterpret_cast<unsigned *>(ring + _params.cq_off.head);
+    _cq_tail = reinterpret_cast<unsigned *>(ring + _params.cq_off.tail);
+    _cqes = reinterpret_cast<io_uring_cqe *>(ring + _params.cq_off.cqes);
+    _completed.reserve(_params.cq_entries);
+}
+
+IoUring::~IoUring() {
+    ::munmap(_sqes, _sqes_size);
+    ::munmap(_ring, _ring_size);
+}
+
+bool IoUring::available() {
+    static const bool result = [] {
+        try {
+            const IoUring probe{4};
+            return true;
+        } catch (const exception &) {
+            return false;
+        }
+    }();
+    return result;
+}
+
+io_uring_sqe &IoUring::next_sqe(const uint8_t opcode, const int fd, const uint64_t user_data) {
+    unsigned tail = *_sq_tail;
+    if (tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) == _params.sq_entries) {
+        enter(0);
+        tail = *_sq_tail;
+    }
+    const unsigned index = tail & (_params.sq_entries - 1);
+    io_uring_sqe &sqe = _sqes[index];
+    sqe = {};
+    sqe.opcode = opcode;
+    sqe.fd = fd;
+    sqe.user_data = user_data;
+    _sq_array[index] = index;
+    // the kernel reads the entry only after it sees the new tail
+    __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+    _unsubmitted++;
+    return sqe;
+}
+
+//! \param[in] events are the [poll(2)](\ref man2::poll) events to wait for; the operation completes once
+void IoUring::prepare_poll(const int fd, const uint32_t events, const uint64_t user_data) {
+    next_sqe(IORING_OP_POLL_ADD, fd, user_data).poll32_events = events;
+}
+
+//! \param[in] target is the `user_data` of the poll to remove
+void IoUring::prepare_poll_remove(const uint64_t target, const uint64_t user_data) {
+    next_sqe(IORING_OP_POLL_REMOVE, -1, user_data).addr = target;
+}
+
+//! \param[in] target is the `user_data` of the operation to cancel
+void IoUring::prepare_cancel(const uint64_t target, const uint64_t user_data) {
+    next_sqe(IORING_OP_ASYNC_CANCEL, -1, user_data).addr = target;
+}
+
+bool IoUring::register_buffers(const vector<iovec> &buffers) {
+    return ::syscall(__NR_io_uring_register, _fd.fd_num(), IORING_REGISTER_BUFFERS, buffers.data(), buffers.size()) ==
+           0;
+}
+
+void IoUring::enter(const unsigned wait_nr, const timespec *timeout) {
+    __kernel_timespec ts{};
+    io_uring_getevents_arg arg{};
+    unsigned flags = 0;
+    if (wait_nr > 0) {
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        arg.sigmask_sz = _NSIG / 8;
+        if (timeout != nullptr) {
+            ts.tv_sec = timeout->tv_sec;
+            ts.tv_nsec = timeout->tv_nsec;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+        }
+    } else if (_unsubmitted == 0) {
+        return;
+    }
+
+    _enter_calls++;
+    const long ret =
+        ::syscall(__NR_io_uring_enter, _fd.fd_num(), _unsubmitted, wait_nr, flags, flags ? &arg : nullptr, sizeof(arg));
+    if (ret < 0) {
+        if (errno == ETIME) {
+            return;  // the timeout expired, with nothing to submit
+        }
+        throw unix_error("io_uring_enter");
+    }
+    _unsubmitted -= min(unsigned(ret), _unsubmitted);
+}
+
+void IoUring::reap() {
+    unsigned head = *_cq_head;
+    const unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        const io_uring_cqe &cqe = _cqes[head & (_params.cq_entries - 1)];
+        _completed.push_back({cqe.user_data, cqe.res, cqe.flags});
+    }
+    __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+}
+
+IoUringDatagrams::IoUringDatagrams()
+    : _ring(), _storage(new char[(MAX_ATTACHED * READS_PER_FD + WRITE_SLOTS) * SLOT_SIZE]) {
+    const size_t count = MAX_ATTACHED * READS_PER_FD + WRITE_SLOTS;
+    vector<iovec> buffers;
+    _slots.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        char *const data = _storage.get() + i * SLOT_SIZE;
+        _slots.push_back({data});
+        _free.push_back(count - 1 - i);
+        buffers.push_back({data, SLOT_SIZE});
+    }
+    _registered = _ring.register_buffers(buffers);
+}
+
+//! \details A datagram written just before its EventLoop exits (such as the RST sent by an abort) is still
+//! only queued; it is submitted here, and its slot kept alive until the kernel is done with it.
+IoUringDatagrams::~IoUringDatagrams() {
+    try {
+        _ring.enter(0);
+        const auto writing = [&] {
+            return any_of(_slots.begin(), _slots.end(), [](const Slot &s) { return s.state == Slot::State::Writing; });
+        };
+        // writes to sockets complete at once; don't hang on one that can't (e.g. to a full pipe)
+        const timespec timeout{0, 100'000'000};
+        for (size_t i = 0; i < 10 and writing(); i++) {
+            _ring.enter(1, &timeout);
+            _ring.reap();
+            handle_completions();
+        }
+    } catch (const exception &e) {
+        cerr << "Exception submitting the last io_uring writes: " << e.what() << endl;
+    }
+}
+
+//! \param[in] slot is a slot of an attached file descriptor
+//! \param[in] wait_for_data is `true` to submit a poll linked to the read, for file descriptors that
+//!                          are in non-blocking mode (whose reads fail with EAGAIN rather than wait)
+void IoUringDatagrams::submit_read(const size_t slot, const bool wait_for_data) {
+    Slot &s = _slots.at(slot);
+    const Reader &reader = _readers.at(s.fd);
+    s.state = Slot::State::Reading;
+    if (wait_for_data) {
+        // the read starts once the poll completes
+        io_uring_sqe &poll = _ring.next_sqe(IORING_OP_POLL_ADD, s.fd, tag(Op::Poll, slot));
+        poll.poll32_events = POLLIN;
+        poll.flags = IOSQE_IO_LINK;
+    }
+    io_uring_sqe *sqe = nullptr;
+    if (reader.socket) {
+        s.iov = {s.data, SLOT_SIZE};
+        s.msg = {};
+        s.msg.msg_name = &s.address;
+        s.msg.msg_namelen = sizeof(s.address);
+        s.msg.msg_iov = &s.iov;
+        s.msg.msg_iovlen = 1;
+        sqe = &_ring.next_sqe(IORING_OP_RECVMSG, s.fd, tag(Op::Read, slot));
+        sqe->addr = reinterpret_cast<uint64_t>(&s.msg);
+        sqe->len = 1;
+        sqe->msg_flags = MSG_TRUNC;
+    } else {
+        sqe = &_ring.next_sqe(_registered ? IORING_OP_READ_FIXED : IORING_OP_READ, s.fd, tag(Op::Read, slot));
+        sqe->addr = reinterpret_cast<uint64_t>(s.data);
+        sqe->len = SLOT_SIZE;
+        sqe->buf_index = uint16_t(slot);
+        sqe->off = uint64_t(-1);  // at the file's position, as read(2) does
+    }
+}
+
+bool IoUringDatagrams::attach(const int fd) {
+    if (_readers.count(fd)) {
+        return true;
+    }
+    if (_readers.size() == MAX_ATTACHED or _free.size() < READS_PER_FD) {
+        return false;
+    }
+    struct stat st {};
+    SystemCall("fstat", ::fstat(fd, &st));
+    Reader &reader = _readers[fd];
+    reader.socket = S_ISSOCK(st.st_mode);
+    // read slots come from the bottom of the free list, leaving the rest for writes
+    for (size_t i = 0; i < READS_PER_FD; i++) {
+        const size_t slot = _free.back();
+        _free.pop_back();
+        _slots[slot].fd = fd;
+        reader.slots.push_back(slot);
+    }
+    return true;
+}
+
+void IoUringDatagrams::detach(const int fd) {
+    const auto found = _readers.find(fd);
+    if (found == _readers.end()) {
+        return;
+    }
+    for (const size_t slot : found->second.slots) {
+        Slot &s = _slots[slot];
+        s.fd = -1;
+        if (s.state == Slot::State::Reading) {
+            // freed when the cancelled read completes
+            _ring.prepare_cancel(tag(Op::Read, slot), tag(Op::Cancel, slot));
+        } else {
+            s.state = Slot::State::Free;
+            _free.push_back(slot);
+        }
+    }
+    _readers.erase(found);
+    _ring.enter(0);
+}
+
+void IoUringDatagrams::start_reads(const int fd) {
+    for (const size_t slot : _readers.at(fd).slots) {
+        if (_slots[slot].state == Slot::State::Free) {
+            submit_read(slot, false);
+        }
+    }
+}
+
+bool IoUringDatagrams::readable(const int fd) const {
+    const auto found = _readers.find(fd);
+    return found != _readers.end() and not found->second.ready.empty();
+}
+
+//! \param[in] copy is called with the datagram (unless the read failed), to copy out what it needs
+template <typename Copy>
+ssize_t IoUringDatagrams::take_with(const int fd, Copy &&copy, sockaddr *address, socklen_t *address_len) {
+    const auto found = _readers.find(fd);
+    if (found == _readers.end() or found->second.ready.empty()) {
+        return -1;
+    }
+    Reader &reader = found->second;
+    const size_t slot = reader.ready.front();
+    reader.ready.pop_front();
+    Slot &s = _slots[slot];
+    const int32_t result = s.result;
+    if (result >= 0) {
+        copy(s.data, min(size_t(result), SLOT_SIZE));
+        if (address != nullptr and reader.socket) {
+            *address_len = min(*address_len, s.msg.msg_namelen);
+            memcpy(address, &s.address, *address_len);
+        }
+    }
+    // the slot reads the next datagram while this one is handled
+    submit_read(slot, false);
+    if (result < 0) {
+        throw unix_error(reader.socket ? "recvmsg" : "read", -result);
+    }
+    return result;
+}
+
+ssize_t IoUringDatagrams::take(
+    const int fd, string &str, const size_t limit, sockaddr *address, socklen_t *address_len) {
+    return take_with(
+        fd, [&](const char *data, const size_t len) { str.assign(data, min(len, limit)); }, address, address_len);
+}
+
+ssize_t IoUringDatagrams::take(
+    const int fd, const iovec *buffers, const size_t count, sockaddr *address, socklen_t *address_len) {
+    const auto scatter = [&](const char *data, size_t len) {
+        for (size_t i = 0; i < count and len > 0; i++) {
+            const size_t n = min(len, buffers[i].iov_len);
+            memcpy(buffers[i].iov_base, data, n);
+            data += n;
+            len -= n;
+        }
+    };
+    return take_with(fd, scatter, address, address_len);
+}
+
+bool IoUringDatagrams::write(const int fd,
+                             const BufferViewList &payload,
+                             const sockaddr *address,
+                             const socklen_t address_len) {
+    const size_t size = payload.size();
+    if (size > SLOT_SIZE or address_len > sizeof(sockaddr_storage)) {
+        return false;
+    }
+    while (_free.empty()) {
+        _ring.enter(1);
+        _ring.reap();
+        handle_completions();
+    }
+    const size_t slot = _free.back();
+    _free.pop_back();
+    Slot &s = _slots[slot];
+    s.state = Slot::State::Writing;
+    s.fd = fd;
+    char *next = s.data;
+    for (const auto &piece : payload.as_iovecs()) {
+        memcpy(next, piece.iov_base, piece.iov_len);
+        next += piece.iov_len;
+    }
+
+    if (address != nullptr) {
+        memcpy(&s.address, address, address_len);
+        s.iov = {s.data, size};
+        s.msg = {};
+        s.msg.msg_name = &s.address;
+        s.msg.msg_namelen = address_len;
+        s.msg.msg_iov = &s.iov;
+        s.msg.msg_iovlen = 1;
+        io_uring_sqe &sqe = _ring.next_sqe(IORING_OP_SENDMSG, fd, tag(Op::Write, slot));
+        sqe.addr = reinterpret_cast<uint64_t>(&s.msg);
+        sqe.len = 1;
+    } else {
+        const uint8_t opcode = _registered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        io_uring_sqe &sqe = _ring.next_sqe(opcode, fd, tag(Op::Write, slot));
+        sqe.addr = reinterpret_cast<uint64_t>(s.data);
+        sqe.len = uint32_t(size);
+        sqe.buf_index = uint16_t(slot);
+        sqe.off = uint64_t(-1);
+    }
+    return true;
+}
+
+void IoUringDatagrams::complete(const IoUring::Completion &completion) {
+    const auto op = Op(completion.user_data >> 32 & 0x7fffffff);
+    const size_t slot = completion.user_data & 0xffffffff;
+    Slot &s = _slots.at(slot);
+    switch (op) {
+        case Op::Poll:
+        case Op::Cancel:
+            return;  // the linked read, or the cancelled one, completes separately
+        case Op::Write:
+            s.state = Slot::State::Free;
+            s.fd = -1;
+            _free.push_back(slot);
+            return;
+        case Op::Read:
+            break;
+    }
+
+    if (s.fd < 0) {
+        // the file descriptor was detached while the read was outstanding
+        s.state = Slot::State::Free;
+        _free.push_back(slot);
+        return;
+    }
+    if (completion.res == -EAGAIN or completion.res == -ECANCELED) {
+        // a non-blocking fd had nothing to read (or the linked poll was cut short): wait for data first
+        submit_read(slot, true);
+        return;
+    }
+    s.state = Slot::State::Read;
+    s.result = completion.res;
+    _readers.at(s.fd).ready.push_back(slot);
+}
+
+void IoUringDatagrams::handle_completions() {
+    auto &completed = _ring.completed();
+    const auto end = remove_if(completed.begin(), completed.end(), [&](const IoUring::Completion &completion) {
+        if (not owns(completion.user_data)) {
+            return false;
+        }
+        complete(completion);
+        return true;
+    });
+    completed.erase(end, completed.end());
+}
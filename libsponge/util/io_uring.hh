@@ -0,0 +1,205 @@
+#ifndef SPONGE_LIBSPONGE_IO_URING_HH
+#define SPONGE_LIBSPONGE_IO_URING_HH
+
+#include "buffer.hh"
+#include "file_descriptor.hh"
+#include "ring_queue.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <linux/io_uring.h>
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unordered_map>
+#include <vector>
+
+//! \brief A submission and completion queue pair shared with the kernel ([io_uring(7)](\ref man7::io_uring))
+//! \details Operations are written into the submission queue with the prepare_* functions and handed to
+//! the kernel in one [io_uring_enter(2)](\ref man2::io_uring_enter) call, which can also wait for their
+//! completions. The ring is set up with raw system calls, so it needs no library; it throws
+//! if the kernel does not support io_uring, or lacks the features used here (Linux 5.11 or later).
+class IoUring {
+  public:
+    //! A completed operation, copied out of the completion queue
+    struct Completion {
+        uint64_t user_data;  //!< the `user_data` of the operation's submission
+        int32_t res;         //!< its result: what the equivalent system call returns, or -errno
+        uint32_t flags;      //!< IORING_CQE_F_* flags
+    };
+
+  private:
+    io_uring_params _params{};  //!< filled in by io_uring_setup, so initialized before _fd
+    FileDescriptor _fd;
+    size_t _ring_size{0};
+    void *_ring{nullptr};  //!< the submission and completion rings (one mapping)
+    size_t _sqes_size{0};
+    io_uring_sqe *_sqes{nullptr};
+
+    unsigned *_sq_head{nullptr};
+    unsigned *_sq_tail{nullptr};
+    unsigned *_sq_array{nullptr};
+    unsigned *_cq_head{nullptr};
+    unsigned *_cq_tail{nullptr};
+    io_uring_cqe *_cqes{nullptr};
+
+    unsigned _unsubmitted{0};              //!< prepared operations not yet handed to the kernel
+    std::vector<Completion> _completed{};  //!< completions reaped and not yet handled
+    uint64_t _enter_calls{0};
+
+  public:
+    //! \param[in] entries is the size of the submission queue (the completion queue is twice as big)
+    explicit IoUring(const unsigned entries = 256);
+    ~IoUring();
+
+    //! Whether io_uring can be used on this system (checked once, by setting up a small ring)
+    static bool available();
+
+    //! \brief A cleared submission queue entry, to be handed to the kernel by the next enter()
+    //! \note If the submission queue is full, its entries are submitted first
+    io_uring_sqe &next_sqe(const uint8_t opcode, const int fd, const uint64_t user_data);
+
+    //! \name Prepare common operations
+    //!@{
+    void prepare_poll(const int fd, const uint32_t events, const uint64_t user_data);
+    void prepare_poll_remove(const uint64_t target, const uint64_t user_data);
+    void prepare_cancel(const uint64_t target, const uint64_t user_data);
+    //!@}
+
+    //! \brief Register `buffers` for IORING_OP_READ_FIXED and IORING_OP_WRITE_FIXED
+    //! \returns `false` if the kernel refused (e.g. for lack of locked memory)
+    bool register_buffers(const std::vector<iovec> &buffers);
+
+    //! \brief Submit the prepared operations and wait for `wait_nr` completions, or until `timeout`
+    //! \param[in] timeout is how long to wait, or `nullptr` to wait as long as it takes
+    //! \throws unix_error on failure, including EINTR
+    void enter(const unsigned wait_nr, const timespec *timeout = nullptr);
+
+    //! Move the completion queue's entries to completed()
+    void reap();
+
+    //! Completions reaped and not yet handled; handlers erase what they handle
+    std::vector<Completion> &completed() { return _completed; }
+
+    //! The number of [io_uring_enter(2)](\ref man2::io_uring_enter) calls made so far
+    uint64_t enter_calls() const { return _enter_calls; }
+
+    //! \name
+    //! An IoUring cannot be copied or moved
+
+    //!@{
+    IoUring(const IoUring &other) = delete;
+    IoUring &operator=(const IoUring &other) = delete;
+    IoUring(IoUring &&other) = delete;
+    IoUring &operator=(IoUring &&other) = delete;
+    //!@}
+};
+
+//! \brief Datagram reads and writes through an IoUring, into preallocated slots
+//! \details A file descriptor that is attached keeps READS_PER_FD reads outstanding, each into a slot of
+//! its own. A completed read waits in its slot until FileDescriptor::read (or UDPSocket::recv) takes
+//! it, which copies the datagram out and submits the next read into the same slot. Writes are copied
+//! into a free slot and submitted with the next IoUring::enter, so all the datagrams written between two
+//! waits of an EventLoop go out in one system call. Slots are registered with the kernel when possible,
+//! so reads and writes on file descriptors other than sockets use IORING_OP_READ_FIXED and
+//! IORING_OP_WRITE_FIXED; sockets use IORING_OP_RECVMSG and IORING_OP_SENDMSG, which carry the
+//! datagram's address.
+//!
+//! As with a datagram socket whose buffer is full, a write that fails is dropped without an error.
+class IoUringDatagrams {
+  public:
+    static constexpr size_t SLOT_SIZE = 65536;   //!< largest datagram read or written through the ring
+    static constexpr size_t READS_PER_FD = 8;    //!< reads outstanding on each attached file descriptor
+    static constexpr size_t MAX_ATTACHED = 4;    //!< file descriptors that can be attached at once
+    static constexpr size_t WRITE_SLOTS = 64;    //!< writes in flight at once
+    static constexpr uint64_t TAG = 1ull << 63;  //!< set in the `user_data` of this class's operations
+
+  private:
+    //! One datagram's worth of buffer, and the state of the operation using it
+    struct Slot {
+        enum class State { Free, Reading, Read, Writing };
+
+        char *data;
+        State state{State::Free};
+        int fd{-1};
+        int32_t result{0};  //!< bytes read, or -errno
+        iovec iov{};
+        msghdr msg{};
+        sockaddr_storage address{};
+    };
+
+    //! An attached file descriptor
+    struct Reader {
+        bool socket{false};
+        std::vector<size_t> slots{};            //!< the slots it reads into
+        RingQueue<size_t> ready{READS_PER_FD};  //!< slots holding completed reads, oldest first
+    };
+
+    IoUring _ring;
+    std::unique_ptr<char[]> _storage;
+    bool _registered{false};
+    std::vector<Slot> _slots{};
+    std::vector<size_t> _free{};
+    std::unordered_map<int, Reader> _readers{};
+
+    enum class Op : uint64_t { Read = 1, Write = 2, Poll = 3, Cancel = 4 };
+    static uint64_t tag(const Op op, const size_t slot) { return TAG | uint64_t(op) << 32 | slot; }
+
+    void submit_read(const size_t slot, const bool wait_for_data);
+    void complete(const IoUring::Completion &completion);
+
+    //! Take the oldest datagram read from `fd`, handing it to `copy(const char *data, size_t len)`
+    template <typename Copy>
+    ssize_t take_with(const int fd, Copy &&copy, sockaddr *address, socklen_t *address_len);
+
+  public:
+    //! \throws if io_uring is unavailable (see IoUring::available)
+    IoUringDatagrams();
+    //! Submit the writes still queued and wait (briefly) for those in flight, whose slots are freed here
+    ~IoUringDatagrams();
+    IoUringDatagrams(const IoUringDatagrams &other) = delete;
+    IoUringDatagrams &operator=(const IoUringDatagrams &other) = delete;
+
+    //! The ring, for other operations to share its system calls
+    IoUring &ring() { return _ring; }
+
+    //! \brief Give `fd` slots to read into
+    //! \returns `false` if MAX_ATTACHED file descriptors are already attached
+    bool attach(const int fd);
+    //! Cancel the reads of `fd` and return its slots
+    void detach(const int fd);
+    //! Whether `fd` is attached
+    bool attached(const int fd) const { return _readers.count(fd) > 0; }
+
+    //! Submit reads into the idle slots of `fd`
+    void start_reads(const int fd);
+    //! Whether a completed read of `fd` is waiting to be taken
+    bool readable(const int fd) const;
+
+    //! \brief Take the oldest datagram read from `fd`
+    //! \param[out] str receives the datagram (at most `limit` bytes of it)
+    //! \param[out] address receives the address it came from, if `fd` is a socket and this is not `nullptr`
+    //! \param[out] address_len receives the length of the address
+    //! \returns the datagram's full length, or -1 if no read has completed
+    //! \throws unix_error if the read failed
+    ssize_t take(const int fd, std::string &str, const size_t limit, sockaddr *address, socklen_t *address_len);
+
+    //! \brief Take the oldest datagram read from `fd`, scattering it over `count` caller-owned `buffers`
+    //! \details Like the other take(), but copies only as much of the datagram as the buffers hold, and
+    //! allocates nothing.
+    ssize_t take(const int fd, const iovec *buffers, const size_t count, sockaddr *address, socklen_t *address_len);
+
+    //! \brief Queue a write of `payload` to `fd` (or, if `address` is not `nullptr`, a send to `address`)
+    //! \returns `false` if the payload is larger than a slot, in which case nothing was queued
+    bool write(const int fd, const BufferViewList &payload, const sockaddr *address, const socklen_t address_len);
+
+    //! Handle the completions of this class's operations in IoUring::completed(), and erase them
+    void handle_completions();
+
+    //! Whether `user_data` belongs to an operation of this class
+    static bool owns(const uint64_t user_data) { return user_data & TAG; }
+};
+
+#endif  // SPONGE_LIBSPONGE_IO_URING_HH
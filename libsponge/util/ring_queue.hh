@@ -0,0 +1,97 @@
+#ifndef SPONGE_LIBSPONGE_RING_QUEUE_HH
+#define SPONGE_LIBSPONGE_RING_QUEUE_HH
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+//! \brief A single-threaded FIFO queue kept in a circular array of slots
+//! \details Unlike std::deque, the slots are reused as elements are popped and pushed, so a
+//! queue that has reached its working size no longer allocates. The array doubles when it is
+//! full. Elements can be read and modified in place by their position from the front.
+//! It meets the requirements of std::queue's underlying container.
+template <typename T>
+class RingQueue {
+  public:
+    using value_type = T;
+    using reference = T &;
+    using const_reference = const T &;
+    using size_type = size_t;
+
+  private:
+    std::vector<T> _slots;
+    size_t _head{0};  //!< position of the front element in `_slots`
+    size_t _size{0};
+
+    size_t slot(const size_t index) const { return (_head + index) & (_slots.size() - 1); }
+
+    void grow() {
+        std::vector<T> slots(_slots.size() * 2);
+        for (size_t i = 0; i < _size; i++) {
+            slots[i] = std::move(_slots[slot(i)]);
+        }
+        _slots = std::move(slots);
+        _head = 0;
+    }
+
+  public:
+    //! \param[in] initial_capacity number of slots to start with (rounded up to a power of two)
+    explicit RingQueue(const size_t initial_capacity = 16) : _slots() {
+        size_t capacity = 1;
+        while (capacity < initial_capacity) {
+            capacity *= 2;
+        }
+        _slots.resize(capacity);
+    }
+
+    //! \name Queue operations
+    //!@{
+    void push_back(T value) {
+        if (_size == _slots.size()) {
+            grow();
+        }
+        _slots[slot(_size)] = std::move(value);
+        _size++;
+    }
+
+    template <typename... Args>
+    T &emplace_back(Args &&... args) {
+        push_back(T(std::forward<Args>(args)...));
+        return back();
+    }
+
+    //! \note The slot is reset to `T{}`, so the popped element releases what it holds right away
+    void pop_front() {
+        if (_size == 0) {
+            throw std::runtime_error("RingQueue::pop_front: queue is empty");
+        }
+        _slots[_head] = T{};
+        _head = slot(1);
+        _size--;
+    }
+
+    void clear() {
+        while (_size > 0) {
+            pop_front();
+        }
+    }
+    //!@}
+
+    //! \name Element access
+    //!@{
+    T &front() { return _slots[_head]; }
+    const T &front() const { return _slots[_head]; }
+    T &back() { return _slots[slot(_size - 1)]; }
+    const T &back() const { return _slots[slot(_size - 1)]; }
+
+    //! \brief The element `index` positions from the front
+    T &operator[](const size_t index) { return _slots[slot(index)]; }
+    const T &operator[](const size_t index) const { return _slots[slot(index)]; }
+    //!@}
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+};
+
+#endif  // SPONGE_LIBSPONGE_RING_QUEUE_HH
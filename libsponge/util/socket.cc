@@ -1,8 +1,13 @@
 #include "socket.hh"
 
+#include "io_uring.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstring>
+#include <netinet/udp.h>
 #include <stdexcept>
 #include <unistd.h>
 
@@ -88,6 +93,19 @@ void Socket::shutdown(const int how) {
 void UDPSocket::recv(received_datagram &datagram, const size_t mtu) {
     // receive source address and payload
     Address::Raw datagram_source_address;
+
+    if (ring() != nullptr) {
+        socklen_t fromlen = sizeof(datagram_source_address);
+        const ssize_t recv_len = ring()->take(fd_num(), datagram.payload, mtu, datagram_source_address, &fromlen);
+        if (recv_len >= 0) {
+            if (recv_len > ssize_t(mtu)) {
+                throw runtime_error("recvfrom (oversized datagram)");
+            }
+            register_read();
+            datagram.source_address = {datagram_source_address, fromlen};
+            return;
+        }
+    }
     datagram.payload.resize(mtu);
 
     socklen_t fromlen = sizeof(datagram_source_address);
@@ -106,12 +124,200 @@ void UDPSocket::recv(received_datagram &datagram, const size_t mtu) {
     datagram.payload.resize(recv_len);
 }
 
+//! \param[out] source_address receives the Address of the sender
+//! \param[in] pool provides the payload's storage (it should have slabs of at least `mtu` bytes)
+//! \returns the datagram's payload
+//! \note If `mtu` is too small to hold the received datagram, this method throws a std::runtime_error
+Buffer UDPSocket::recv(Address &source_address, BufferPool &pool, const size_t mtu) {
+    Address::Raw datagram_source_address;
+    socklen_t fromlen = sizeof(datagram_source_address);
+
+    const auto receive = [&](char *dst) {
+        const iovec payload{dst, mtu};
+        ssize_t recv_len =
+            ring() == nullptr ? -1 : ring()->take(fd_num(), &payload, 1, datagram_source_address, &fromlen);
+        if (recv_len < 0) {
+            recv_len =
+                SystemCall("recvfrom", ::recvfrom(fd_num(), dst, mtu, MSG_TRUNC, datagram_source_address, &fromlen));
+        }
+        if (recv_len > ssize_t(mtu)) {
+            throw runtime_error("recvfrom (oversized datagram)");
+        }
+        return size_t(recv_len);
+    };
+    Buffer payload = pool.make_up_to(mtu, receive);
+
+    register_read();
+    source_address = {datagram_source_address, fromlen};
+    return payload;
+}
+
 UDPSocket::received_datagram UDPSocket::recv(const size_t mtu) {
     received_datagram ret{{nullptr, 0}, ""};
     recv(ret, mtu);
     return ret;
 }
 
+struct UDPSocket::BatchStorage {
+    //! Room for one control message: UDP_SEGMENT carries a uint16_t, UDP_GRO an int
+    union Control {
+        char buffer[CMSG_SPACE(sizeof(int))];
+        cmsghdr align;
+    };
+
+    std::array<mmsghdr, MAX_BATCH> messages{};
+    std::array<Control, MAX_BATCH> controls{};
+    std::array<Address::Raw, MAX_BATCH> addresses{};
+    std::vector<iovec> iovecs{};
+    std::unique_ptr<char[]> data{};  //!< MAX_BATCH datagrams of `mtu` bytes each (not cleared)
+    size_t mtu{0};
+};
+
+UDPSocket::BatchStorage &UDPSocket::batch() {
+    if (not _batch) {
+        _batch = make_shared<BatchStorage>();
+    }
+    return *_batch;
+}
+
+//! \param[out] datagrams receives the datagrams, replacing its contents
+//! \param[in] pool provides the payloads' storage
+//! \param[in] mtu is the largest datagram expected
+//! \returns the number of datagrams received
+//! \details Blocks until a datagram arrives (unless the socket is non-blocking), then takes the others
+//! that have already arrived, with [recvmmsg(2)](\ref man2::recvmmsg) and MSG_WAITFORONE. The datagrams
+//! are received into scratch space and copied into Buffers, so that each one takes only what it needs
+//! from `pool`. A datagram too big for `mtu` is dropped (UDPSocket::recv throws instead, but here that
+//! would lose the rest of the batch).
+size_t UDPSocket::recv_batch(vector<received_buffer> &datagrams, BufferPool &pool, const size_t mtu) {
+    datagrams.clear();
+
+    // datagrams read through a ring are already in memory
+    if (ring() != nullptr and ring()->readable(fd_num())) {
+        while (datagrams.size() < MAX_BATCH and ring()->readable(fd_num())) {
+            datagrams.push_back({{nullptr, 0}, {}, 0});
+            datagrams.back().payload = recv(datagrams.back().source_address, pool, mtu);
+        }
+        return datagrams.size();
+    }
+
+    BatchStorage &b = batch();
+    if (b.mtu < mtu) {
+        b.data.reset(new char[MAX_BATCH * mtu]);
+        b.mtu = mtu;
+    }
+    b.iovecs.resize(MAX_BATCH);
+    for (size_t i = 0; i < MAX_BATCH; i++) {
+        b.iovecs[i] = {b.data.get() + i * b.mtu, mtu};
+        msghdr &message = b.messages[i].msg_hdr;
+        message = {};
+        message.msg_name = &b.addresses[i].storage;
+        message.msg_namelen = sizeof(b.addresses[i].storage);
+        message.msg_iov = &b.iovecs[i];
+        message.msg_iovlen = 1;
+        message.msg_control = b.controls[i].buffer;
+        message.msg_controllen = sizeof(b.controls[i].buffer);
+    }
+
+    const int count =
+        SystemCall("recvmmsg", ::recvmmsg(fd_num(), b.messages.data(), MAX_BATCH, MSG_WAITFORONE, nullptr));
+    register_read();
+
+    for (int i = 0; i < count; i++) {
+        const mmsghdr &received = b.messages[i];
+        if (received.msg_hdr.msg_flags & MSG_TRUNC) {
+            continue;
+        }
+        const char *const data = b.data.get() + i * b.mtu;
+        datagrams.push_back({{b.addresses[i], received.msg_hdr.msg_namelen},
+                             pool.make(received.msg_len, [&](char *dst) { memcpy(dst, data, received.msg_len); }),
+                             0});
+
+        // a datagram coalesced by GRO says how big the datagrams in it are
+        for (const cmsghdr *control = CMSG_FIRSTHDR(&received.msg_hdr); control != nullptr;
+             control = CMSG_NXTHDR(const_cast<msghdr *>(&received.msg_hdr), const_cast<cmsghdr *>(control))) {
+            if (control->cmsg_level == SOL_UDP and control->cmsg_type == UDP_GRO) {
+                int segment_size = 0;
+                memcpy(&segment_size, CMSG_DATA(control), sizeof(segment_size));
+                if (size_t(segment_size) < received.msg_len) {
+                    datagrams.back().segment_size = segment_size;
+                }
+            }
+        }
+    }
+    return datagrams.size();
+}
+
+//! \param[in] destination is the Address to send to
+//! \param[in] payloads are the datagrams' payloads
+//! \details Sends MAX_BATCH datagrams at a time with [sendmmsg(2)](\ref man2::sendmmsg), blocking (unless
+//! the socket is non-blocking) until all have been sent.
+void UDPSocket::send_batch(const Address &destination, const vector<BufferList> &payloads) {
+    send_batch(destination, payloads, {});
+}
+
+//! \param[in] destination is the Address to send to
+//! \param[in] payloads are the datagrams' payloads
+//! \param[in] segment_sizes are the GSO segment sizes of the payloads (zero for none), or empty if none uses GSO
+//! \details Sends MAX_BATCH payloads at a time with [sendmmsg(2)](\ref man2::sendmmsg), blocking (unless
+//! the socket is non-blocking) until all have been sent. A GSO payload may hold at most MAX_GSO_SEGMENTS
+//! datagrams and MAX_GSO_PAYLOAD bytes.
+void UDPSocket::send_batch(const Address &destination,
+                           const vector<BufferList> &payloads,
+                           const vector<uint16_t> &segment_sizes) {
+    if (ring() != nullptr and segment_sizes.empty()) {
+        // the ring already sends all the datagrams written between two waits with one system call
+        for (const BufferList &payload : payloads) {
+            sendto(destination, payload);
+        }
+        return;
+    }
+
+    BatchStorage &b = batch();
+    for (size_t first = 0; first < payloads.size(); first += MAX_BATCH) {
+        const size_t count = min(MAX_BATCH, payloads.size() - first);
+
+        b.iovecs.clear();
+        for (size_t i = 0; i < count; i++) {
+            for (const Buffer &buffer : payloads[first + i].buffers()) {
+                b.iovecs.push_back({const_cast<char *>(buffer.str().data()), buffer.size()});
+            }
+        }
+        size_t next_iovec = 0;
+        for (size_t i = 0; i < count; i++) {
+            msghdr &message = b.messages[i].msg_hdr;
+            message = {};
+            message.msg_name = const_cast<sockaddr *>(static_cast<const sockaddr *>(destination));
+            message.msg_namelen = destination.size();
+            message.msg_iov = b.iovecs.data() + next_iovec;
+            message.msg_iovlen = payloads[first + i].buffers().size();
+            next_iovec += message.msg_iovlen;
+
+            const uint16_t segment_size = segment_sizes.empty() ? 0 : segment_sizes[first + i];
+            if (segment_size > 0) {
+                message.msg_control = b.controls[i].buffer;
+                message.msg_controllen = CMSG_SPACE(sizeof(segment_size));
+                cmsghdr *const control = CMSG_FIRSTHDR(&message);
+                control->cmsg_level = SOL_UDP;
+                control->cmsg_type = UDP_SEGMENT;
+                control->cmsg_len = CMSG_LEN(sizeof(segment_size));
+                memcpy(CMSG_DATA(control), &segment_size, sizeof(segment_size));
+            }
+        }
+
+        for (size_t sent = 0; sent < count;) {
+            sent += SystemCall("sendmmsg", ::sendmmsg(fd_num(), b.messages.data() + sent, count - sent, 0));
+        }
+        register_write();
+
+        for (size_t i = 0; i < count; i++) {
+            if (b.messages[i].msg_len != payloads[first + i].size()) {
+                throw runtime_error("datagram payload too big for sendmmsg()");
+            }
+        }
+    }
+}
+
 void sendmsg_helper(const int fd_num,
                     const sockaddr *destination_address,
                     const socklen_t destination_address_len,
@@ -132,12 +338,16 @@ void sendmsg_helper(const int fd_num,
 }
 
 void UDPSocket::sendto(const Address &destination, const BufferViewList &payload) {
-    sendmsg_helper(fd_num(), destination, destination.size(), payload);
+    if (ring() == nullptr or not ring()->write(fd_num(), payload, destination, destination.size())) {
+        sendmsg_helper(fd_num(), destination, destination.size(), payload);
+    }
     register_write();
 }
 
 void UDPSocket::send(const BufferViewList &payload) {
-    sendmsg_helper(fd_num(), nullptr, 0, payload);
+    if (ring() == nullptr or not ring()->write(fd_num(), payload, nullptr, 0)) {
+        sendmsg_helper(fd_num(), nullptr, 0, payload);
+    }
     register_write();
 }
 
@@ -166,3 +376,6 @@ void Socket::setsockopt(const int level, const int option, const option_type &op
 // allow local address to be reused sooner, at the cost of some robustness
 //! \note Using `SO_REUSEADDR` may reduce the robustness of your application
 void Socket::set_reuseaddr() { setsockopt(SOL_SOCKET, SO_REUSEADDR, int(true)); }
+
+//! \param[in] enabled is whether to receive coalesced datagrams
+void UDPSocket::set_gro(const bool enabled) { setsockopt(SOL_UDP, UDP_GRO, int(enabled)); }
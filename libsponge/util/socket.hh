@@ -6,8 +6,10 @@
 
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <sys/socket.h>
+#include <vector>
 
 //! \brief Base class for network sockets (TCP, UDP, etc.)
 //! \details Socket is generally used via a subclass. See TCPSocket and UDPSocket for usage examples.
@@ -49,6 +51,14 @@ class Socket : public FileDescriptor {
 
 //! A wrapper around [UDP sockets](\ref man7::udp)
 class UDPSocket : public Socket {
+  private:
+    //! Scratch space for recv_batch() and send_batch(), kept between calls
+    struct BatchStorage;
+    std::shared_ptr<BatchStorage> _batch{};
+
+    //! The scratch space, allocated on first use
+    BatchStorage &batch();
+
   protected:
     //! \brief Construct from FileDescriptor (used by TCPOverUDPSocketAdapter)
     //! \param[in] fd is the FileDescriptor from which to construct
@@ -70,6 +80,44 @@ class UDPSocket : public Socket {
     //! Receive a datagram and the Address of its sender (caller can allocate storage)
     void recv(received_datagram &datagram, const size_t mtu = 65536);
 
+    //! Receive a datagram into a Buffer carved out of `pool`, and the Address of its sender
+    Buffer recv(Address &source_address, BufferPool &pool, const size_t mtu = 65536);
+
+    //! Most datagrams moved by one call of recv_batch() or by one system call of send_batch()
+    static constexpr size_t MAX_BATCH = 32;
+
+    //! Most datagrams that one GSO send can cover (UDP_MAX_SEGMENTS in Linux)
+    static constexpr size_t MAX_GSO_SEGMENTS = 64;
+
+    //! Largest payload of one GSO send (the largest UDP payload over IPv4)
+    static constexpr size_t MAX_GSO_PAYLOAD = 65507;
+
+    //! Returned by UDPSocket::recv_batch; the payload is carved out of a BufferPool
+    struct received_buffer {
+        Address source_address;  //!< Address from which this datagram was received
+        Buffer payload;          //!< UDP datagram payload
+        size_t segment_size;     //!< With GRO, size of each datagram coalesced into `payload` (else 0)
+    };
+
+    //! Receive the datagrams that are waiting (at least one, and at most MAX_BATCH) with one system call
+    size_t recv_batch(std::vector<received_buffer> &datagrams, BufferPool &pool, const size_t mtu = 65536);
+
+    //! Send datagrams to specified Address, up to MAX_BATCH per system call
+    void send_batch(const Address &destination, const std::vector<BufferList> &payloads);
+
+    //! \brief Send datagrams to specified Address, some of them with GSO
+    //! \details Where `segment_sizes[i]` is not zero, `payloads[i]` is sent as datagrams of that size (and a
+    //! shorter last one), cut by the kernel (see [UDP_SEGMENT](\ref man7::udp)).
+    void send_batch(const Address &destination,
+                    const std::vector<BufferList> &payloads,
+                    const std::vector<uint16_t> &segment_sizes);
+
+    //! \brief Let the kernel coalesce datagrams from the same flow into one (see [UDP_GRO](\ref man7::udp))
+    //! \details recv_batch reports the size of the coalesced datagrams in received_buffer::segment_size;
+    //! the other receive functions would see the datagrams run together.
+    //! \throws unix_error if the kernel does not support UDP GRO
+    void set_gro(const bool enabled);
+
     //! Send a datagram to specified Address
     void sendto(const Address &destination, const BufferViewList &payload);
 
@@ -78,7 +126,9 @@ class UDPSocket : public Socket {
 };
 
 //! \class UDPSocket
-//! Functions in this class are essentially wrappers over their POSIX eponyms.
+//! Functions in this class are essentially wrappers over their POSIX eponyms. The batch functions
+//! wrap [recvmmsg(2)](\ref man2::recvmmsg) and [sendmmsg(2)](\ref man2::sendmmsg), which move many
+//! datagrams per system call.
 //!
 //! Example:
 //!
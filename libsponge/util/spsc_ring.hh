@@ -0,0 +1,67 @@
+#ifndef SPONGE_LIBSPONGE_SPSC_RING_HH
+#define SPONGE_LIBSPONGE_SPSC_RING_HH
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+//! \brief A bounded, lock-free queue between exactly one producer thread and one consumer thread
+//! \details Elements are moved into and out of a fixed array of slots, so steady-state use
+//! does not allocate. The producer only writes `_tail` and the consumer only writes `_head`;
+//! each index lives on its own cache line so the two threads do not contend for it.
+template <typename T>
+class SPSCRing {
+  private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::vector<T> _slots;
+    size_t _mask;
+
+    alignas(CACHE_LINE) std::atomic<size_t> _head{0};  //!< next slot to pop (written by the consumer)
+    alignas(CACHE_LINE) std::atomic<size_t> _tail{0};  //!< next slot to push (written by the producer)
+
+  public:
+    //! \param[in] capacity maximum number of queued elements (must be a power of two)
+    explicit SPSCRing(const size_t capacity) : _slots(capacity), _mask(capacity - 1) {
+        if (capacity == 0 or (capacity & _mask) != 0) {
+            throw std::runtime_error("SPSCRing: capacity must be a power of two");
+        }
+    }
+
+    SPSCRing(const SPSCRing &other) = delete;
+    SPSCRing &operator=(const SPSCRing &other) = delete;
+
+    //! \brief Move `value` into the ring (producer side)
+    //! \returns false, leaving `value` untouched, if the ring is full
+    bool try_push(T &value) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) == _slots.size()) {
+            return false;
+        }
+        _slots[tail & _mask] = std::move(value);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief Move the oldest element out of the ring into `value` (consumer side)
+    //! \returns false if the ring is empty
+    bool try_pop(T &value) {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(_slots[head & _mask]);
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief Whether the ring looked empty (exact only on the consumer side)
+    bool empty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+
+    //! \brief Maximum number of queued elements
+    size_t capacity() const { return _slots.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_SPSC_RING_HH
@@ -0,0 +1,147 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+//! \param[in] granularity_us length of one tick, in microseconds
+//! \param[in] now_us the current time, in microseconds
+TimerWheel::TimerWheel(const uint64_t granularity_us, const uint64_t now_us)
+    : _granularity_us(granularity_us), _now_tick(now_us / max(granularity_us, uint64_t{1})) {
+    if (granularity_us == 0) {
+        throw runtime_error("TimerWheel: granularity must be positive");
+    }
+}
+
+void TimerWheel::file(Timer &&timer) {
+    const uint64_t deadline = timer.deadline_tick;
+    // the finest level whose slots, together, reach the deadline: everything above that level's
+    // bits is the same in the deadline and the current tick
+    for (unsigned level = 0; level < LEVELS; level++) {
+        const unsigned higher = SLOT_BITS * (level + 1);
+        if ((deadline >> higher) == (_now_tick >> higher)) {
+            _wheel[level][(deadline >> (SLOT_BITS * level)) & (SLOTS - 1)].push_back(move(timer));
+            _level_size[level]++;
+            return;
+        }
+    }
+    _overflow.push_back(move(timer));
+}
+
+void TimerWheel::cascade(const unsigned level, const size_t slot, vector<Timer> &due) {
+    vector<Timer> timers;
+    if (level == LEVELS) {
+        timers.swap(_overflow);
+    } else {
+        timers.swap(_wheel[level][slot]);
+        _level_size[level] -= timers.size();
+    }
+    for (auto &timer : timers) {
+        if (_pending.count(timer.id) == 0) {
+            continue;  // cancelled
+        }
+        if (timer.deadline_tick <= _now_tick) {
+            due.push_back(move(timer));
+        } else {
+            file(move(timer));
+        }
+    }
+}
+
+TimerWheel::TimerId TimerWheel::schedule(const uint64_t deadline_us, Callback callback) {
+    const TimerId id = _next_id++;
+    _pending.insert(id);
+    const uint64_t deadline_tick = (deadline_us + _granularity_us - 1) / _granularity_us;
+    Timer timer{id, max(deadline_tick, _now_tick), move(callback)};
+    if (timer.deadline_tick == _now_tick) {
+        // already due: level 0's slot for the current tick has been emptied, so the overflow list
+        // (which is refiled on every advance that finds it due) holds it until the next advance
+        _overflow.push_back(move(timer));
+    } else {
+        file(move(timer));
+    }
+    return id;
+}
+
+bool TimerWheel::cancel(const TimerId id) { return _pending.erase(id) > 0; }
+
+void TimerWheel::advance(const uint64_t now_us) {
+    const uint64_t target = now_us / _granularity_us;
+    vector<Timer> due;
+
+    // timers that were already due when they were scheduled
+    if (any_of(_overflow.begin(), _overflow.end(), [&](const Timer &t) { return t.deadline_tick <= _now_tick; })) {
+        cascade(LEVELS, 0, due);
+    }
+
+    while (_now_tick < target) {
+        // jump over ticks at which nothing can happen: to the next slot boundary of the finest
+        // level that holds any timers
+        unsigned finest = 0;
+        while (finest < LEVELS and _level_size[finest] == 0) {
+            finest++;
+        }
+        uint64_t next = target;
+        if (finest < LEVELS or not _overflow.empty()) {
+            const uint64_t unit = uint64_t{1} << (SLOT_BITS * finest);
+            next = min(target, (_now_tick / unit + 1) * unit);
+        }
+        _now_tick = next;
+
+        // refill the finer levels from the coarser ones, coarsest first
+        for (unsigned level = LEVELS; level >= 1; level--) {
+            const uint64_t unit = uint64_t{1} << (SLOT_BITS * level);
+            if (_now_tick % unit == 0) {
+                cascade(level, (_now_tick >> (SLOT_BITS * level)) & (SLOTS - 1), due);
+            }
+        }
+        cascade(0, _now_tick & (SLOTS - 1), due);
+    }
+
+    stable_sort(
+        due.begin(), due.end(), [](const Timer &a, const Timer &b) { return a.deadline_tick < b.deadline_tick; });
+    for (auto &timer : due) {
+        // an earlier callback may have cancelled this timer
+        if (_pending.erase(timer.id) > 0) {
+            timer.callback();
+        }
+    }
+}
+
+optional<uint64_t> TimerWheel::next_deadline() const {
+    if (_pending.empty()) {
+        return {};
+    }
+    if (not _overflow.empty()) {
+        // overflow timers are either due already or at least a whole turn of the top level away
+        const bool due = any_of(_overflow.begin(), _overflow.end(), [&](const Timer &t) {
+            return t.deadline_tick <= _now_tick;
+        });
+        if (due) {
+            return _now_tick * _granularity_us;
+        }
+    }
+
+    // the earliest non-empty slot of each level is when its timers are next looked at
+    optional<uint64_t> earliest{};
+    if (not _overflow.empty()) {
+        const uint64_t unit = uint64_t{1} << (SLOT_BITS * LEVELS);
+        earliest = (_now_tick / unit + 1) * unit;
+    }
+    for (unsigned level = 0; level < LEVELS; level++) {
+        if (_level_size[level] == 0) {
+            continue;
+        }
+        const unsigned shift = SLOT_BITS * level;
+        const uint64_t block_start = (_now_tick >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+        for (size_t slot = ((_now_tick >> shift) & (SLOTS - 1)) + 1; slot < SLOTS; slot++) {
+            if (not _wheel[level][slot].empty()) {
+                const uint64_t tick = block_start + (uint64_t{slot} << shift);
+                earliest = min(earliest.value_or(tick), tick);
+                break;
+            }
+        }
+    }
+    return earliest.value_or(_now_tick) * _granularity_us;
+}
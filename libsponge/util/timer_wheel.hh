@@ -0,0 +1,76 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+//! \brief A hierarchical timing wheel: many one-shot timers with O(1) scheduling and cancellation
+//! \details Time is counted in ticks of `granularity_us` microseconds. Level 0 has one slot per
+//! tick for the next 64 ticks, level 1 one slot per 64 ticks for the next 64^2 ticks, and so on.
+//! Timers are filed in the finest level that covers their deadline and are moved down a level
+//! when the wheel reaches their slot, so each timer is touched at most once per level. A timer
+//! never fires before its deadline, and fires at most one tick after it.
+class TimerWheel {
+  public:
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+  private:
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;
+    static constexpr unsigned LEVELS = 4;
+
+    struct Timer {
+        TimerId id;
+        uint64_t deadline_tick;
+        Callback callback;
+    };
+
+    uint64_t _granularity_us;
+    uint64_t _now_tick{0};
+    TimerId _next_id{1};
+
+    std::array<std::array<std::vector<Timer>, SLOTS>, LEVELS> _wheel{};
+    std::array<size_t, LEVELS> _level_size{};
+
+    //! Timers due beyond the range of the top level, filed again each time the top level wraps
+    std::vector<Timer> _overflow{};
+
+    //! Timers that are scheduled and have neither fired nor been cancelled
+    std::unordered_set<TimerId> _pending{};
+
+    void file(Timer &&timer);
+
+    //! Move the timers in one slot down to finer levels (or fire them if due)
+    void cascade(unsigned level, size_t slot, std::vector<Timer> &due);
+
+  public:
+    //! \param[in] granularity_us length of one tick, in microseconds
+    //! \param[in] now_us the current time, in microseconds
+    explicit TimerWheel(uint64_t granularity_us = 10, uint64_t now_us = 0);
+
+    //! \brief Call `callback` once the time reaches `deadline_us` (right away, at the next advance, if it has)
+    TimerId schedule(uint64_t deadline_us, Callback callback);
+
+    //! \brief Cancel a pending timer
+    //! \returns `false` if the timer already fired or was cancelled
+    bool cancel(TimerId id);
+
+    //! \brief Move the clock forward to `now_us`, calling the callbacks of the timers that are due
+    //! \details Callbacks run in order of deadline; they may schedule or cancel timers.
+    void advance(uint64_t now_us);
+
+    //! \brief A time, no later than the earliest deadline, at which advance() should next be called
+    //! \returns empty if no timer is pending
+    std::optional<uint64_t> next_deadline() const;
+
+    //! \brief Number of pending timers
+    size_t size() const { return _pending.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
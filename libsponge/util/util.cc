@@ -1,8 +1,11 @@
 #include "util.hh"
 
+#include "checksum_kernels.hh"
+
 #include <array>
 #include <cctype>
 #include <chrono>
+#include <endian.h>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -10,14 +13,19 @@
 
 using namespace std;
 
-//! \returns the number of milliseconds since the program started
-uint64_t timestamp_ms() {
+//! \returns the time elapsed since the program started (strictly, since this function was first called)
+static std::chrono::steady_clock::duration time_since_start() {
     using time_point = std::chrono::steady_clock::time_point;
     static const time_point program_start = std::chrono::steady_clock::now();
-    const time_point now = std::chrono::steady_clock::now();
-    return std::chrono::duration_cast<std::chrono::milliseconds>(now - program_start).count();
+    return std::chrono::steady_clock::now() - program_start;
 }
 
+//! \returns the number of milliseconds since the program started
+uint64_t timestamp_ms() { return std::chrono::duration_cast<std::chrono::milliseconds>(time_since_start()).count(); }
+
+//! \returns the number of microseconds since the program started
+uint64_t timestamp_us() { return std::chrono::duration_cast<std::chrono::microseconds>(time_since_start()).count(); }
+
 //! \param[in] attempt is the name of the syscall to try (for error reporting)
 //! \param[in] return_value is the return value of the syscall
 //! \param[in] errno_mask is any errno value that is acceptable, e.g., `EAGAIN` when reading a non-blocking fd
@@ -86,19 +94,54 @@ mt19937 get_random_generator() {
 //! on the Internet checksum, and consult the [IP](\ref rfc::rfc791) and [TCP](\ref rfc::rfc793) RFCs.
 InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
 
+//! \details The bytes are summed a machine word (or SIMD register) at a time; see checksum_partial().
+//! Successive calls behave as if all the data had been passed at once: if the previous call ended
+//! on an odd byte, the first byte of `data` completes that 16-bit word.
 void InternetChecksum::add(std::string_view data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        uint16_t val = uint8_t(data[i]);
-        if (not _parity) {
-            val <<= 8;
-        }
-        _sum += val;
-        _parity = !_parity;
+    if (data.empty()) {
+        return;
+    }
+    if (_parity) {
+        _sum += uint8_t(data.front());
+        data.remove_prefix(1);
+        _parity = false;
     }
+    static const ChecksumKernel kernel = checksum_best_kernel();
+    _sum += be16toh(checksum_partial(data.data(), data.size(), kernel));
+    _parity = data.size() % 2;
+}
+
+//! \param[in] data the bytes to sum
+//! \param[out] dst receives a copy of `data`
+void InternetChecksum::add_copy(std::string_view data, char *dst) {
+    if (data.empty()) {
+        return;
+    }
+    if (_parity) {
+        *dst++ = data.front();
+        _sum += uint8_t(data.front());
+        data.remove_prefix(1);
+        _parity = false;
+    }
+    static const ChecksumKernel kernel = checksum_best_kernel();
+    _sum += be16toh(checksum_copy_partial(dst, data.data(), data.size(), kernel));
+    _parity = data.size() % 2;
+}
+
+//! \param[in] other a checksum over the data that follows (including its own initial sum, if any)
+//! \details If the data so far has odd length, every byte summed by `other` lands on the other
+//! half of its 16-bit word, which swaps the two bytes of its one's-complement sum.
+void InternetChecksum::add(const InternetChecksum &other) {
+    uint64_t sum = other._sum;
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    _sum += _parity ? ((sum & 0xff) << 8 | sum >> 8) : sum;
+    _parity = _parity != other._parity;
 }
 
 uint16_t InternetChecksum::value() const {
-    uint32_t ret = _sum;
+    uint64_t ret = _sum;
 
     while (ret > 0xffff) {
         ret = (ret >> 16) + (ret & 0xffff);
@@ -107,6 +150,20 @@ uint16_t InternetChecksum::value() const {
     return ~ret;
 }
 
+//! \param[in] checksum the checksum stored in the header before the change
+//! \param[in] old_word the 16-bit word (in host order) before the change
+//! \param[in] new_word the same word after the change
+//! \returns the checksum of the modified data, computed without revisiting the rest of it
+//! \details Uses eqn. 3 of [RFC 1624](\ref rfc::rfc1624), HC' = ~(~HC + ~m + m'), which
+//! (unlike the older eqn. 2 of RFC 1141) never produces 0xffff for a nonzero sum.
+uint16_t InternetChecksum::update(const uint16_t checksum, const uint16_t old_word, const uint16_t new_word) {
+    uint32_t sum = uint16_t(~checksum) + uint16_t(~old_word) + uint32_t(new_word);
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
 //! \param[in] data is a pointer to the bytes to show
 //! \param[in] len is the number of bytes to show
 //! \param[in] indent is the number of spaces to indent
@@ -51,16 +51,29 @@ std::mt19937 get_random_generator();
 //! Get the time in milliseconds since the program began.
 uint64_t timestamp_ms();
 
+//! Get the time in microseconds since the program began (on the same clock as timestamp_ms).
+uint64_t timestamp_us();
+
 //! The internet checksum algorithm
 class InternetChecksum {
   private:
-    uint32_t _sum;
+    uint64_t _sum;
     bool _parity{};
 
   public:
     InternetChecksum(const uint32_t initial_sum = 0);
     void add(std::string_view data);
     uint16_t value() const;
+
+    //! Add `data` while copying it to `dst` (which must have room for `data.size()` bytes),
+    //! so that each byte is read only once
+    void add_copy(std::string_view data, char *dst);
+
+    //! Add the data summed by `other`, as if it were appended to the data summed so far
+    void add(const InternetChecksum &other);
+
+    //! Recompute a checksum after one 16-bit word of the checksummed data changed
+    static uint16_t update(const uint16_t checksum, const uint16_t old_word, const uint16_t new_word);
 };
 
 //! Hexdump the contents of a packet (or any other sequence of bytes)
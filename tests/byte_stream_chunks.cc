@@ -0,0 +1,61 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "test_err_if.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // Chunks 模式下写入的 Buffer 不应被拷贝，且容量按字节精确计算
+            ByteStream bs{10, ByteStream::Storage::Chunks};
+            Buffer first{string("hello")};
+            Buffer second{string("wonderful")};
+            const char *first_data = first.str().data();
+            const char *second_data = second.str().data();
+
+            test_err_if(bs.write(first) != 5, "first write should be accepted whole");
+            test_err_if(bs.write(second) != 5, "second write should be trimmed to the remaining capacity");
+            test_err_if(bs.remaining_capacity() != 0, "stream should be full");
+            test_err_if(bs.peek_output(10) != "hellowonde", "peek_output should join the chunks");
+
+            const auto [span1, span2] = bs.peek_spans(7);
+            test_err_if(span1.data() != first_data or span1 != "hello", "first span should alias the first Buffer");
+            test_err_if(span2.data() != second_data or span2 != "wo", "second span should alias the second Buffer");
+
+            bs.pop_output(3);
+            const BufferList out = bs.read_buffers(4);
+            test_err_if(out.buffers().size() != 2, "read_buffers should return one slice per chunk");
+            test_err_if(out.buffers()[0].str().data() != first_data + 3, "slice should share the written storage");
+            test_err_if(out.concatenate() != "lowo", "read_buffers returned the wrong bytes");
+            test_err_if(bs.bytes_read() != 7 or bs.buffer_size() != 3, "wrong accounting after read_buffers");
+            test_err_if(bs.read(10) != "nde", "read should return the rest of the trimmed chunk");
+
+            test_err_if(bs.write(string("abc")) != 3, "string writes should still work in Chunks mode");
+            test_err_if(bs.read(3) != "abc", "string write was not readable");
+        }
+
+        {
+            // 按序到达的 Buffer 应被直接交给 Chunks 模式的输出流
+            StreamReassembler reassembler{8, ByteStream::Storage::Chunks};
+            Buffer segment{string("abcdef")};
+            reassembler.push_substring(segment, 0, false);
+            const auto [span, rest] = reassembler.stream_out().peek_spans(6);
+            test_err_if(span.data() != segment.str().data(), "in-order data should not be copied");
+            test_err_if(not rest.empty(), "one segment should be a single chunk");
+
+            reassembler.push_substring(Buffer{string("defghijk")}, 3, true);
+            test_err_if(reassembler.stream_out().read(8) != "abcdefgh", "overlapping Buffer was not trimmed");
+            test_err_if(reassembler.stream_out().input_ended(), "eof past the capacity should not end the stream");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,59 @@
+#include "byte_stream.hh"
+#include "test_err_if.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // 写入的数据跨越环形缓冲区末尾时，peek_spans 应返回两段
+            ByteStream bs{8};
+            test_err_if(bs.write(string_view("abcdef")) != 6, "write(string_view) should accept 6 bytes");
+            bs.pop_output(5);
+            test_err_if(bs.write(string_view("ghijklmnop")) != 7, "write should stop at remaining capacity");
+            test_err_if(bs.remaining_capacity() != 0, "stream should be full");
+
+            const auto [first, second] = bs.peek_spans(8);
+            test_err_if(first != "fgh", "first span should end at the end of the ring");
+            test_err_if(second != "ijklm", "second span should start at the beginning of the ring");
+            test_err_if(bs.peek_output(8) != "fghijklm", "peek_output should join both spans");
+
+            const auto [short_first, short_second] = bs.peek_spans(2);
+            test_err_if(short_first != "fg" or not short_second.empty(), "short peek should not wrap");
+
+            test_err_if(bs.read(4) != "fghi", "read should return the wrapped bytes in order");
+            test_err_if(bs.bytes_read() != 9 or bs.bytes_written() != 13, "wrong accounting after read");
+        }
+
+        {
+            // 拷贝后的流与原流互不影响
+            ByteStream bs{4};
+            bs.write(string("xyz"));
+            bs.pop_output(2);
+            bs.write(string("uvw"));
+            ByteStream copy{bs};
+            bs.pop_output(4);
+            test_err_if(copy.peek_output(4) != "zuvw", "copied stream should keep the wrapped contents");
+            copy = bs;
+            test_err_if(not copy.buffer_empty(), "assigned stream should be empty");
+        }
+
+        {
+            // 容量为 0 的流不能写入任何数据
+            ByteStream bs{0};
+            test_err_if(bs.write(string_view("a")) != 0, "zero-capacity stream should not accept data");
+            const auto [first, second] = bs.peek_spans(1);
+            test_err_if(not first.empty() or not second.empty(), "zero-capacity stream should have no spans");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
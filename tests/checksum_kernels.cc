@@ -0,0 +1,121 @@
+#include "checksum_kernels.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <endian.h>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+namespace {
+//! 逐字节计算的参考实现（原先的 InternetChecksum::add，累加器放宽到 64 位以免长数据溢出）
+class ReferenceChecksum {
+    uint64_t _sum;
+    bool _parity{};
+
+  public:
+    explicit ReferenceChecksum(const uint32_t initial_sum = 0) : _sum(initial_sum) {}
+
+    void add(string_view data) {
+        for (size_t i = 0; i < data.size(); i++) {
+            uint16_t val = uint8_t(data[i]);
+            if (not _parity) {
+                val <<= 8;
+            }
+            _sum += val;
+            _parity = !_parity;
+        }
+    }
+
+    uint16_t value() const {
+        uint64_t ret = _sum;
+        while (ret > 0xffff) {
+            ret = (ret >> 16) + (ret & 0xffff);
+        }
+        return ~ret;
+    }
+};
+
+const ChecksumKernel KERNELS[] = {ChecksumKernel::Scalar, ChecksumKernel::SSE2, ChecksumKernel::AVX2};
+
+void check_kernels(const string &data) {
+    ReferenceChecksum reference;
+    reference.add(data);
+    for (const auto kernel : KERNELS) {
+        if (not checksum_kernel_supported(kernel)) {
+            continue;
+        }
+        // 每个内核都从字符串的不同对齐位置开始求和
+        for (size_t offset = 0; offset < 4 and offset <= data.size(); offset++) {
+            ReferenceChecksum expected;
+            expected.add(string_view(data).substr(offset));
+            const uint16_t partial = checksum_partial(data.data() + offset, data.size() - offset, kernel);
+            test_err_if(uint16_t(~be16toh(partial)) != expected.value(),
+                        "kernel " + to_string(int(kernel)) + " disagrees on " + to_string(data.size()) + " bytes");
+
+            string copy(data.size() - offset, 0);
+            const uint16_t copy_partial = checksum_copy_partial(copy.data(), data.data() + offset, copy.size(), kernel);
+            test_err_if(copy_partial != partial or copy != data.substr(offset),
+                        "fused copy kernel " + to_string(int(kernel)) + " is wrong");
+        }
+    }
+}
+}  // namespace
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (size_t trial = 0; trial < 3000; trial++) {
+            string data(rd() % (trial < 2000 ? 300 : 5000), 0);
+            for (auto &c : data) {
+                c = char(rd());
+            }
+            check_kernels(data);
+
+            // 随机切分成若干段（多数为奇数长度）依次 add，结果应与参考实现一致
+            const uint32_t initial = rd() % 2 ? 0 : rd();
+            ReferenceChecksum reference{initial};
+            InternetChecksum check{initial};
+            reference.add(data);
+            for (size_t offset = 0; offset < data.size();) {
+                const size_t len = rd() % 67;
+                check.add(string_view(data).substr(offset, len));
+                offset += len;
+            }
+            test_err_if(check.value() != reference.value(), "InternetChecksum disagrees with the byte-wise version");
+
+            // add_copy 应与 add 结果相同并完整拷贝数据；分段求和后再合并也应得到同样的结果
+            InternetChecksum copied{initial};
+            InternetChecksum combined{initial};
+            string copy(data.size(), 0);
+            for (size_t offset = 0; offset < data.size();) {
+                const size_t len = rd() % 67;
+                const string_view piece = string_view(data).substr(offset, len);
+                copied.add_copy(piece, copy.data() + offset);
+                InternetChecksum piece_check;
+                piece_check.add(piece);
+                combined.add(piece_check);
+                offset += piece.size();
+            }
+            test_err_if(copy != data, "add_copy did not copy the data");
+            test_err_if(copied.value() != reference.value(), "add_copy disagrees with the byte-wise version");
+            test_err_if(combined.value() != reference.value(), "combined checksums disagree with the byte-wise version");
+        }
+
+        // 全 0 与全 0xff 的长数据：检验向量寄存器中各通道不会溢出，且 0 与 0xffff 的区分不变
+        for (const char fill : {char(0), char(0xff)}) {
+            for (const size_t size : {size_t(1), size_t(2), size_t(3), size_t(1) << 20, (size_t(1) << 20) + 1}) {
+                check_kernels(string(size, fill));
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
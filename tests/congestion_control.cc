@@ -0,0 +1,259 @@
+#include "congestion_control.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_sender.hh"
+#include "tcp_test_helpers.hh"
+#include "test_err_if.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! 单向链路：按固定速率串行发送，队列满时尾部丢弃，另有随机丢包和固定的传播时延
+class Link {
+    uint64_t _rate;  // 字节/毫秒，0 表示不限速
+    uint64_t _delay_ms;
+    size_t _queue_limit;
+    double _loss;
+    mt19937 _rng;
+    uint64_t _busy_until_us{0};
+    deque<pair<uint64_t, TCPSegment>> _wire{};
+
+  public:
+    size_t drops{0};
+
+    Link(uint64_t rate, uint64_t delay_ms, size_t queue_limit, double loss, uint32_t seed)
+        : _rate(rate), _delay_ms(delay_ms), _queue_limit(queue_limit), _loss(loss), _rng(seed) {}
+
+    void send(const TCPSegment &seg, const uint64_t now_ms) {
+        if (_loss > 0 and uniform_real_distribution<double>(0, 1)(_rng) < _loss) {
+            drops++;
+            return;
+        }
+        if (_rate == 0) {
+            _wire.emplace_back(now_ms + _delay_ms, seg);
+            return;
+        }
+        // 再加上 IP 和 TCP 首部的 40 字节
+        const uint64_t size = seg.payload().size() + 40;
+        const uint64_t now_us = now_ms * 1000;
+        const uint64_t start_us = max(now_us, _busy_until_us);
+        if ((start_us - now_us) * _rate / 1000 + size > _queue_limit) {
+            drops++;
+            return;
+        }
+        _busy_until_us = start_us + size * 1000 / _rate;
+        _wire.emplace_back((_busy_until_us + 999) / 1000 + _delay_ms, seg);
+    }
+
+    template <typename F>
+    void deliver(const uint64_t now_ms, F &&receive) {
+        while (not _wire.empty() and _wire.front().first <= now_ms) {
+            receive(_wire.front().second);
+            _wire.pop_front();
+        }
+    }
+};
+
+struct Path {
+    string name;
+    uint64_t rate;  // 字节/毫秒
+    uint64_t delay_ms;
+    size_t queue_limit;
+    double loss;
+};
+
+struct Result {
+    bool complete;
+    uint64_t elapsed_ms;
+    size_t drops;
+};
+
+char pattern(const size_t i) { return char('a' + i % 23); }
+
+//! 通过 path 从 client 向 server 传输 total 字节，返回所用时间
+//! \param recovery 是否启用快速重传和 SACK
+Result transfer(const Path &path, const CongestionControl algorithm, const bool recovery, const size_t total) {
+    const SilenceCerr silence;
+    TCPConfig cfg;
+    cfg.rt_timeout = 200;
+    cfg.congestion_control = algorithm;
+    cfg.fast_retransmit = recovery;
+    cfg.sack = recovery;
+    TCPConnection client{cfg};
+    TCPConnection server{cfg};
+    Link forward{path.rate, path.delay_ms, path.queue_limit, path.loss, 1};
+    Link reverse{0, path.delay_ms, 0, 0, 2};
+
+    uint64_t now = 0;
+    size_t written = 0;
+    size_t received = 0;
+    const auto pump = [&] {
+        while (written < total and client.remaining_outbound_capacity() > 0) {
+            const size_t len = min(client.remaining_outbound_capacity(), total - written);
+            string chunk(len, 0);
+            for (size_t i = 0; i < len; i++) {
+                chunk[i] = pattern(written + i);
+            }
+            written += client.write(chunk);
+        }
+        for (; not client.segments_out().empty(); client.segments_out().pop()) {
+            forward.send(client.segments_out().front(), now);
+        }
+        for (; not server.segments_out().empty(); server.segments_out().pop()) {
+            reverse.send(server.segments_out().front(), now);
+        }
+    };
+
+    client.connect();
+    pump();
+    const uint64_t limit_ms = 600000;
+    while (received < total and now < limit_ms and client.active()) {
+        now++;
+        client.tick(1);
+        server.tick(1);
+        forward.deliver(now, [&](const TCPSegment &seg) { server.segment_received(seg); });
+        reverse.deliver(now, [&](const TCPSegment &seg) { client.segment_received(seg); });
+        const string data = server.inbound_stream().read(server.inbound_stream().buffer_size());
+        for (size_t i = 0; i < data.size(); i++) {
+            test_err_if(data[i] != pattern(received + i), "corrupted data at byte " + to_string(received + i));
+        }
+        received += data.size();
+        pump();
+    }
+    return {received == total, now, forward.drops};
+}
+}  // namespace
+
+int main() {
+    try {
+        {
+            // None 不创建控制器，其余算法名称正确
+            test_err_if(make_congestion_controller(CongestionControl::None, MSS) != nullptr, "None should be null");
+            test_err_if(make_congestion_controller(CongestionControl::NewReno, MSS)->name() != "newreno", "name");
+            test_err_if(make_congestion_controller(CongestionControl::Cubic, MSS)->name() != "cubic", "name");
+            test_err_if(make_congestion_controller(CongestionControl::BBR, MSS)->name() != "bbr", "name");
+        }
+
+        {
+            // NewReno：慢启动按确认字节增长，拥塞避免每个窗口增长一个 MSS，丢包后减半
+            NewRenoController reno{MSS};
+            test_err_if(reno.cwnd() != 4 * MSS, "initial window should be 4 MSS");
+            reno.on_ack({10, MSS, 3 * MSS, 10});
+            test_err_if(reno.cwnd() != 5 * MSS, "slow start should grow by the bytes acked");
+            test_err_if(reno.pacing_rate() != 2 * 5 * MSS * 1000 / 10, "pacing rate should be 2 cwnd/RTT");
+
+            reno.on_loss(20, LossSignal::FastRetransmit, 10 * MSS);
+            test_err_if(reno.ssthresh() != 5 * MSS or reno.cwnd() != 5 * MSS, "loss should halve the flight");
+            for (size_t i = 0; i < 5; i++) {
+                reno.on_ack({30, MSS, 4 * MSS, {}});
+            }
+            test_err_if(reno.cwnd() != 6 * MSS, "avoidance should grow by one MSS per window");
+
+            reno.on_loss(40, LossSignal::Timeout, 6 * MSS);
+            test_err_if(reno.ssthresh() != 3 * MSS or reno.cwnd() != MSS, "timeout should collapse the window");
+        }
+
+        {
+            // CUBIC：丢包后降到 0.7 倍，随后沿三次曲线在约 K 秒后回到丢包前的窗口
+            CubicController cubic{MSS};
+            uint64_t now = 0;
+            while (cubic.cwnd() < 100 * MSS) {
+                cubic.on_ack({now, MSS, cubic.cwnd(), 100});
+            }
+            cubic.on_loss(now, LossSignal::FastRetransmit, cubic.cwnd());
+            const size_t w_max = 100 * MSS;
+            test_err_if(cubic.cwnd() != w_max * 7 / 10 or cubic.ssthresh() != cubic.cwnd(), "beta should be 0.7");
+
+            // K = cbrt(30 / 0.4) ≈ 4.2 秒
+            for (; now < 4000; now += 100) {
+                cubic.on_ack({now, cubic.cwnd(), cubic.cwnd(), 100});
+            }
+            test_err_if(cubic.cwnd() >= w_max or cubic.cwnd() < w_max * 9 / 10, "should approach W_max at K");
+            for (; now < 8000; now += 100) {
+                cubic.on_ack({now, cubic.cwnd(), cubic.cwnd(), 100});
+            }
+            test_err_if(cubic.cwnd() <= w_max * 11 / 10, "should probe beyond W_max after K");
+        }
+
+        {
+            // BBR：以 100 字节/毫秒的速率、50 毫秒的 RTT 确认，模型应收敛到这条路径
+            BBRController bbr{MSS};
+            for (uint64_t now = 1; now <= 3000; now++) {
+                bbr.on_ack({now, 100, 5000, 50});
+            }
+            test_err_if(bbr.mode() != BBRController::Mode::ProbeBW, "should reach ProbeBW");
+            test_err_if(bbr.min_rtt() != 50u, "min RTT should be 50 ms");
+            test_err_if(bbr.bottleneck_bandwidth() < 95000 or bbr.bottleneck_bandwidth() > 105000,
+                        "bandwidth should be about 100000 B/s, got " + to_string(bbr.bottleneck_bandwidth()));
+            test_err_if(bbr.cwnd() < 9500 or bbr.cwnd() > 10500, "cwnd should be about 2 BDP");
+            test_err_if(bbr.pacing_rate() < 70000 or bbr.pacing_rate() > 130000, "pacing should track bandwidth");
+        }
+
+        {
+            // 拥塞窗口限制了 TCPSender 的在途数据，即使对端窗口很大
+            TCPSender sender{TCPConfig::DEFAULT_CAPACITY, 1000, WrappingInt32{0}, CongestionControl::NewReno};
+            sender.fill_window();
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write(string(20 * MSS, 'x'));
+            sender.fill_window();
+            // SYN 被确认时窗口增长了 1 字节
+            test_err_if(sender.congestion_controller()->cwnd() != 4 * MSS + 1, "SYN ack should grow cwnd");
+            test_err_if(sender.bytes_in_flight() != 4 * MSS + 1, "first flight should be limited by cwnd");
+        }
+
+        // 在有瓶颈和随机丢包的链路上比较各算法的有效吞吐量
+        const vector<Path> paths{{"bottleneck", 500, 25, 12500, 0}, {"lossy", 1000, 10, 50000, 0.01}};
+        const vector<CongestionControl> algorithms{
+            CongestionControl::None, CongestionControl::NewReno, CongestionControl::Cubic, CongestionControl::BBR};
+        const size_t total = 1000000;
+        for (const auto &path : paths) {
+            // 只启用超时重传时各算法的吞吐量，用于和启用快速重传与 SACK 的结果比较
+            vector<double> timer_only_goodput;
+            for (const bool recovery : {false, true}) {
+                double none_goodput = 0;
+                for (size_t i = 0; i < algorithms.size(); i++) {
+                    const auto algorithm = algorithms[i];
+                    const auto controller = make_congestion_controller(algorithm, MSS);
+                    const string name = string(controller ? controller->name() : "none") + (recovery ? "+sack" : "");
+                    const Result result = transfer(path, algorithm, recovery, total);
+                    const double goodput = double(total) / double(result.elapsed_ms);
+                    cout << left << setw(11) << path.name << setw(13) << name << right << ": " << fixed
+                         << setprecision(1) << goodput << " KB/s (" << 100 * goodput / double(path.rate)
+                         << "% of the link), " << result.drops << " segments dropped\n";
+                    if (recovery) {
+                        test_err_if(goodput <= timer_only_goodput[i],
+                                    name + " should beat timeouts alone on " + path.name);
+                    } else {
+                        timer_only_goodput.push_back(goodput);
+                    }
+                    if (algorithm == CongestionControl::None) {
+                        none_goodput = goodput;
+                        continue;
+                    }
+                    test_err_if(not result.complete, name + " did not finish on " + path.name);
+                    // 随机丢包并不意味着拥塞，在这样的路径上基于丢包的算法不一定比不控制更快
+                    test_err_if(path.loss == 0 and goodput <= none_goodput,
+                                name + " should beat an uncontrolled sender on " + path.name);
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,161 @@
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+//! 非阻塞的管道
+struct Pipe {
+    FileDescriptor in;   //!< 读端
+    FileDescriptor out;  //!< 写端
+};
+
+Pipe make_pipe() {
+    int fds[2];
+    SystemCall("pipe2", ::pipe2(fds, O_NONBLOCK | O_CLOEXEC));
+    return {FileDescriptor{fds[0]}, FileDescriptor{fds[1]}};
+}
+
+string backend_name(const EventLoop::Backend backend) {
+    switch (backend) {
+        case EventLoop::Backend::Poll:
+            return "poll";
+        case EventLoop::Backend::Epoll:
+            return "epoll";
+        case EventLoop::Backend::EpollEdge:
+            return "epoll (edge-triggered)";
+        case EventLoop::Backend::IoUring:
+            return "io_uring";
+    }
+    return "";
+}
+
+void check_backend(const EventLoop::Backend backend) {
+    const string name = backend_name(backend) + ": ";
+    {
+        // 原有的 add_rule：由 interest 回调决定是否等待，读到 EOF 后取消
+        Pipe p = make_pipe();
+        EventLoop loop{backend};
+        bool wanted = true;
+        string received;
+        bool canceled = false;
+        loop.add_rule(
+            p.in, Direction::In, [&] { received += p.in.read(); }, [&] { return wanted; }, [&] { canceled = true; });
+        p.out.write("hello");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success or received != "hello",
+                    name + "readable pipe should run the callback");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, name + "drained pipe should time out");
+        wanted = false;
+        p.out.write("later");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, name + "no interest should exit");
+        wanted = true;
+        p.out.close();
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success or received != "hellolater",
+                    name + "interest should come back");
+        loop.wait_next_event(0);
+        test_err_if(not canceled, name + "EOF should cancel the rule");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, name + "no rules should exit");
+    }
+
+    {
+        // 显式规则：disable 后不再触发，enable 后恢复
+        Pipe p = make_pipe();
+        EventLoop loop{backend};
+        size_t writes = 0;
+        size_t reads = 0;
+        const auto writer = loop.add_explicit_rule(p.out, Direction::Out, [&] {
+            p.out.write("x");
+            writes++;
+        });
+        const auto reader = loop.add_explicit_rule(p.in, Direction::In, [&] {
+            p.in.read();
+            reads++;
+        });
+        loop.disable(reader);
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success or writes != 1 or reads != 0,
+                    name + "only the writer should run");
+        loop.disable(writer);
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, name + "all rules disabled should exit");
+        loop.enable(reader);
+        loop.enable(reader);
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success or writes != 1 or reads != 1,
+                    name + "only the reader should run");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, name + "empty pipe should time out");
+    }
+
+    {
+        // 每次只读一个字节：水平触发时剩余数据继续触发，边沿触发时只在新数据到达时触发
+        Pipe p = make_pipe();
+        EventLoop loop{backend};
+        string received;
+        loop.add_explicit_rule(p.in, Direction::In, [&] { received += p.in.read(1); });
+        p.out.write("ab");
+        loop.wait_next_event(0);
+        const auto second = loop.wait_next_event(0);
+        if (backend == EventLoop::Backend::EpollEdge) {
+            test_err_if(second != EventLoop::Result::Timeout or received != "a", name + "no new edge, no event");
+            p.out.write("c");
+            test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success or received != "ab",
+                        name + "new data should fire again");
+        } else {
+            test_err_if(second != EventLoop::Result::Success or received != "ab", name + "remaining data should fire");
+        }
+    }
+
+    {
+        // 同一 fd 号上的两个方向；fd 关闭后其规则被取消，fd 号被重新使用时不受旧规则影响
+        EventLoop loop{backend};
+        size_t writes = 0;
+        size_t canceled = 0;
+        {
+            Pipe p = make_pipe();
+            loop.add_explicit_rule(
+                p.in, Direction::In, [&] { p.in.read(); }, [&] { canceled++; });
+            loop.add_explicit_rule(
+                p.out,
+                Direction::Out,
+                [&] {
+                    p.out.write("y");
+                    writes++;
+                },
+                [&] { canceled++; });
+            loop.wait_next_event(0);
+            test_err_if(writes != 1, name + "writer should run");
+            p.in.close();
+            p.out.close();
+        }
+
+        Pipe p = make_pipe();
+        string received;
+        loop.add_explicit_rule(p.in, Direction::In, [&] { received += p.in.read(); });
+        loop.add_explicit_rule(p.out, Direction::Out, [&] { p.out.write("again"); });
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, name + "new pipe should be writable");
+        test_err_if(canceled != 2, name + "rules of the closed pipe should have been canceled");
+        test_err_if(writes != 1, name + "the old writer should not run again");
+        loop.wait_next_event(0);
+        test_err_if(received.substr(0, 5) != "again", name + "a reused fd number should be watched again");
+    }
+}
+}  // namespace
+
+int main() {
+    try {
+        check_backend(EventLoop::Backend::Poll);
+        check_backend(EventLoop::Backend::Epoll);
+        check_backend(EventLoop::Backend::EpollEdge);
+        check_backend(EventLoop::Backend::IoUring);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
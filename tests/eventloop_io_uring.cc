@@ -0,0 +1,159 @@
+#include "address.hh"
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "io_uring.hh"
+#include "socket.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <set>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace {
+//! 等待直到 done() 为真，最多等待 1000 次
+template <typename F>
+void run_until(EventLoop &loop, F &&done) {
+    for (size_t i = 0; i < 1000 and not done(); i++) {
+        loop.wait_next_event(100);
+    }
+}
+
+//! 在一秒内是否有数据报到达 `sock`
+bool datagram_arrives(const UDPSocket &sock) {
+    pollfd pfd{sock.fd_num(), POLLIN, 0};
+    return SystemCall("poll", ::poll(&pfd, 1, 1000)) == 1;
+}
+}  // namespace
+
+int main() {
+    try {
+        if (not IoUring::available()) {
+            // 不支持 io_uring 时退回 epoll，且不接管 fd 的读写
+            EventLoop loop{EventLoop::Backend::IoUring};
+            UDPSocket sock;
+            test_err_if(loop.backend() != EventLoop::Backend::Epoll, "should fall back to epoll");
+            test_err_if(loop.attach_to_ring(sock), "nothing to attach to without io_uring");
+            cerr << "io_uring is unavailable; checked the fallback only\n";
+            return EXIT_SUCCESS;
+        }
+
+        {
+            // UDP：数据报由 ring 读入，携带来源地址；写出的数据报在下一次等待时一并提交
+            UDPSocket server;
+            server.bind(Address{"127.0.0.1", 0});
+            UDPSocket client;
+            client.bind(Address{"127.0.0.1", 0});
+
+            EventLoop loop{EventLoop::Backend::IoUring};
+            test_err_if(loop.backend() != EventLoop::Backend::IoUring, "io_uring should be used");
+            test_err_if(not loop.attach_to_ring(server), "server socket should be attached");
+
+            set<string> received;
+            size_t replies = 0;
+            loop.add_rule(server, Direction::In, [&] {
+                auto datagram = server.recv();
+                test_err_if(datagram.source_address != client.local_address(), "wrong source address");
+                received.insert(datagram.payload);
+                server.sendto(datagram.source_address, "re:" + datagram.payload);
+                replies++;
+            });
+
+            constexpr size_t COUNT = 50;
+            for (size_t i = 0; i < COUNT; i++) {
+                client.sendto(server.local_address(), to_string(i));
+            }
+            run_until(loop, [&] { return received.size() == COUNT; });
+            test_err_if(received.size() != COUNT, "every datagram should be received");
+            loop.wait_next_event(0);  // submits the last replies
+
+            set<string> echoed;
+            for (size_t i = 0; i < replies; i++) {
+                echoed.insert(client.recv().payload);
+            }
+            test_err_if(echoed.size() != COUNT or echoed.count("re:7") != 1, "every reply should be sent");
+        }
+
+        {
+            // 最后一次写出后不再有感兴趣的规则：循环退出前仍要提交排队的写（例如 abort 时的 RST）
+            UDPSocket sender;
+            sender.bind(Address{"127.0.0.1", 0});
+            UDPSocket receiver;
+            receiver.bind(Address{"127.0.0.1", 0});
+            EventLoop loop{EventLoop::Backend::IoUring};
+            test_err_if(not loop.attach_to_ring(sender), "sender should be attached");
+            bool sent = false;
+            loop.add_rule(
+                sender,
+                Direction::Out,
+                [&] {
+                    sender.sendto(receiver.local_address(), "last words");
+                    sent = true;
+                },
+                [&] { return not sent; });
+            test_err_if(loop.wait_next_event(100) != EventLoop::Result::Success, "the write rule should run");
+            test_err_if(loop.wait_next_event(100) != EventLoop::Result::Exit, "nothing is left to do");
+            test_err_if(not datagram_arrives(receiver), "the queued write should be submitted before exiting");
+            test_err_if(receiver.recv().payload != "last words", "wrong datagram");
+        }
+
+        {
+            // 没有再等待就销毁：ring 的拥有者在销毁时提交排队的写
+            UDPSocket receiver;
+            receiver.bind(Address{"127.0.0.1", 0});
+            {
+                UDPSocket sender;
+                EventLoop loop{EventLoop::Backend::IoUring};
+                test_err_if(not loop.attach_to_ring(sender), "sender should be attached");
+                sender.sendto(receiver.local_address(), "goodbye");
+            }
+            test_err_if(not datagram_arrives(receiver), "the queued write should be submitted on teardown");
+            test_err_if(receiver.recv().payload != "goodbye", "wrong datagram");
+        }
+
+        {
+            // 非套接字的 fd（如 TUN）使用注册的缓冲区读取；读到 EOF 后取消规则
+            int fds[2];
+            SystemCall("pipe2", ::pipe2(fds, O_CLOEXEC));
+            FileDescriptor in{fds[0]};
+            FileDescriptor out{fds[1]};
+            EventLoop loop{EventLoop::Backend::IoUring};
+            test_err_if(not loop.attach_to_ring(in), "pipe should be attached");
+            string received;
+            bool canceled = false;
+            loop.add_rule(
+                in, Direction::In, [&] { received += in.read(); }, [] { return true; }, [&] { canceled = true; });
+            out.write("hello");
+            run_until(loop, [&] { return received == "hello"; });
+            test_err_if(received != "hello", "pipe data should arrive");
+            out.close();
+            run_until(loop, [&] { return canceled; });
+            test_err_if(not canceled, "EOF should cancel the rule");
+            test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, "no rules should exit");
+        }
+
+        {
+            // 每个 ring 最多接管 MAX_ATTACHED 个 fd，关闭后归还
+            EventLoop loop{EventLoop::Backend::IoUring};
+            vector<UDPSocket> socks(IoUringDatagrams::MAX_ATTACHED + 1);
+            for (size_t i = 0; i < IoUringDatagrams::MAX_ATTACHED; i++) {
+                test_err_if(not loop.attach_to_ring(socks[i]), "socket " + to_string(i) + " should be attached");
+            }
+            test_err_if(loop.attach_to_ring(socks.back()), "the ring should be full");
+            socks.front().close();
+            test_err_if(not loop.attach_to_ring(socks.back()), "a closed socket should give back its slots");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+#include "address.hh"
+#include "buffer.hh"
+#include "fd_adapter.hh"
+#include "file_descriptor.hh"
+#include "socket.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace {
+//! 全局 operator new 被调用的次数
+size_t allocations = 0;
+}  // namespace
+
+// 计数的分配器：替换全局的 operator new，统计堆分配次数
+void *operator new(size_t size) {
+    allocations++;
+    if (void *p = malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+namespace {
+//! 一对管道的两端
+struct Pipe {
+    FileDescriptor in;
+    FileDescriptor out;
+};
+
+//! 以 TUN/TAP 适配器的方式读取报文
+struct PacketReader : public FdAdapterBase {
+    Buffer read(FileDescriptor &fd) { return read_packet(fd); }
+};
+
+Pipe make_pipe() {
+    int fds[2];
+    SystemCall("pipe", ::pipe(fds));
+    return {FileDescriptor{fds[0]}, FileDescriptor{fds[1]}};
+}
+}  // namespace
+
+int main() {
+    try {
+        {
+            // 读入调用者提供的缓冲区，不清零多出来的部分
+            Pipe p = make_pipe();
+            p.out.write("hello");
+            char buffer[16];
+            buffer[5] = '!';
+            test_err_if(p.in.read(buffer, sizeof(buffer)) != 5 or string(buffer, 6) != "hello!",
+                        "read should fill only what it read");
+
+            // readv 依次填满每个缓冲区
+            p.out.write("abcdefgh");
+            char first[3];
+            char second[8];
+            const vector<iovec> buffers{{first, sizeof(first)}, {second, sizeof(second)}};
+            test_err_if(p.in.readv(buffers) != 8, "readv should read everything");
+            test_err_if(string(first, 3) != "abc" or string(second, 5) != "defgh", "readv scattered wrongly");
+
+            p.out.close();
+            test_err_if(p.in.read(buffer, sizeof(buffer)) != 0 or not p.in.eof(), "read should notice EOF");
+            test_err_if(p.in.read_count() != 3, "each read should be counted");
+        }
+
+        {
+            // 从缓冲池读出的 Buffer 依次排在同一个 slab 中，空闲的 slab 会被重用
+            Pipe p = make_pipe();
+            BufferPool pool{1024};
+            p.out.write("first");
+            Buffer a = p.in.read(pool);
+            p.out.write("second");
+            Buffer b = p.in.read(pool, 3);
+            test_err_if(a.str() != "first" or b.str() != "sec", "wrong contents");
+            test_err_if(b.str().data() != a.str().data() + 5, "reads should share a slab");
+
+            const char *const slab = a.str().data();
+            b = Buffer{};
+            bool reused = false;
+            for (size_t i = 0; i < 100; i++) {
+                p.out.write(string(100, 'x'));
+                a = p.in.read(pool);
+                reused |= i > 10 and a.str().data() == slab;
+            }
+            test_err_if(not reused, "the idle slab should have been reused");
+            p.out.close();
+            test_err_if(p.in.read(pool).size() != 0 or not p.in.eof(), "pooled read should notice EOF");
+        }
+
+        {
+            // TUN/TAP 适配器的读取方式：每次读一个报文，只预留最大报文的空间，相邻的报文共用一个 slab
+            int fds[2];
+            SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_DGRAM, 0, fds));
+            FileDescriptor device{fds[0]};
+            FileDescriptor peer{fds[1]};
+            PacketReader reader;
+            const string packet(1500, 'p');
+            vector<Buffer> packets;
+            for (size_t i = 0; i < 100; i++) {
+                peer.write(packet);
+                packets.push_back(reader.read(device));
+                test_err_if(packets.back().str() != packet, "wrong packet " + to_string(i));
+            }
+            for (size_t i = 1; i < packets.size(); i++) {
+                test_err_if(packets[i].str().data() != packets[i - 1].str().data() + packet.size(),
+                            "packet " + to_string(i) + " should follow the previous one in the same slab");
+            }
+        }
+
+        {
+            // UDP 适配器接收报文时不分配内存
+            UDPSocket peer;
+            peer.bind(Address{"127.0.0.1", 0});
+            UDPSocket sock;
+            sock.bind(Address{"127.0.0.1", 0});
+            FdAdapterConfig cfg;
+            cfg.source = sock.local_address();
+            cfg.destination = peer.local_address();
+            TCPOverUDPSocketAdapter adapter{move(sock)};
+            adapter.config_mut() = cfg;
+
+            TCPSegment seg;
+            seg.header().sport = cfg.destination.port();
+            seg.header().dport = cfg.source.port();
+            seg.header().ack = true;
+            seg.payload() = Buffer{string(1000, 'y')};
+            const string wire = seg.serialize(0).concatenate();
+
+            size_t received = 0;
+            const auto exchange = [&](const size_t count) {
+                for (size_t i = 0; i < count; i++) {
+                    peer.sendto(cfg.source, wire);
+                }
+                for (size_t i = 0; i < count; i++) {
+                    const auto got = adapter.read();
+                    received += got.has_value() and got->payload().size() == 1000;
+                }
+            };
+            // 每批只发 20 个，以免超出 socket 的接收缓冲区
+            exchange(20);
+            for (size_t i = 0; i < 20; i++) {
+                peer.sendto(cfg.source, wire);
+            }
+            // 只统计接收：报文已经在 socket 的接收缓冲区中
+            const size_t before = allocations;
+            for (size_t i = 0; i < 20; i++) {
+                received += adapter.read().has_value();
+            }
+            const size_t allocated = allocations - before;
+            test_err_if(received != 40, "every segment should have been received");
+            test_err_if(allocated != 0, "receiving should not allocate: " + to_string(allocated));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "test_err_if.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // 乱序到达的 Buffer 以分片形式暂存，装配后仍与原始负载共享内存
+            StreamReassembler reassembler{16, ByteStream::Storage::Chunks};
+            Buffer late{string("defg")};
+            Buffer early{string("abc")};
+
+            reassembler.push_substring(late, 3, false);
+            test_err_if(reassembler.unassembled_bytes() != 4, "out-of-order Buffer should be stored");
+            reassembler.push_substring(early, 0, false);
+            test_err_if(reassembler.unassembled_bytes() != 0, "stored Buffer should be assembled");
+
+            const auto [first, second] = reassembler.stream_out().peek_spans(7);
+            test_err_if(first.data() != early.str().data(), "in-order Buffer should not be copied");
+            test_err_if(second.data() != late.str().data(), "stored Buffer should not be copied");
+            test_err_if(reassembler.stream_out().read(7) != "abcdefg", "wrong bytes assembled");
+        }
+
+        {
+            // 重叠的分片通过调整视图截断，重复的字节只计一次
+            StreamReassembler reassembler{16, ByteStream::Storage::Chunks};
+            reassembler.push_substring(Buffer{string("efgh")}, 4, false);
+            reassembler.push_substring(Buffer{string("cdef")}, 2, false);
+            test_err_if(reassembler.unassembled_bytes() != 6, "overlap should be counted once");
+            reassembler.push_substring(Buffer{string("ghijkl")}, 6, true);
+            test_err_if(reassembler.unassembled_bytes() != 10, "overlapping suffix should be trimmed");
+            reassembler.push_substring(Buffer{string("bcdefghijk")}, 1, false);
+            test_err_if(reassembler.unassembled_bytes() != 11, "covered chunks should be replaced");
+            reassembler.push_substring(Buffer{string("fg")}, 5, false);
+            test_err_if(reassembler.unassembled_bytes() != 11, "duplicate chunk should be ignored");
+
+            reassembler.push_substring(Buffer{string("ab")}, 0, false);
+            test_err_if(not reassembler.empty(), "everything should be assembled");
+            test_err_if(reassembler.stream_out().read(12) != "abcdefghijkl", "wrong bytes assembled");
+            test_err_if(not reassembler.stream_out().eof(), "stream should have ended");
+        }
+
+        {
+            // std::string 输入在 Chunks 模式下同样可以乱序装配
+            StreamReassembler reassembler{4, ByteStream::Storage::Chunks};
+            reassembler.push_substring(string("cdef"), 2, false);
+            test_err_if(reassembler.unassembled_bytes() != 2, "bytes beyond the capacity should be dropped");
+            reassembler.push_substring(string("ab"), 0, false);
+            test_err_if(reassembler.stream_out().read(4) != "abcd", "wrong bytes assembled");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
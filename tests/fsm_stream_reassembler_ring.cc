@@ -0,0 +1,74 @@
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // 乱序数据跨越暂存区末尾
+            ReassemblerTestHarness test{8};
+
+            test.execute(SubmitSegment{"abcde", 0});
+            test.execute(BytesAvailable("abcde"));
+
+            test.execute(SubmitSegment{"jkl", 9});
+            test.execute(BytesAssembled(5));
+            test.execute(UnassembledBytes(3));
+
+            test.execute(SubmitSegment{"fghi", 5});
+            test.execute(BytesAssembled(12));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("fghijkl"));
+        }
+
+        {
+            // 相邻与重叠的区间应合并，且重复的字节只计一次
+            ReassemblerTestHarness test{8};
+
+            test.execute(SubmitSegment{"e", 4});
+            test.execute(SubmitSegment{"c", 2});
+            test.execute(SubmitSegment{"d", 3});
+            test.execute(UnassembledBytes(3));
+
+            test.execute(SubmitSegment{"bcdefg", 1});
+            test.execute(UnassembledBytes(6));
+            test.execute(BytesAssembled(0));
+
+            test.execute(SubmitSegment{"fghijk", 5}.with_eof(true));
+            test.execute(UnassembledBytes(7));
+
+            test.execute(SubmitSegment{"a", 0});
+            test.execute(BytesAssembled(8));
+            test.execute(UnassembledBytes(0));
+            test.execute(NotAtEof{});
+            test.execute(BytesAvailable("abcdefgh"));
+
+            test.execute(SubmitSegment{"ijk", 8}.with_eof(true));
+            test.execute(BytesAvailable("ijk"));
+            test.execute(AtEof{});
+        }
+
+        {
+            // 按序写入后应清理被覆盖的暂存区间
+            ReassemblerTestHarness test{16};
+
+            test.execute(SubmitSegment{"cd", 2});
+            test.execute(SubmitSegment{"gh", 6});
+            test.execute(SubmitSegment{"abcdef", 0});
+            test.execute(BytesAssembled(8));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcdefgh"));
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+#include "ipv4_datagram.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+namespace {
+//! 首部（含选项）的校验和正确时，对整个首部求和的结果为零
+bool header_checksum_ok(const string &wire, const size_t header_length) {
+    InternetChecksum check;
+    check.add({wire.data(), header_length});
+    return check.value() == 0;
+}
+}  // namespace
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        for (unsigned trial = 0; trial < 2000; trial++) {
+            InternetDatagram original;
+            original.header().id = rd();
+            original.header().src = rd();
+            original.header().dst = rd();
+            original.header().proto = rd();
+            original.header().ttl = 2 + rd() % 254;
+            const string payload(rd() % 100, 'x');
+            original.header().len = IPv4Header::LENGTH + payload.size();
+            original.payload() = BufferList{string(payload)};
+
+            InternetDatagram forwarded;
+            test_err_if(forwarded.parse(original.serialize().concatenate()) != ParseResult::NoError, "parse failed");
+            while (as_const(forwarded).header().ttl > 1) {
+                // header() 会放弃缓存的首部，这里只通过 const 引用读取
+                const uint8_t ttl = as_const(forwarded).header().ttl;
+                forwarded.decrement_ttl();
+                test_err_if(as_const(forwarded).header().ttl != ttl - 1, "TTL was not decremented");
+
+                const string wire = forwarded.serialize().concatenate();
+                test_err_if(uint8_t(wire[8]) != ttl - 1, "TTL byte was not patched");
+                test_err_if(not header_checksum_ok(wire, IPv4Header::LENGTH), "incremental checksum is wrong");
+
+                // 与完整重新计算的结果一致
+                InternetDatagram rebuilt = forwarded;
+                rebuilt.header().ttl = ttl - 1;
+                test_err_if(rebuilt.serialize().concatenate() != wire, "patched header differs from a rebuilt one");
+                if (rd() % 8 == 0) {
+                    break;
+                }
+            }
+        }
+
+        {
+            // 带选项的首部也应被原样保留并正确更新
+            string wire(24, 0);
+            wire[0] = 0x46;  // version 4, hlen 6
+            wire[3] = 24;
+            wire[8] = 64;
+            wire[9] = 6;
+            wire[20] = 1;  // NOP options
+            wire[21] = 1;
+            wire[22] = 1;
+            wire[23] = 0;
+            InternetChecksum check;
+            check.add(wire);
+            const uint16_t cksum = check.value();
+            wire[10] = char(cksum >> 8);
+            wire[11] = char(cksum & 0xff);
+
+            InternetDatagram dgram;
+            const Buffer received{string(wire)};
+            test_err_if(dgram.parse(received) != ParseResult::NoError, "parse with options failed");
+            const InternetDatagram copy = dgram;
+            dgram.decrement_ttl();
+            const string out = dgram.serialize().concatenate();
+            test_err_if(out.size() != 24 or out.substr(20) != wire.substr(20), "options were not kept");
+            test_err_if(not header_checksum_ok(out, 24), "checksum over options is wrong");
+
+            // 收到的字节和数据报的副本都不受影响
+            test_err_if(received.str() != wire, "the received bytes should not be changed");
+            test_err_if(copy.serialize().concatenate() != wire, "a copy of the datagram should keep its TTL");
+
+            // 通过 header() 修改字段后，序列化时重新生成首部
+            InternetDatagram edited;
+            test_err_if(edited.parse(Buffer{string(wire)}) != ParseResult::NoError, "parse with options failed");
+            edited.header().dst = 99;
+            InternetDatagram reparsed;
+            test_err_if(reparsed.parse(edited.serialize().concatenate()) != ParseResult::NoError, "reparse failed");
+            test_err_if(reparsed.header().dst != 99, "an edited header should be rebuilt");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#include "ring_queue.hh"
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "tcp_test_helpers.hh"
+#include "test_err_if.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // 环形队列：绕回与扩容后顺序不变
+            RingQueue<int> ring{4};
+            for (int i = 0; i < 3; i++) {
+                ring.push_back(i);
+            }
+            ring.pop_front();
+            ring.pop_front();
+            for (int i = 3; i < 10; i++) {
+                ring.push_back(i);
+            }
+            test_err_if(ring.size() != 8 or ring.front() != 2 or ring.back() != 9, "wrong ends after growing");
+            for (size_t i = 0; i < ring.size(); i++) {
+                test_err_if(ring[i] != int(i + 2), "elements out of order");
+            }
+
+            // 出队的元素立即释放它持有的资源
+            RingQueue<shared_ptr<int>> owners{2};
+            const auto value = make_shared<int>(1);
+            owners.push_back(value);
+            owners.pop_front();
+            test_err_if(value.use_count() != 1, "popped element should be released");
+        }
+
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+        for (const bool trim : {false, true}) {
+            // 部分确认减少在途数据；超时后重传的负载与发送时共享存储
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.trim_retransmissions = trim;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            drain(sender);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write(string(3 * mss, 'x'));
+            sender.fill_window();
+            const auto sent = drain(sender);
+            test_err_if(sent.size() != 3, "three segments should be sent");
+
+            sender.ack_received(WrappingInt32{1 + 400}, 60000);
+            test_err_if(sender.bytes_in_flight() != 3 * mss - 400, "partial ACK should shrink the flight");
+            sender.tick(cfg.rt_timeout);
+            const auto resent = drain(sender);
+            test_err_if(resent.size() != 1, "timeout should retransmit one segment");
+            const TCPSegment &seg = resent[0];
+
+            const size_t offset = trim ? 400 : 0;
+            test_err_if(seg.header().seqno != WrappingInt32{uint32_t(1 + offset)}, "wrong retransmitted seqno");
+            test_err_if(seg.payload().size() != mss - offset, "wrong retransmitted length");
+            test_err_if(seg.payload().str().data() != sent[0].payload().str().data() + offset,
+                        "retransmission should not copy the payload");
+
+            TCPSegment parsed;
+            test_err_if(parsed.parse(Buffer{seg.serialize().concatenate()}) != ParseResult::NoError,
+                        "retransmitted segment should have a valid checksum");
+
+            sender.ack_received(WrappingInt32{1 + 3 * mss}, 60000);
+            test_err_if(sender.bytes_in_flight() != 0, "everything should be acknowledged");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
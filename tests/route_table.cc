@@ -0,0 +1,76 @@
+#include "route_table.hh"
+#include "test_err_if.hh"
+
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace {
+struct Prefix {
+    uint32_t prefix;
+    uint8_t length;
+};
+
+bool matches(const Prefix &p, const uint32_t address) {
+    return p.length == 0 or (address >> (32 - p.length)) == (p.prefix >> (32 - p.length));
+}
+
+//! 线性扫描得到的最长前缀匹配结果（相同前缀保留先加入的）
+optional<size_t> reference_lookup(const vector<Prefix> &prefixes, const uint32_t address) {
+    optional<size_t> best;
+    for (size_t i = 0; i < prefixes.size(); i++) {
+        if (matches(prefixes[i], address) and (not best.has_value() or prefixes[i].length > prefixes[*best].length)) {
+            best = i;
+        }
+    }
+    return best;
+}
+}  // namespace
+
+int main() {
+    try {
+        {
+            // 短前缀在长前缀之后加入时，不能覆盖已经下推的更长前缀
+            RouteTable table;
+            test_err_if(table.lookup(0x0a000001).has_value(), "empty table should match nothing");
+            table.insert(0x0a010200, 24, 0);
+            table.insert(0x0a010203, 32, 1);
+            table.insert(0x0a000000, 8, 2);
+            table.insert(0, 0, 3);
+            table.insert(0x0a0102ff, 24, 4);
+            test_err_if(table.lookup(0x0a010203) != 1, "/32 should win");
+            test_err_if(table.lookup(0x0a010204) != 0, "/24 should win, and keep the first of two equal prefixes");
+            test_err_if(table.lookup(0x0a020304) != 2, "/8 should win");
+            test_err_if(table.lookup(0x0b000000) != 3, "default route should match everything else");
+        }
+
+        {
+            // 与线性扫描的结果逐一比较
+            mt19937 rng{2024};
+            uniform_int_distribution<uint32_t> address;
+            uniform_int_distribution<int> length{0, 32};
+            vector<Prefix> prefixes;
+            RouteTable table;
+            for (size_t i = 0; i < 2000; i++) {
+                // 让前缀集中在少数几个 /8 内，以产生大量嵌套
+                const uint32_t base = (address(rng) & 0x0303ffff) | 0x0a000000;
+                const uint8_t len = length(rng);
+                prefixes.push_back({len == 0 ? 0 : base & (~uint32_t(0) << (32 - len)), len});
+                table.insert(base, len, i);
+            }
+            for (size_t i = 0; i < 20000; i++) {
+                const uint32_t probe = i % 2 ? address(rng) : (address(rng) & 0x0303ffff) | 0x0a000000;
+                test_err_if(table.lookup(probe) != reference_lookup(prefixes, probe), "lookup disagrees with a scan");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
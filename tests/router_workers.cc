@@ -0,0 +1,144 @@
+#include "arp_message.hh"
+#include "router.hh"
+#include "test_err_if.hh"
+
+#include <exception>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+constexpr size_t INTERFACES = 6;
+constexpr size_t DATAGRAMS_PER_INTERFACE = 3000;
+
+EthernetAddress router_ethernet(const size_t i) { return {0x02, 0, 0, 0, 1, uint8_t(i)}; }
+EthernetAddress next_hop_ethernet(const size_t i) { return {0x02, 0, 0, 0, 2, uint8_t(i)}; }
+uint32_t router_ip(const size_t i) { return 0x0a000001 | uint32_t(i) << 8; }    // 10.0.i.1
+uint32_t next_hop_ip(const size_t i) { return 0x0a000002 | uint32_t(i) << 8; }  // 10.0.i.2
+uint32_t network_ip(const size_t i) { return 0x0b000000 | uint32_t(i) << 16; }  // 11.i.0.0/16
+
+//! 让接口 i 通过 ARP 回复学到下一跳的以太网地址
+EthernetFrame arp_reply(const size_t i) {
+    ARPMessage reply;
+    reply.opcode = ARPMessage::OPCODE_REPLY;
+    reply.sender_ethernet_address = next_hop_ethernet(i);
+    reply.sender_ip_address = next_hop_ip(i);
+    reply.target_ethernet_address = router_ethernet(i);
+    reply.target_ip_address = router_ip(i);
+
+    EthernetFrame frame;
+    frame.header().dst = router_ethernet(i);
+    frame.header().src = next_hop_ethernet(i);
+    frame.header().type = EthernetHeader::TYPE_ARP;
+    frame.payload() = reply.serialize();
+    return frame;
+}
+
+//! 数据报的负载记录来源接口和序号，用于检查每个来源的顺序
+InternetDatagram make_datagram(const uint32_t dst, const uint8_t ttl, const size_t source, const size_t seq) {
+    InternetDatagram dgram;
+    dgram.header().src = router_ip(source);
+    dgram.header().dst = dst;
+    dgram.header().ttl = ttl;
+    const string payload = to_string(source) + ":" + to_string(seq);
+    dgram.header().len = IPv4Header::LENGTH + payload.size();
+    dgram.payload() = BufferList{string(payload)};
+    return dgram;
+}
+
+//! 用给定的配置转发同一批数据报，检查每个数据报都被送到正确的接口，且同一来源的顺序不变
+void check_forwarding(const RouterConfig &cfg) {
+    auto *const saved_cerr = cerr.rdbuf(nullptr);
+    Router router{cfg};
+    for (size_t i = 0; i < INTERFACES; i++) {
+        router.add_interface(AsyncNetworkInterface{router_ethernet(i), Address::from_ipv4_numeric(router_ip(i))});
+        router.add_route(network_ip(i), 16, Address::from_ipv4_numeric(next_hop_ip(i)), i);
+    }
+    cerr.rdbuf(saved_cerr);
+    cerr.clear();
+
+    for (size_t i = 0; i < INTERFACES; i++) {
+        router.interface(i).recv_frame(arp_reply(i));
+    }
+
+    // 同一个 Router 多次转发：线程和环在各次 route() 之间复用，中间没有数据报时也可以调用
+    constexpr size_t ROUNDS = 3;
+    size_t expected_sent = 0;
+    size_t expected_dropped = 0;
+    size_t sent = 0;
+    for (size_t round = 0; round < ROUNDS; round++) {
+        for (size_t source = 0; source < INTERFACES; source++) {
+            for (size_t seq = 0; seq < DATAGRAMS_PER_INTERFACE; seq++) {
+                const size_t target = (source + seq) % INTERFACES;
+                uint32_t dst = network_ip(target) | uint32_t(seq & 0xffff);
+                uint8_t ttl = 64;
+                if (seq % 97 == 0) {
+                    ttl = 1;  // TTL 减少后为零
+                    expected_dropped++;
+                } else if (seq % 89 == 0) {
+                    dst = 0x0c000000;  // 没有匹配的路由
+                    expected_dropped++;
+                } else {
+                    expected_sent++;
+                }
+                router.interface(source).datagrams_out().push(make_datagram(dst, ttl, source, seq));
+            }
+        }
+
+        router.route();
+
+        for (size_t i = 0; i < INTERFACES; i++) {
+            map<size_t, size_t> next_seq;
+            auto &frames = router.interface(i).frames_out();
+            for (; not frames.empty(); frames.pop(), sent++) {
+                const EthernetFrame &frame = frames.front();
+                test_err_if(frame.header().dst != next_hop_ethernet(i), "frame sent to the wrong next hop");
+                InternetDatagram dgram;
+                test_err_if(dgram.parse(frame.payload().concatenate()) != ParseResult::NoError, "bad datagram");
+                test_err_if((dgram.header().dst >> 16) != (network_ip(i) >> 16),
+                            "datagram sent on the wrong interface");
+                test_err_if(dgram.header().ttl != 63, "TTL was not decremented once");
+
+                const string payload = dgram.payload().concatenate();
+                const size_t colon = payload.find(':');
+                const size_t source = stoul(payload.substr(0, colon));
+                const size_t seq = stoul(payload.substr(colon + 1));
+                test_err_if(seq < next_seq[source], "datagrams from one interface were reordered");
+                next_seq[source] = seq + 1;
+            }
+        }
+        test_err_if(sent != expected_sent, "wrong number of datagrams forwarded");
+        router.route();
+    }
+
+    RouterWorkerStats total;
+    for (const auto &stats : router.worker_stats()) {
+        total.datagrams_in += stats.datagrams_in;
+        total.datagrams_sent += stats.datagrams_sent;
+        total.datagrams_dropped += stats.datagrams_dropped;
+    }
+    test_err_if(router.worker_stats().size() != cfg.workers, "one stats entry per worker expected");
+    test_err_if(total.datagrams_in != ROUNDS * INTERFACES * DATAGRAMS_PER_INTERFACE, "wrong datagrams_in count");
+    test_err_if(total.datagrams_sent != expected_sent, "wrong datagrams_sent count");
+    test_err_if(total.datagrams_dropped != expected_dropped, "wrong datagrams_dropped count");
+}
+}  // namespace
+
+int main() {
+    try {
+        check_forwarding(RouterConfig{});
+        // 环很小时，线程之间必须一边等待一边转发交给自己的数据报，否则会死锁
+        check_forwarding(RouterConfig{3, 16, 4});
+        check_forwarding(RouterConfig{4, 7, 64});
+        // 线程数多于接口数时，多余的线程不参与转发
+        check_forwarding(RouterConfig{8, 32, 1024});
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
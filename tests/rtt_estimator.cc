@@ -0,0 +1,104 @@
+#include "rtt_estimator.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_sender.hh"
+#include "tcp_test_helpers.hh"
+#include "test_err_if.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // RFC 6298 的计算：第一个样本与之后的样本
+            RTTEstimator rtt{1000, 200, 60000};
+            test_err_if(rtt.rto() != 1000 or rtt.srtt().has_value(), "initial RTO should be used before samples");
+            rtt.add_sample(100);
+            test_err_if(rtt.srtt() != 100.0 or rtt.rttvar() != 50.0, "first sample should set SRTT and RTTVAR");
+            test_err_if(rtt.rto() != 300, "RTO should be SRTT + 4 RTTVAR");
+            rtt.add_sample(200);
+            test_err_if(rtt.srtt() != 112.5 or rtt.rttvar() != 62.5, "later samples should be smoothed");
+            test_err_if(rtt.rto() != 363 or rtt.samples() != 2, "RTO should round up");
+        }
+
+        {
+            // 计算出的 RTO 被限制在 [min, max] 之间
+            RTTEstimator fast{1000, 200, 60000};
+            fast.add_sample(10);
+            test_err_if(fast.rto() != 200, "RTO should not go below the minimum");
+            RTTEstimator slow{1000, 200, 5000};
+            slow.add_sample(4000);
+            test_err_if(slow.rto() != 5000 or slow.clamp(100000) != 5000, "RTO should not exceed the maximum");
+        }
+
+        {
+            // 自适应 RTO：超时按测得的 RTT 计算，退避后的超时在没有新样本前保留（Karn 算法）
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.adaptive_rto = true;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            test_err_if(drain(sender).size() != 1, "SYN should be sent");
+            sender.tick(20);
+            sender.ack_received(WrappingInt32{1}, 1000);
+            test_err_if(sender.stats().srtt_ms != 20.0 or sender.stats().rto_ms != 200, "RTO should be clamped");
+
+            sender.stream_in().write(string("hello"));
+            sender.fill_window();
+            test_err_if(drain(sender).size() != 1, "data should be sent");
+            sender.tick(199);
+            test_err_if(drain(sender).size() != 0, "should not retransmit before the RTO");
+            sender.tick(1);
+            test_err_if(drain(sender).size() != 1, "should retransmit after 200 ms instead of 1000 ms");
+            sender.tick(400);
+            test_err_if(drain(sender).size() != 1, "RTO should back off");
+
+            sender.ack_received(WrappingInt32{6}, 1000);
+            const TCPSenderStats stats = sender.stats();
+            test_err_if(stats.rtt_samples != 1, "retransmitted segments should not be sampled");
+            test_err_if(stats.rto_ms != 800, "backed-off RTO should be kept until a valid sample");
+            test_err_if(stats.retransmissions != 2, "retransmissions should be counted");
+
+            sender.stream_in().write(string("world"));
+            sender.fill_window();
+            drain(sender);
+            sender.tick(30);
+            sender.ack_received(WrappingInt32{11}, 1000);
+            test_err_if(sender.stats().rtt_samples != 2 or sender.stats().rto_ms != 200, "new sample should reset RTO");
+        }
+
+        {
+            // 默认配置仍使用固定的初始 RTO，但 RTT 照常测量
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.tick(20);
+            sender.ack_received(WrappingInt32{1}, 1000);
+            test_err_if(sender.stats().srtt_ms != 20.0, "RTT should still be measured");
+            test_err_if(sender.stats().rto_ms != TCPConfig::TIMEOUT_DFLT, "fixed RTO should be kept");
+        }
+
+        {
+            // TCPConnection 导出发送方的统计信息
+            TCPConfig cfg;
+            cfg.adaptive_rto = true;
+            cfg.rt_timeout = 500;
+            TCPConnection conn{cfg};
+            conn.connect();
+            test_err_if(conn.stats().rto_ms != 500 or conn.stats().rtt_samples != 0, "wrong connection stats");
+            conn.tick(500);
+            test_err_if(conn.stats().retransmissions != 1 or conn.stats().rto_ms != 1000, "SYN should back off");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+#include "buffer.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_test_helpers.hh"
+#include "test_err_if.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <string>
+
+using namespace std;
+
+namespace {
+//! 全局 operator new 被调用的次数
+size_t allocations = 0;
+}  // namespace
+
+// 计数的分配器：替换全局的 operator new，统计堆分配次数
+void *operator new(size_t size) {
+    allocations++;
+    if (void *p = malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+namespace {
+//! 两个直接互联的连接：client 不断写入，server 读出并丢弃
+struct Transfer {
+    TCPConnection client;
+    TCPConnection server;
+    const string chunk;
+    size_t segments{0};  //!< client 发出的段数
+    size_t received{0};
+
+    explicit Transfer(const TCPConfig &cfg) : client{cfg}, server{cfg}, chunk(TCPConfig::MAX_PAYLOAD_SIZE, 'x') {
+        client.connect();
+    }
+
+    //! 模拟 ms 毫秒
+    void run(const size_t ms) {
+        for (size_t i = 0; i < ms; i++) {
+            while (client.remaining_outbound_capacity() >= chunk.size()) {
+                client.write(chunk);
+            }
+            for (; not client.segments_out().empty(); client.segments_out().pop()) {
+                server.segment_received(client.segments_out().front());
+                segments++;
+            }
+            for (; not server.segments_out().empty(); server.segments_out().pop()) {
+                client.segment_received(server.segments_out().front());
+            }
+            client.tick(1);
+            server.tick(1);
+            received += server.inbound_stream().buffer_size();
+            server.inbound_stream().pop_output(server.inbound_stream().buffer_size());
+        }
+    }
+};
+
+//! 预热后，稳定传输期间每个段的平均堆分配次数
+double allocations_per_segment(const TCPConfig &cfg) {
+    Transfer t{cfg};
+    t.run(1000);
+    test_err_if(t.received == 0, "transfer should make progress");
+    const size_t segments_before = t.segments;
+    const size_t allocations_before = allocations;
+    t.run(1000);
+    // 先记下次数：构造 test_err_if 的错误信息本身也要分配
+    const size_t allocated = allocations - allocations_before;
+    const size_t segments = t.segments - segments_before;
+    test_err_if(segments < 1000, "too few segments sent: " + to_string(segments));
+    return double(allocated) / double(segments);
+}
+}  // namespace
+
+int main() {
+    try {
+        {
+            // 缓冲池：空闲的 slab 被重新使用，仍被引用的 slab 不会被覆盖
+            BufferPool pool{100};
+            const auto fill = [](const char ch) { return [ch](char *dst) { dst[0] = ch; }; };
+            Buffer first = pool.make(60, fill('a'));
+            const char *const slab = first.str().data();
+            const Buffer second = pool.make(60, fill('b'));
+            test_err_if(second.str().data() == slab + 60, "a Buffer should not straddle two slabs");
+            first = Buffer{};
+            const Buffer third = pool.make(60, fill('c'));
+            test_err_if(third.str().data() != slab, "the idle slab should be reused");
+            test_err_if(second.at(0) != 'b' or third.at(0) != 'c', "Buffers should keep their contents");
+            test_err_if(pool.make(200, fill('d')).size() != 200, "a large Buffer should get storage of its own");
+        }
+
+        const SilenceCerr silence;
+        TCPConfig cfg;
+        const double plain = allocations_per_segment(cfg);
+        test_err_if(plain != 0, "bulk transfer should not allocate per segment: " + to_string(plain));
+
+        // 拥塞控制、SACK、延迟确认和窗口缩放同样不应在每个段上分配
+        cfg.congestion_control = CongestionControl::Cubic;
+        cfg.fast_retransmit = true;
+        cfg.sack = true;
+        cfg.delayed_ack = true;
+        cfg.window_scaling = true;
+        cfg.send_capacity = 1 << 20;
+        cfg.recv_capacity = 1 << 20;
+        const double full = allocations_per_segment(cfg);
+        test_err_if(full != 0, "bulk transfer with all options should not allocate per segment: " + to_string(full));
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_test_helpers.hh"
+#include "test_err_if.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! 建立连接后，client 发出 count 个数据段，由调用者决定如何交给 server
+struct Pair {
+    TCPConnection client;
+    TCPConnection server;
+
+    explicit Pair(const TCPConfig &server_cfg) : client{TCPConfig{}}, server{server_cfg} {
+        client.connect();
+        for (const auto &seg : drain(client)) {
+            server.segment_received(seg);
+        }
+        for (const auto &seg : drain(server)) {
+            client.segment_received(seg);
+        }
+        for (const auto &seg : drain(client)) {
+            server.segment_received(seg);
+        }
+        drain(server);
+    }
+
+    vector<TCPSegment> data(const size_t count) {
+        client.write(string(count * MSS, 'x'));
+        return drain(client);
+    }
+};
+
+//! 纯 ACK 的确认号（相对于第一个数据字节的偏移）
+vector<uint32_t> acknos(const vector<TCPSegment> &segments, const TCPSegment &first) {
+    vector<uint32_t> result;
+    for (const auto &seg : segments) {
+        result.push_back(uint32_t(seg.header().ackno - first.header().seqno));
+    }
+    return result;
+}
+
+//! 两个连接直接互联传输 total 字节，返回 server 发出的段数
+size_t acks_for_transfer(const TCPConfig &server_cfg, const size_t total) {
+    Pair p{server_cfg};
+    size_t written = 0;
+    size_t received = 0;
+    size_t acks = 0;
+    for (uint64_t now = 0; received < total and now < 100000; now++) {
+        while (written < total and p.client.remaining_outbound_capacity() > 0) {
+            written += p.client.write(string(min(p.client.remaining_outbound_capacity(), total - written), 'x'));
+        }
+        for (const auto &seg : drain(p.client)) {
+            p.server.segment_received(seg);
+        }
+        const auto replies = drain(p.server);
+        acks += replies.size();
+        for (const auto &seg : replies) {
+            p.client.segment_received(seg);
+        }
+        p.client.tick(1);
+        p.server.tick(1);
+        received += p.server.inbound_stream().read(p.server.inbound_stream().buffer_size()).size();
+    }
+    test_err_if(received != total, "transfer did not complete");
+    return acks;
+}
+}  // namespace
+
+int main() {
+    try {
+        const SilenceCerr silence;
+        TCPConfig cfg;
+        cfg.delayed_ack = true;
+
+        {
+            // 每两个按序到达的段确认一次
+            Pair p{cfg};
+            const auto segs = p.data(4);
+            p.server.segment_received(segs[0]);
+            test_err_if(not drain(p.server).empty(), "the first segment's ACK should be delayed");
+            p.server.segment_received(segs[1]);
+            const auto acks = drain(p.server);
+            test_err_if(acks.size() != 1 or acks[0].header().ackno != segs[2].header().seqno,
+                        "the second segment should be ACKed right away");
+        }
+
+        {
+            // 只有一个段时，等待 ack_delay 后发出确认
+            Pair p{cfg};
+            const auto segs = p.data(1);
+            p.server.segment_received(segs[0]);
+            test_err_if(p.server.time_until_next_tick_us() != uint64_t{cfg.ack_delay} * 1000,
+                        "the connection should ask for a tick when the ACK is due");
+            p.server.tick(cfg.ack_delay - 1);
+            test_err_if(not drain(p.server).empty(), "ACK sent before the delay ran out");
+            p.server.tick(1);
+            test_err_if(drain(p.server).size() != 1, "ACK should be sent once the delay runs out");
+            test_err_if(p.server.time_until_next_tick_us().has_value(), "no ACK should be waiting");
+        }
+
+        {
+            // 数据段会捎带确认，不再单独发送延迟的确认
+            Pair p{cfg};
+            const auto segs = p.data(1);
+            p.server.segment_received(segs[0]);
+            p.server.write("reply");
+            const auto sent = drain(p.server);
+            test_err_if(sent.size() != 1 or sent[0].payload().size() != 5, "reply should carry the ACK");
+            p.server.tick(cfg.ack_delay);
+            test_err_if(not drain(p.server).empty(), "the delayed ACK should have been cancelled");
+        }
+
+        {
+            // 乱序到达立即确认，重复 ACK 不合并；填补空洞的段同样立即确认
+            Pair p{cfg};
+            const auto segs = p.data(4);
+            p.server.segment_received(segs[1]);
+            p.server.segment_received(segs[2]);
+            p.server.segment_received(segs[3]);
+            const auto dups = drain(p.server);
+            test_err_if(acknos(dups, segs[0]) != vector<uint32_t>(3, 0), "out-of-order data should give 3 dup ACKs");
+            p.server.segment_received(segs[0]);
+            const auto acks = drain(p.server);
+            test_err_if(acknos(acks, segs[0]) != vector<uint32_t>{4 * MSS}, "filling the hole should ACK right away");
+        }
+
+        {
+            // 一批段到达时，队列中的纯 ACK 合并为确认号最大的那个
+            TCPConfig every{cfg};
+            every.ack_every = 1;
+            Pair p{every};
+            const auto segs = p.data(4);
+            for (const auto &seg : segs) {
+                p.server.segment_received(seg);
+            }
+            const auto acks = drain(p.server);
+            test_err_if(acknos(acks, segs[0]) != vector<uint32_t>{4 * MSS}, "pure ACKs should be coalesced");
+
+            // 未开启时每个段各自确认
+            Pair q{TCPConfig{}};
+            const auto more = q.data(4);
+            for (const auto &seg : more) {
+                q.server.segment_received(seg);
+            }
+            test_err_if(drain(q.server).size() != 4, "every segment should be ACKed without delayed ACKs");
+        }
+
+        {
+            // 批量传输时确认的数量大约减半
+            const size_t total = 1000000;
+            const size_t immediate = acks_for_transfer(TCPConfig{}, total);
+            const size_t delayed = acks_for_transfer(cfg, total);
+            test_err_if(immediate < total / MSS, "every segment should have been ACKed");
+            test_err_if(delayed * 2 > immediate + 10,
+                        "delayed ACKs should halve the ACKs: " + to_string(delayed) + " vs " + to_string(immediate));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
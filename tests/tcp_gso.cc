@@ -0,0 +1,163 @@
+#include "byte_stream.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "tcp_test_helpers.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+//! 序列化后重新解析，检查校验和
+bool reparses(const TCPSegment &seg) {
+    TCPSegment parsed;
+    return parsed.parse(Buffer{seg.serialize().concatenate()}) == ParseResult::NoError;
+}
+
+char pattern(const size_t i) { return char('a' + i % 23); }
+}  // namespace
+
+int main() {
+    try {
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            // 分段读取时每段各自计算校验和，与单独计算的结果相同
+            ByteStream stream{10000};
+            string data(2500, 0);
+            for (size_t i = 0; i < data.size(); i++) {
+                data[i] = pattern(i);
+            }
+            stream.write(data);
+            vector<InternetChecksum> sums;
+            const string read = stream.read(2500, mss, sums);
+            test_err_if(read != data or sums.size() != 3, "should read three pieces");
+            for (size_t i = 0; i < sums.size(); i++) {
+                InternetChecksum expected;
+                expected.add(data.substr(i * mss, mss));
+                test_err_if(sums[i].value() != expected.value(), "wrong checksum of piece " + to_string(i));
+            }
+        }
+
+        {
+            // 超级段拆分：序号递增，FIN 只在最后一段，负载共享存储，校验和正确
+            ByteStream stream{10000};
+            string data(2500, 'x');
+            stream.write(data);
+            vector<InternetChecksum> sums;
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32{100};
+            seg.header().ack = true;
+            seg.header().fin = true;
+            seg.set_gso_payload(Buffer{stream.read(2500, mss, sums)}, mss, move(sums));
+            test_err_if(seg.length_in_sequence_space() != 2501, "super-segment should cover all its data");
+            test_err_if(not reparses(seg), "the super-segment itself should have a valid checksum");
+
+            const vector<TCPSegment> pieces = seg.split();
+            test_err_if(pieces.size() != 3, "2500 bytes should be split into three pieces");
+            for (size_t i = 0; i < pieces.size(); i++) {
+                const TCPSegment &piece = pieces[i];
+                test_err_if(piece.header().seqno != WrappingInt32{uint32_t(100 + i * mss)}, "wrong piece seqno");
+                test_err_if(piece.payload().size() != min(mss, 2500 - i * mss), "wrong piece length");
+                test_err_if(piece.header().fin != (i == 2), "only the last piece should carry FIN");
+                test_err_if(not piece.header().ack, "every piece should carry the ACK");
+                test_err_if(piece.payload().str().data() != seg.payload().str().data() + i * mss,
+                            "pieces should share the payload");
+                test_err_if(not reparses(piece), "piece " + to_string(i) + " should have a valid checksum");
+            }
+
+            size_t count = 0;
+            seg.for_each_wire_segment([&](const TCPSegment &) { count++; });
+            test_err_if(count != 3, "a super-segment should go out as its pieces");
+        }
+
+        {
+            // 发送方一次发出一个超级段，但按 MSS 记录在途数据：超时只重传一个 MSS
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.gso = true;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            drain(sender);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write(string(5 * mss, 'x'));
+            sender.fill_window();
+            const auto sent = drain(sender);
+            test_err_if(sent.size() != 1, "new data should leave as one super-segment");
+            test_err_if(sent[0].payload().size() != 5 * mss or sent[0].gso_size() != mss, "wrong super-segment");
+
+            sender.ack_received(WrappingInt32{1 + 2 * mss}, 60000);
+            test_err_if(sender.bytes_in_flight() != 3 * mss, "ACK of two pieces should shrink the flight");
+            sender.tick(cfg.rt_timeout);
+            const auto resent = drain(sender);
+            test_err_if(resent.size() != 1, "timeout should retransmit one piece");
+            test_err_if(resent[0].header().seqno != WrappingInt32{uint32_t(1 + 2 * mss)} or
+                            resent[0].payload().size() != mss or resent[0].gso_size() != 0,
+                        "timeout should retransmit the first unacked MSS");
+            test_err_if(not reparses(resent[0]), "retransmitted piece should have a valid checksum");
+        }
+
+        {
+            // 两个开启 GSO 的连接，经拆分后的线上段传输数据
+            const SilenceCerr silence;
+            TCPConfig cfg;
+            cfg.gso = true;
+            TCPConnection client{cfg};
+            TCPConnection server{cfg};
+            const size_t total = 1000000;
+            size_t written = 0;
+            size_t received = 0;
+            size_t wire_segments = 0;
+            size_t super_segments = 0;
+            client.connect();
+            for (uint64_t now = 0; received < total and now < 10000; now++) {
+                while (written < total and client.remaining_outbound_capacity() > 0) {
+                    const size_t len = min(client.remaining_outbound_capacity(), total - written);
+                    string chunk(len, 0);
+                    for (size_t i = 0; i < len; i++) {
+                        chunk[i] = pattern(written + i);
+                    }
+                    written += client.write(chunk);
+                }
+                for (; not client.segments_out().empty(); client.segments_out().pop()) {
+                    TCPSegment &seg = client.segments_out().front();
+                    super_segments += seg.gso_size() > 0;
+                    seg.for_each_wire_segment([&](const TCPSegment &piece) {
+                        test_err_if(piece.payload().size() > mss, "wire segment larger than the MSS");
+                        TCPSegment parsed;
+                        test_err_if(parsed.parse(Buffer{piece.serialize().concatenate()}) != ParseResult::NoError,
+                                    "wire segment should have a valid checksum");
+                        wire_segments++;
+                        server.segment_received(parsed);
+                    });
+                }
+                for (; not server.segments_out().empty(); server.segments_out().pop()) {
+                    client.segment_received(server.segments_out().front());
+                }
+                client.tick(1);
+                server.tick(1);
+                const string data = server.inbound_stream().read(server.inbound_stream().buffer_size());
+                for (size_t i = 0; i < data.size(); i++) {
+                    test_err_if(data[i] != pattern(received + i), "corrupted data at byte " + to_string(received + i));
+                }
+                received += data.size();
+            }
+            test_err_if(received != total, "transfer did not complete");
+            test_err_if(super_segments == 0 or wire_segments < total / mss, "data should go out in super-segments");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
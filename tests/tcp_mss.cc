@@ -0,0 +1,166 @@
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_test_helpers.hh"
+#include "test_err_if.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+namespace {
+//! 有时延的链路，丢弃负载超过 path_mss 的段（如同路径上 MTU 更小、又不发送 ICMP 的路由器）
+class Path {
+    uint64_t _delay_ms;
+    deque<pair<uint64_t, TCPSegment>> _wire{};
+
+  public:
+    size_t path_mss;
+    size_t largest{0};  //!< 通过的最大负载
+
+    Path(uint64_t delay_ms, size_t mss) : _delay_ms(delay_ms), path_mss(mss) {}
+
+    void send(const TCPSegment &seg, const uint64_t now_ms) {
+        if (seg.payload().size() > path_mss) {
+            return;
+        }
+        largest = max(largest, seg.payload().size());
+        _wire.emplace_back(now_ms + _delay_ms, seg);
+    }
+
+    void deliver(const uint64_t now_ms, TCPConnection &to) {
+        while (not _wire.empty() and _wire.front().first <= now_ms) {
+            to.segment_received(_wire.front().second);
+            _wire.pop_front();
+        }
+    }
+};
+
+char pattern(const size_t i) { return char('a' + i % 23); }
+
+//! 两个连接通过 Path 互联，client 向 server 发送数据并检查内容
+struct Transfer {
+    TCPConnection client;
+    TCPConnection server;
+    Path forward;
+    Path reverse{5, SIZE_MAX};
+    uint64_t now{0};
+    size_t written{0};
+    size_t received{0};
+
+    Transfer(const TCPConfig &client_cfg, const TCPConfig &server_cfg, const size_t path_mss)
+        : client{client_cfg}, server{server_cfg}, forward{5, path_mss} {}
+
+    void pump() {
+        for (; not client.segments_out().empty(); client.segments_out().pop()) {
+            forward.send(client.segments_out().front(), now);
+        }
+        for (; not server.segments_out().empty(); server.segments_out().pop()) {
+            reverse.send(server.segments_out().front(), now);
+        }
+    }
+
+    //! 发送 total 字节，最多模拟 limit_ms 毫秒
+    void run(const size_t total, const uint64_t limit_ms) {
+        const uint64_t end = now + limit_ms;
+        const size_t target = written + total;
+        while (received < target and now < end and client.active()) {
+            while (written < target and client.remaining_outbound_capacity() > 0) {
+                const size_t len = min(client.remaining_outbound_capacity(), target - written);
+                string chunk(len, 0);
+                for (size_t i = 0; i < len; i++) {
+                    chunk[i] = pattern(written + i);
+                }
+                written += client.write(chunk);
+            }
+            pump();
+            now++;
+            client.tick(1);
+            server.tick(1);
+            forward.deliver(now, server);
+            reverse.deliver(now, client);
+            const string data = server.inbound_stream().read(server.inbound_stream().buffer_size());
+            for (size_t i = 0; i < data.size(); i++) {
+                test_err_if(data[i] != pattern(received + i), "corrupted data at byte " + to_string(received + i));
+            }
+            received += data.size();
+        }
+        test_err_if(received != target, "transfer did not complete");
+    }
+};
+}  // namespace
+
+int main() {
+    try {
+        {
+            // MSS 选项的序列化与解析
+            TCPHeader header;
+            header.syn = true;
+            header.mss = 1460;
+            const string bytes = header.serialize();
+            test_err_if(header.data_offset() != 6, "MSS option should take one word");
+            const string option{2, 4, 0x05, char(0xb4)};
+            test_err_if(bytes.substr(20, 4) != option, "MSS option should be kind, length, 16-bit MSS");
+            TCPHeader parsed;
+            NetParser p{Buffer{string(bytes)}};
+            test_err_if(parsed.parse(p) != ParseResult::NoError, "header should parse");
+            test_err_if(not(parsed == header) or parsed.mss != 1460, "option should survive a round trip");
+        }
+
+        {
+            // TCP over IPv4 的最大负载由链路 MTU 减去 IP 和 TCP 首部得到
+            TCPOverIPv4Adapter adapter;
+            test_err_if(adapter.max_payload_size() != 1460, "a 1500-byte MTU carries 1460 bytes of payload");
+            adapter.config_mut().mtu = 9000;
+            test_err_if(adapter.max_payload_size() != 8960, "jumbo frames carry 8960 bytes of payload");
+        }
+
+        const SilenceCerr silence;
+        {
+            // 双方在 SYN 中交换 MSS，发送的段不超过两者中较小的一个
+            TCPConfig client_cfg;
+            client_cfg.mss = 1460;
+            TCPConfig server_cfg;
+            server_cfg.mss = 1200;
+            Transfer t{client_cfg, server_cfg, SIZE_MAX};
+            t.client.connect();
+            test_err_if(t.client.segments_out().front().header().mss != 1460, "SYN should offer the MSS");
+            t.run(100000, 10000);
+            test_err_if(t.forward.largest != 1200, "client should send the peer's MSS, not " +
+                                                       to_string(t.forward.largest));
+        }
+
+        {
+            // 从保守的大小开始探测：路径能承载的最大负载为 1300 字节，探测 1460 字节失败后二分查找
+            TCPConfig cfg;
+            cfg.mss = 1460;
+            cfg.mtu_probing = true;
+            cfg.congestion_control = CongestionControl::NewReno;
+            cfg.rt_timeout = 100;
+            Transfer t{cfg, cfg, 1300};
+            t.client.connect();
+            t.run(400000, 60000);
+            test_err_if(t.client.mss() > 1300 or t.client.mss() + 8 < 1300,
+                        "search should settle just below 1300, not " + to_string(t.client.mss()));
+
+            // 路径 MTU 变小后，连续超时让发送方退回保守的大小，再重新搜索
+            t.forward.path_mss = 1100;
+            t.run(400000, 60000);
+            test_err_if(t.client.mss() > 1100 or t.client.mss() + 8 < 1100,
+                        "search should settle again below 1100, not " + to_string(t.client.mss()));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+#include "congestion_control.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_sender.hh"
+#include "tcp_test_helpers.hh"
+#include "test_err_if.hh"
+#include "timer_wheel.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! 浅缓冲的瓶颈链路：按固定速率串行发送，队列满时尾部丢弃，时间以微秒计
+class ShallowLink {
+    uint64_t _rate;  // 字节/毫秒
+    uint64_t _delay_us;
+    size_t _queue_limit;
+    uint64_t _busy_until_us{0};
+    deque<pair<uint64_t, TCPSegment>> _wire{};
+
+  public:
+    size_t drops{0};
+
+    ShallowLink(uint64_t rate, uint64_t delay_us, size_t queue_limit)
+        : _rate(rate), _delay_us(delay_us), _queue_limit(queue_limit) {}
+
+    void send(const TCPSegment &seg, const uint64_t now_us) {
+        const uint64_t size = seg.payload().size() + 40;
+        const uint64_t start_us = max(now_us, _busy_until_us);
+        const uint64_t queued = (start_us - now_us) * _rate / 1000;
+        if (queued + size > _queue_limit) {
+            drops++;
+            return;
+        }
+        _busy_until_us = start_us + size * 1000 / _rate;
+        _wire.emplace_back(_busy_until_us + _delay_us, seg);
+    }
+
+    template <typename F>
+    void deliver(const uint64_t now_us, F &&receive) {
+        while (not _wire.empty() and _wire.front().first <= now_us) {
+            receive(_wire.front().second);
+            _wire.pop_front();
+        }
+    }
+};
+
+struct Result {
+    bool complete;
+    size_t drops;
+    uint64_t elapsed_us;
+};
+
+//! 经过 10 Mbit/s、单向时延 10 ms、队列只能容纳 4 个段的链路传输 total 字节，每 100 微秒推进一次时钟；
+//! 确认每 5 ms 成批到达（如无线链路上的确认聚合），不按节奏发送时会随之成批发出数据
+Result transfer(const bool pacing, const size_t total) {
+    const SilenceCerr silence;
+    TCPConfig cfg;
+    cfg.congestion_control = CongestionControl::NewReno;
+    cfg.fast_retransmit = true;
+    cfg.sack = true;
+    cfg.pacing = pacing;
+    TCPConnection client{cfg};
+    TCPConnection server{cfg};
+    ShallowLink forward{1250, 10000, 4 * (MSS + 40)};
+    ShallowLink reverse{1000000, 10000, SIZE_MAX};
+
+    uint64_t now = 0;
+    size_t written = 0;
+    size_t received = 0;
+    const auto pump = [&] {
+        while (written < total and client.remaining_outbound_capacity() > 0) {
+            written += client.write(string(min(client.remaining_outbound_capacity(), total - written), 'x'));
+        }
+        for (; not client.segments_out().empty(); client.segments_out().pop()) {
+            forward.send(client.segments_out().front(), now);
+        }
+        for (; not server.segments_out().empty(); server.segments_out().pop()) {
+            reverse.send(server.segments_out().front(), now);
+        }
+    };
+
+    client.connect();
+    pump();
+    constexpr uint64_t step_us = 100;
+    constexpr uint64_t ack_batch_us = 5000;
+    while (received < total and now < 60000000 and client.active()) {
+        now += step_us;
+        client.tick_us(step_us);
+        server.tick_us(step_us);
+        forward.deliver(now, [&](const TCPSegment &seg) { server.segment_received(seg); });
+        // 确认在返回路径上被聚合，成批到达发送方
+        if (now % ack_batch_us == 0) {
+            reverse.deliver(now, [&](const TCPSegment &seg) { client.segment_received(seg); });
+        }
+        received += server.inbound_stream().read(server.inbound_stream().buffer_size()).size();
+        pump();
+    }
+    return {received == total, forward.drops, now};
+}
+}  // namespace
+
+int main() {
+    try {
+        {
+            // 定时器按截止时间的顺序触发，被取消的不触发
+            TimerWheel wheel{10};
+            vector<int> fired;
+            wheel.schedule(300, [&] { fired.push_back(3); });
+            wheel.schedule(100, [&] { fired.push_back(1); });
+            const auto cancelled = wheel.schedule(200, [&] { fired.push_back(2); });
+            test_err_if(wheel.size() != 3 or wheel.next_deadline() != 100, "earliest deadline should be 100");
+            test_err_if(not wheel.cancel(cancelled) or wheel.cancel(cancelled), "cancel should succeed once");
+            wheel.advance(99);
+            test_err_if(not fired.empty(), "timer fired early");
+            wheel.advance(1000);
+            test_err_if(fired != vector<int>({1, 3}), "timers fired in the wrong order");
+            test_err_if(wheel.size() != 0 or wheel.next_deadline().has_value(), "wheel should be empty");
+        }
+
+        {
+            // 远期定时器经过逐级下移后准时触发；回调中可以安排新的定时器
+            TimerWheel wheel{1};
+            vector<uint64_t> fired;
+            const vector<uint64_t> deadlines{5, 64, 4095, 4096, 300000, 16777216, 20000000};
+            for (const uint64_t deadline : deadlines) {
+                wheel.schedule(deadline, [&fired, deadline] { fired.push_back(deadline); });
+            }
+            wheel.schedule(10, [&] { wheel.schedule(20, [&] { fired.push_back(20); }); });
+            uint64_t now = 0;
+            while (wheel.next_deadline().has_value()) {
+                now = max(now, wheel.next_deadline().value());
+                wheel.advance(now);
+                test_err_if(not fired.empty() and fired.back() > now, "timer fired before its deadline");
+            }
+            const vector<uint64_t> expected{5, 20, 64, 4095, 4096, 300000, 16777216, 20000000};
+            test_err_if(fired != expected, "long timers fired in the wrong order");
+
+            // 已到期的定时器在下一次 advance 时触发
+            bool due = false;
+            wheel.schedule(0, [&] { due = true; });
+            test_err_if(wheel.next_deadline() > now, "due timer should be reported as due");
+            wheel.advance(now);
+            test_err_if(not due, "due timer should fire");
+        }
+
+        {
+            // 有 RTT 样本后，数据段按拥塞窗口每个 RTT 的速率发出，而不是一次性全部发出
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.congestion_control = CongestionControl::NewReno;
+            cfg.pacing = true;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            drain(sender);
+            sender.tick(10);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            const uint64_t rate = sender.congestion_controller()->pacing_rate();
+            test_err_if(rate == 0, "an RTT sample should give a pacing rate");
+
+            sender.stream_in().write(string(4 * MSS, 'x'));
+            sender.fill_window();
+            test_err_if(drain(sender).size() != 1, "only the first segment should leave right away");
+            const auto wait = sender.time_until_next_tick_us();
+            const uint64_t gap = MSS * 1000000 / rate;
+            test_err_if(wait != gap - 1000, "sender should wait for one segment's time, less the burst allowance");
+            sender.tick_us(wait.value() - 1);
+            test_err_if(drain(sender).size() != 0, "segment released early");
+            sender.tick_us(1);
+            test_err_if(drain(sender).size() != 1, "tick should release the next segment");
+            test_err_if(sender.time_until_next_tick_us() != gap, "segments should be one gap apart");
+            sender.tick_us(10 * gap);
+            test_err_if(drain(sender).size() != 1, "a late tick releases only the burst allowance");
+        }
+
+        {
+            // 浅缓冲的瓶颈前，按节奏发送不会因成批的确认而突发，丢包更少、完成更快
+            const size_t total = 1000000;
+            const Result burst = transfer(false, total);
+            const Result paced = transfer(true, total);
+            test_err_if(not burst.complete or not paced.complete, "transfers should complete");
+            test_err_if(paced.drops >= burst.drops,
+                        "pacing should drop less: " + to_string(paced.drops) + " vs " + to_string(burst.drops));
+            test_err_if(paced.elapsed_us >= burst.elapsed_us, "pacing should finish sooner");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,227 @@
+#include "parser.hh"
+#include "stream_reassembler.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+#include "tcp_test_helpers.hh"
+#include "test_err_if.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+TCPHeader parse_header(const string &bytes) {
+    TCPHeader header;
+    NetParser p{Buffer{string(bytes)}};
+    test_err_if(header.parse(p) != ParseResult::NoError, "header should parse");
+    return header;
+}
+
+TCPHeader::SackList sack_of(const vector<pair<uint32_t, uint32_t>> &blocks) {
+    TCPHeader::SackList sack;
+    for (const auto &[left, right] : blocks) {
+        sack.blocks[sack.count++] = {WrappingInt32{left}, WrappingInt32{right}};
+    }
+    return sack;
+}
+}  // namespace
+
+int main() {
+    try {
+        {
+            // 选项的序列化与解析
+            TCPHeader header;
+            header.syn = true;
+            header.sack_permitted = true;
+            header.sack = sack_of({{1000, 2000}, {3000, 4000}, {5000, 6000}});
+            test_err_if(header.data_offset() != 12, "28 bytes of options should take 7 words");
+            const string bytes = header.serialize();
+            test_err_if(bytes.size() != 48, "serialized header should include the options");
+            const TCPHeader parsed = parse_header(bytes);
+            test_err_if(not(parsed == header) or parsed.doff != 12, "options should survive a round trip");
+            test_err_if(parsed.sack.blocks[2].right != WrappingInt32{6000}, "wrong SACK block");
+
+            TCPHeader plain;
+            test_err_if(plain.serialize().size() != TCPHeader::LENGTH, "no options should mean no extra bytes");
+        }
+
+        {
+            // 未知选项被跳过；长度非法的选项使解析停止在该处，但头部仍然有效
+            const auto with_options = [](const string &options) {
+                string bytes = TCPHeader{}.serialize() + options;
+                bytes[12] = char(bytes.size() / 4 << 4);
+                return bytes;
+            };
+            const string timestamps{8, 10, 0, 0, 0, 1, 0, 0, 0, 2};
+            const string sack{1, 1, 5, 10, 0, 0, 0, 7, 0, 0, 0, 9};
+            const TCPHeader parsed = parse_header(with_options(timestamps + sack + string(2, 0)));
+            test_err_if(parsed.sack.count != 1 or parsed.sack.blocks[0].left != WrappingInt32{7},
+                        "SACK after an unknown option should be parsed");
+
+            const string malformed = with_options(string{5, 40} + string(14, 0));
+            test_err_if(parse_header(malformed).sack.count != 0, "malformed option should be ignored");
+        }
+
+        {
+            // 乱序到达的区间（Chunks 模式下相邻的分片合并为一个区间）
+            for (const auto storage : {ByteStream::Storage::Ring, ByteStream::Storage::Chunks}) {
+                StreamReassembler reassembler{100, storage};
+                reassembler.push_substring(Buffer{string("cd")}, 2, false);
+                reassembler.push_substring(Buffer{string("ef")}, 4, false);
+                reassembler.push_substring(Buffer{string("ij")}, 8, false);
+                using Ranges = vector<pair<uint64_t, uint64_t>>;
+                test_err_if(reassembler.received_ranges() != Ranges({{2, 6}, {8, 10}}), "wrong received ranges");
+            }
+        }
+
+        {
+            // 接收方生成 SACK 块：最近收到的段所在的块排在最前
+            TCPReceiver receiver{100};
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().seqno = WrappingInt32{0};
+            receiver.segment_received(syn);
+            test_err_if(receiver.sack().count != 0, "no out-of-order data should mean no blocks");
+            for (const auto &[seqno, data] : vector<pair<uint32_t, string>>{{11, "x"}, {5, "yy"}, {21, "zz"}}) {
+                TCPSegment seg;
+                seg.header().seqno = WrappingInt32{seqno};
+                seg.payload() = Buffer{string(data)};
+                receiver.segment_received(seg);
+            }
+            test_err_if(not(receiver.sack() == sack_of({{21, 23}, {5, 7}, {11, 12}})), "wrong SACK blocks");
+        }
+
+        TCPConfig cfg;
+        cfg.fixed_isn = WrappingInt32{0};
+        cfg.fast_retransmit = true;
+        const uint16_t win = 60000;
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+        const auto seqno_of = [&](const size_t segment) { return WrappingInt32{uint32_t(1 + segment * mss)}; };
+
+        {
+            // 三个重复 ACK 触发快速重传；部分确认立即重传下一个丢失的段；全部确认后退出恢复
+            TCPSender sender{cfg};
+            sender.fill_window();
+            drain(sender);
+            sender.ack_received(WrappingInt32{1}, win);
+            sender.stream_in().write(string(6 * mss, 'x'));
+            sender.fill_window();
+            test_err_if(drain(sender).size() != 6, "six segments should be sent");
+
+            sender.ack_received(seqno_of(1), win);
+            for (int i = 0; i < 2; i++) {
+                sender.ack_received(seqno_of(1), win);
+            }
+            test_err_if(not drain(sender).empty(), "two duplicate ACKs should not trigger a retransmission");
+            sender.ack_received(seqno_of(1), win);
+            auto out = drain(sender);
+            test_err_if(out.size() != 1 or out[0].header().seqno != seqno_of(1), "third duplicate should retransmit");
+            sender.ack_received(seqno_of(1), win);
+            test_err_if(not drain(sender).empty(), "more duplicates should not resend the same segment");
+
+            sender.ack_received(seqno_of(3), win);
+            out = drain(sender);
+            test_err_if(out.size() != 1 or out[0].header().seqno != seqno_of(3), "partial ACK should retransmit");
+            sender.ack_received(seqno_of(6), win);
+            test_err_if(sender.bytes_in_flight() != 0, "everything should be acknowledged");
+            test_err_if(sender.stats().fast_retransmissions != 2, "two fast retransmissions expected");
+        }
+
+        {
+            // 有 SACK 信息时一次重传所有空洞，且不重传已被 SACK 的段
+            TCPSender sender{cfg};
+            sender.fill_window();
+            drain(sender);
+            sender.ack_received(WrappingInt32{1}, win);
+            sender.stream_in().write(string(7 * mss, 'x'));
+            sender.fill_window();
+            drain(sender);
+            // 段 0 和段 2 丢失；段 2 之后有三个段被 SACK，达到 DupThresh
+            const WrappingInt32 ack = seqno_of(0);
+            sender.ack_received(ack, win, sack_of({{seqno_of(1).raw_value(), seqno_of(2).raw_value()}}), true);
+            sender.ack_received(ack, win, sack_of({{seqno_of(3).raw_value(), seqno_of(5).raw_value()}}), true);
+            sender.ack_received(ack, win, sack_of({{seqno_of(3).raw_value(), seqno_of(6).raw_value()}}), true);
+            const auto out = drain(sender);
+            test_err_if(out.size() != 2 or out[0].header().seqno != seqno_of(0) or
+                            out[1].header().seqno != seqno_of(2),
+                        "both holes should be retransmitted");
+        }
+
+        {
+            // 之后被 SACK 的段不足 DupThresh 个时，中间的段可能只是乱序，只重传第一个未确认的段（RFC 6675 IsLost）
+            TCPSender sender{cfg};
+            sender.fill_window();
+            drain(sender);
+            sender.ack_received(WrappingInt32{1}, win);
+            sender.stream_in().write(string(6 * mss, 'x'));
+            sender.fill_window();
+            drain(sender);
+            const WrappingInt32 ack = seqno_of(0);
+            const auto sack = sack_of({{seqno_of(4).raw_value(), seqno_of(6).raw_value()}});
+            for (int i = 0; i < 3; i++) {
+                sender.ack_received(ack, win, sack, true);
+            }
+            auto out = drain(sender);
+            test_err_if(out.size() != 1 or out[0].header().seqno != seqno_of(0),
+                        "segments below a reordered SACK should not be retransmitted");
+            // 再有一个段被 SACK 后，段 1 到段 2 之后被 SACK 的段达到三个，认为已经丢失
+            sender.ack_received(ack, win, sack_of({{seqno_of(3).raw_value(), seqno_of(6).raw_value()}}), true);
+            out = drain(sender);
+            test_err_if(out.size() != 2 or out[0].header().seqno != seqno_of(1) or
+                            out[1].header().seqno != seqno_of(2),
+                        "segments with DupThresh SACKed segments above should be retransmitted");
+        }
+
+        {
+            // 超时后不再依据之前的 SACK 信息：之后的快速重传只重传第一个未确认的段
+            TCPSender sender{cfg};
+            sender.fill_window();
+            drain(sender);
+            sender.ack_received(WrappingInt32{1}, win);
+            sender.stream_in().write(string(6 * mss, 'x'));
+            sender.fill_window();
+            drain(sender);
+            const WrappingInt32 ack = seqno_of(0);
+            sender.ack_received(ack, win, sack_of({{seqno_of(4).raw_value(), seqno_of(5).raw_value()}}), true);
+            sender.tick(cfg.rt_timeout);
+            auto out = drain(sender);
+            test_err_if(out.size() != 1 or out[0].header().seqno != seqno_of(0), "timeout should retransmit");
+            for (int i = 0; i < 3; i++) {
+                sender.ack_received(ack, win, {}, true);
+            }
+            out = drain(sender);
+            test_err_if(out.size() != 1 or out[0].header().seqno != seqno_of(0),
+                        "SACK information from before the timeout should be forgotten");
+        }
+
+        {
+            // 双方都开启时才协商 SACK
+            for (const bool server_sack : {false, true}) {
+                TCPConfig client_cfg;
+                client_cfg.sack = true;
+                TCPConfig server_cfg;
+                server_cfg.sack = server_sack;
+                TCPConnection client{client_cfg};
+                TCPConnection server{server_cfg};
+                client.connect();
+                const TCPSegment syn = client.segments_out().front();
+                test_err_if(not syn.header().sack_permitted, "SYN should offer SACK");
+                server.segment_received(syn);
+                const TCPSegment syn_ack = server.segments_out().front();
+                test_err_if(syn_ack.header().sack_permitted != server_sack, "SYN+ACK should answer the offer");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,66 @@
+#include "byte_stream.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        for (unsigned trial = 0; trial < 500; trial++) {
+            string data(rd() % 1500, 0);
+            for (auto &c : data) {
+                c = char(rd());
+            }
+            const uint32_t pseudo = rd() & 0x3ffff;
+
+            // 从流中读取时顺带计算的校验和，应与重新计算的结果一致
+            ByteStream stream{2000};
+            stream.write(string(rd() % 700, 'w'));
+            stream.pop_output(stream.buffer_size());
+            stream.write(data);
+            InternetChecksum payload_checksum;
+            string payload = stream.read(data.size(), payload_checksum);
+            test_err_if(payload != data, "read with a checksum returned the wrong bytes");
+
+            TCPSegment cached;
+            cached.header().seqno = WrappingInt32{uint32_t(rd())};
+            cached.header().ack = true;
+            cached.set_payload(Buffer(move(payload)), payload_checksum);
+            TCPSegment uncached;
+            uncached.header() = cached.header();
+            uncached.payload() = Buffer{string(data)};
+            const string wire = cached.serialize(pseudo).concatenate();
+            test_err_if(wire != uncached.serialize(pseudo).concatenate(), "cached payload checksum gave a different wire");
+
+            // 解析后再序列化应得到完全相同的字节；换掉负载后缓存必须失效
+            TCPSegment parsed;
+            test_err_if(parsed.parse(Buffer{string(wire)}, pseudo) != ParseResult::NoError, "parse failed");
+            test_err_if(parsed.serialize(pseudo).concatenate() != wire, "parse/serialize round trip changed the bytes");
+            if (not data.empty()) {
+                parsed.payload().remove_prefix(1);
+                TCPSegment shortened;
+                shortened.header() = parsed.header();
+                shortened.payload() = Buffer{data.substr(1)};
+                test_err_if(parsed.serialize(pseudo).concatenate() != shortened.serialize(pseudo).concatenate(),
+                            "stale payload checksum after the payload changed");
+
+                string corrupt = wire;
+                corrupt.back() ^= 1;
+                test_err_if(parsed.parse(Buffer{move(corrupt)}, pseudo) != ParseResult::BadChecksum,
+                            "corrupted payload was accepted");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
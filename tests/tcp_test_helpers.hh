@@ -0,0 +1,33 @@
+#ifndef SPONGE_TESTS_TCP_TEST_HELPERS_HH
+#define SPONGE_TESTS_TCP_TEST_HELPERS_HH
+
+#include "tcp_segment.hh"
+
+#include <iostream>
+#include <vector>
+
+//! 取出 TCPSender 或 TCPConnection 发出的所有段
+template <typename T>
+std::vector<TCPSegment> drain(T &sender) {
+    std::vector<TCPSegment> segments;
+    for (; not sender.segments_out().empty(); sender.segments_out().pop()) {
+        segments.push_back(sender.segments_out().front());
+    }
+    return segments;
+}
+
+//! 在作用域内屏蔽 cerr，例如传输结束时连接仍处于打开状态，析构时的警告
+class SilenceCerr {
+    std::streambuf *_saved{std::cerr.rdbuf(nullptr)};
+
+  public:
+    SilenceCerr() = default;
+    SilenceCerr(const SilenceCerr &) = delete;
+    SilenceCerr &operator=(const SilenceCerr &) = delete;
+    ~SilenceCerr() {
+        std::cerr.rdbuf(_saved);
+        std::cerr.clear();
+    }
+};
+
+#endif  // SPONGE_TESTS_TCP_TEST_HELPERS_HH
@@ -0,0 +1,96 @@
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+namespace {
+//! 把 from 发出的所有段交给 to，返回其中最后一个段
+optional<TCPSegment> deliver(TCPConnection &from, TCPConnection &to) {
+    optional<TCPSegment> last;
+    for (; not from.segments_out().empty(); from.segments_out().pop()) {
+        last = from.segments_out().front();
+        to.segment_received(*last);
+    }
+    return last;
+}
+}  // namespace
+
+int main() {
+    try {
+        {
+            // 窗口缩放选项的序列化与解析：NOP 使后面的选项保持对齐
+            TCPHeader header;
+            header.syn = true;
+            header.window_scale = 7;
+            header.sack_permitted = true;
+            test_err_if(header.data_offset() != 7, "6 bytes of options should take 2 words");
+            const string bytes = header.serialize();
+            const string option{1, 3, 3, 7};
+            test_err_if(bytes.substr(20, 4) != option, "window scale should be NOP, kind, length, shift");
+            TCPHeader parsed;
+            NetParser p{Buffer{string(bytes)}};
+            test_err_if(parsed.parse(p) != ParseResult::NoError, "header should parse");
+            test_err_if(not(parsed == header) or parsed.window_scale != 7, "option should survive a round trip");
+        }
+
+        {
+            // 超过 16 位的窗口：大窗口的发送方可以让多于 64 KiB 的数据在途
+            TCPSender sender{TCPConfig::DEFAULT_CAPACITY * 16, 1000, WrappingInt32{0}};
+            sender.fill_window();
+            sender.ack_received(WrappingInt32{1}, 1 << 20);
+            sender.stream_in().write(string(TCPConfig::DEFAULT_CAPACITY * 16, 'x'));
+            sender.fill_window();
+            test_err_if(sender.bytes_in_flight() != TCPConfig::DEFAULT_CAPACITY * 16, "window should not be truncated");
+        }
+
+        {
+            // 双方都开启时才协商；协商后通告的窗口按移位数缩放，SYN 中的窗口不缩放
+            for (const bool server_scaling : {false, true}) {
+                TCPConfig client_cfg;
+                client_cfg.window_scaling = true;
+                client_cfg.recv_capacity = 1 << 20;
+                TCPConfig server_cfg;
+                server_cfg.window_scaling = server_scaling;
+                server_cfg.recv_capacity = 1 << 20;
+                server_cfg.send_capacity = 1 << 20;
+                TCPConnection client{client_cfg};
+                TCPConnection server{server_cfg};
+
+                client.connect();
+                const TCPSegment syn = client.segments_out().front();
+                test_err_if(syn.header().window_scale != 5, "1 MiB needs a shift of 5");
+                deliver(client, server);
+                const TCPSegment syn_ack = server.segments_out().front();
+                test_err_if(syn_ack.header().window_scale.has_value() != server_scaling,
+                            "SYN+ACK should answer the offer");
+                test_err_if(syn_ack.header().win != UINT16_MAX, "SYN+ACK window should be clamped, not scaled");
+                deliver(server, client);
+                const optional<TCPSegment> ack = deliver(client, server);
+                test_err_if(not ack.has_value(), "client should acknowledge the SYN+ACK");
+                test_err_if(ack->header().win != (server_scaling ? (1 << 20) >> 5 : UINT16_MAX), "wrong window");
+
+                // 服务器一次发送的数据受客户端通告的窗口限制
+                server.write(string(1 << 20, 'x'));
+                const size_t expected = server_scaling ? 1 << 20 : UINT16_MAX;
+                test_err_if(server.bytes_in_flight() != expected,
+                            "server should fill a window of " + to_string(expected) + " bytes, not " +
+                                to_string(server.bytes_in_flight()));
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
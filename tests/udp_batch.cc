@@ -0,0 +1,164 @@
+#include "address.hh"
+#include "buffer.hh"
+#include "fd_adapter.hh"
+#include "socket.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        UDPSocket sender;
+        sender.bind(Address{"127.0.0.1", 0});
+        UDPSocket receiver;
+        receiver.bind(Address{"127.0.0.1", 0});
+        BufferPool pool;
+
+        {
+            // 超过一批的数据报分多次 sendmmsg 发出；由多个 Buffer 组成的负载被拼接发送
+            vector<BufferList> payloads;
+            for (size_t i = 0; i < UDPSocket::MAX_BATCH + 8; i++) {
+                BufferList payload{"datagram " + to_string(i)};
+                payload.append(BufferList{string(" tail")});
+                payloads.push_back(payload);
+            }
+            sender.send_batch(receiver.local_address(), payloads);
+            test_err_if(sender.write_count() != 2, "40 datagrams should take two sendmmsg calls");
+
+            // 一次最多收下 MAX_BATCH 个，按发送顺序，并带有发送方地址
+            vector<UDPSocket::received_buffer> received;
+            test_err_if(receiver.recv_batch(received, pool) != UDPSocket::MAX_BATCH, "should receive a full batch");
+            test_err_if(receiver.recv_batch(received, pool) != 8, "should receive the rest");
+            test_err_if(receiver.read_count() != 2, "each batch should be one read");
+            for (size_t i = 0; i < received.size(); i++) {
+                const string expected = "datagram " + to_string(UDPSocket::MAX_BATCH + i) + " tail";
+                test_err_if(received[i].payload.copy() != expected, "wrong payload " + to_string(i));
+                test_err_if(received[i].source_address != sender.local_address(), "wrong source address");
+            }
+        }
+
+        {
+            // 超过 mtu 的数据报被丢弃，同一批中的其他数据报不受影响
+            sender.sendto(receiver.local_address(), string(100, 'x'));
+            sender.sendto(receiver.local_address(), string(10, 'y'));
+            vector<UDPSocket::received_buffer> received;
+            test_err_if(receiver.recv_batch(received, pool, 50) != 1, "the oversized datagram should be dropped");
+            test_err_if(received[0].payload.copy() != string(10, 'y'), "the small datagram should be kept");
+        }
+
+        {
+            // GSO：一个负载由内核切成多个数据报；开启 GRO 的接收方可能收到合并后的数据报
+            UDPSocket gro_receiver;
+            gro_receiver.bind(Address{"127.0.0.1", 0});
+            gro_receiver.set_gro(true);
+            string data;
+            for (size_t i = 0; i < 5 * 100 + 40; i++) {
+                data.push_back(char('a' + i % 26));
+            }
+            sender.send_batch(gro_receiver.local_address(), {BufferList{string(data)}}, {100});
+
+            // 无论是否被合并，按 segment_size 切开后应得到原来的 6 个数据报
+            vector<string> datagrams;
+            vector<UDPSocket::received_buffer> received;
+            while (datagrams.size() < 6) {
+                gro_receiver.recv_batch(received, pool);
+                for (const auto &datagram : received) {
+                    const string payload = datagram.payload.copy();
+                    const size_t size = datagram.segment_size > 0 ? datagram.segment_size : payload.size();
+                    for (size_t offset = 0; offset < payload.size(); offset += size) {
+                        datagrams.push_back(payload.substr(offset, size));
+                    }
+                }
+            }
+            test_err_if(datagrams.size() != 6, "GSO should have sent six datagrams");
+            for (size_t i = 0; i < datagrams.size(); i++) {
+                test_err_if(datagrams[i] != data.substr(i * 100, 100), "wrong GSO datagram " + to_string(i));
+            }
+        }
+
+        {
+            // 适配器攒下写出的段，flush 时一起发出；读取时一次收下一批
+            FdAdapterConfig cfg;
+            cfg.source = sender.local_address();
+            cfg.destination = receiver.local_address();
+            TCPOverUDPSocketAdapter out{move(sender)};
+            out.config_mut() = cfg;
+            FdAdapterConfig in_cfg;
+            in_cfg.source = cfg.destination;
+            in_cfg.destination = cfg.source;
+            TCPOverUDPSocketAdapter in{move(receiver)};
+            in.config_mut() = in_cfg;
+
+            const UDPSocket &out_sock = out;
+            const UDPSocket &in_sock = in;
+            const unsigned writes = out_sock.write_count();
+            const unsigned reads = in_sock.read_count();
+            for (size_t i = 0; i < 5; i++) {
+                TCPSegment seg;
+                seg.header().seqno = WrappingInt32{uint32_t(i)};
+                out.write(seg);
+            }
+            test_err_if(out_sock.write_count() != writes, "segments should wait for flush()");
+            out.flush();
+            test_err_if(out_sock.write_count() != writes + 1, "flush() should send the segments with one call");
+
+            for (size_t i = 0; i < 5; i++) {
+                const auto seg = in.read();
+                test_err_if(not seg.has_value() or seg->header().seqno != WrappingInt32{uint32_t(i)},
+                            "segment " + to_string(i) + " should be read in order");
+                test_err_if(in.read_pending() != (i < 4), "the rest of the batch should be pending");
+            }
+            test_err_if(in_sock.read_count() != reads + 1, "the segments should be received with one call");
+        }
+
+        {
+            // 开启 GSO/GRO 的适配器：同样大小的段一起发出，合并收到的数据报被拆回一个个段
+            UDPSocket out_sock;
+            out_sock.bind(Address{"127.0.0.1", 0});
+            UDPSocket in_sock;
+            in_sock.bind(Address{"127.0.0.1", 0});
+            FdAdapterConfig cfg;
+            cfg.source = out_sock.local_address();
+            cfg.destination = in_sock.local_address();
+            cfg.udp_offload = true;
+            TCPOverUDPSocketAdapter out{move(out_sock)};
+            out.config_mut() = cfg;
+            FdAdapterConfig in_cfg = cfg;
+            in_cfg.source = cfg.destination;
+            in_cfg.destination = cfg.source;
+            TCPOverUDPSocketAdapter in{move(in_sock)};
+            in.config_mut() = in_cfg;
+            in.flush();  // 在数据到达前开启 GRO
+
+            const vector<size_t> sizes{500, 500, 500, 200, 300, 300, 20};
+            for (size_t i = 0; i < sizes.size(); i++) {
+                TCPSegment seg;
+                seg.header().seqno = WrappingInt32{uint32_t(i)};
+                seg.payload() = Buffer{string(sizes[i], char('a' + i))};
+                out.write(seg);
+            }
+            out.flush();
+
+            for (size_t i = 0; i < sizes.size(); i++) {
+                const auto seg = in.read();
+                test_err_if(not seg.has_value() or seg->header().seqno != WrappingInt32{uint32_t(i)},
+                            "segment " + to_string(i) + " should be read in order");
+                test_err_if(seg->payload().copy() != string(sizes[i], char('a' + i)),
+                            "segment " + to_string(i) + " has the wrong payload");
+            }
+            test_err_if(in.read_pending(), "every segment should have been read");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}